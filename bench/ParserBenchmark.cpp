@@ -0,0 +1,81 @@
+// Parser microbenchmark: measures QueryParser::parse throughput on a
+// synthetic statement mix. Build with -DENABLE_BENCHMARKS=ON and run
+//   ./bin/lemondb_parser_bench [iterations]
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "query/QueryParser.h"
+
+namespace {
+constexpr size_t kDefaultIterations = 200000;
+
+constexpr std::array<std::string_view, 12> kTemplates = {
+    "INSERT ( k? 1 2 3 4 ) FROM bench",
+    "SELECT ( KEY c0 c1 ) FROM bench WHERE ( c0 > ? ) ( c1 < 100 )",
+    "UPDATE ( c2 ? ) FROM bench WHERE ( KEY = k? )",
+    "DELETE ( ) FROM bench WHERE ( c3 = ? )",
+    "COUNT ( ) FROM bench WHERE ( c0 >= ? )",
+    "SUM ( c0 c1 c2 ) FROM bench WHERE ( c1 <= ? )",
+    "MAX ( c0 c1 ) FROM bench",
+    "ADD ( c0 c1 c2 ) FROM bench WHERE ( c2 != ? )",
+    "SWAP ( c0 c1 ) FROM bench WHERE ( KEY = k? )",
+    "DUPLICATE ( ) FROM bench WHERE ( c0 = ? )",
+    "SELECT ( KEY c0 FROM bench",
+    "FROBNICATE ( c0 ) FROM bench",
+};
+
+std::vector<std::string> makeStatements(size_t count) {
+  std::vector<std::string> statements;
+  statements.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    std::string statement(kTemplates[i % kTemplates.size()]);
+    const auto pos = statement.find('?');
+    if (pos != std::string::npos) {
+      statement.replace(pos, 1, std::to_string(i));
+    }
+    statements.push_back(std::move(statement));
+  }
+  return statements;
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  size_t iterations = kDefaultIterations;
+  if (argc > 1) {
+    iterations = std::strtoull(argv[1], nullptr, 10);  // NOLINT
+  }
+
+  const auto statements = makeStatements(iterations);
+  const QueryParser parser;
+
+  size_t parsed = 0;
+  size_t rejected = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (const auto &statement : statements) {
+    const auto result = parser.parse(statement);
+    if (result.ok()) {
+      ++parsed;
+    } else {
+      ++rejected;
+    }
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  const auto nanos =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  const double perStatement =
+      static_cast<double>(nanos) / static_cast<double>(statements.size());
+  std::cout << "statements: " << statements.size() << " (parsed " << parsed
+            << ", rejected " << rejected << ")\n"
+            << "total: " << static_cast<double>(nanos) / 1e6 << " ms\n"
+            << "per statement: " << perStatement << " ns\n"
+            << "throughput: " << 1e9 / perStatement << " statements/s\n";
+  return 0;
+}
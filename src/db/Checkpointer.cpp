@@ -0,0 +1,493 @@
+#include "Checkpointer.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "Database.h"
+#include "RecordFraming.h"
+#include "Table.h"
+#include "WriteAheadLog.h"
+
+namespace {
+using RecordFraming::getU32;
+using RecordFraming::getU64;
+using RecordFraming::putRecord;
+using RecordFraming::putU32;
+using RecordFraming::putU64;
+
+constexpr std::string_view kMagic = "LCKP";
+/** Also covers Table::blockRows(): block indices depend on it */
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderBytes = 8;
+constexpr size_t kReadBlockBytes = size_t{1} << 20U;
+
+constexpr char kTableRecord = 'T';
+constexpr char kBlockRecord = 'B';
+constexpr char kDropRecord = 'D';
+constexpr char kCommitRecord = 'C';
+
+/** A table as described by the checkpoint file */
+struct TableImage {
+  std::vector<std::string> fields;
+  uint64_t rows = 0;
+  /** Latest block records by block index; views into the file contents */
+  std::map<uint64_t, std::string_view> blocks;
+};
+
+using Images = std::map<std::string, TableImage, std::less<>>;
+
+/** Bounds-checked decoding of a record payload */
+class PayloadReader {
+public:
+  explicit PayloadReader(std::string_view payload) : in(payload) {}
+
+  [[nodiscard]] bool ok() const { return good; }
+
+  char byte() { return need(1) ? in[pos++] : '\0'; }
+
+  uint32_t u32() {
+    if (!need(4)) {
+      return 0;
+    }
+    const uint32_t value = getU32(in, pos);
+    pos += 4;
+    return value;
+  }
+
+  uint64_t u64() {
+    if (!need(8)) {
+      return 0;
+    }
+    const uint64_t value = getU64(in, pos);
+    pos += 8;
+    return value;
+  }
+
+  std::string_view string() {
+    const size_t length = u32();
+    if (!need(length)) {
+      return {};
+    }
+    const auto value = in.substr(pos, length);
+    pos += length;
+    return value;
+  }
+
+private:
+  std::string_view in;
+  size_t pos = 0;
+  bool good = true;
+
+  bool need(size_t bytes) {
+    good = good && in.size() - pos >= bytes;
+    return good;
+  }
+};
+
+void putString(std::string &out, std::string_view value) {
+  putU32(out, static_cast<uint32_t>(value.size()));
+  out.append(value);
+}
+
+uint64_t blockCount(uint64_t rows) {
+  return (rows + Table::blockRows() - 1) / Table::blockRows();
+}
+
+void putTableRecord(std::string &out, std::string_view name, bool whole,
+                    uint64_t rows, const std::vector<std::string> &fields) {
+  std::string payload(1, kTableRecord);
+  putString(payload, name);
+  payload.push_back(whole ? '\1' : '\0');
+  putU64(payload, rows);
+  putU32(payload, static_cast<uint32_t>(fields.size()));
+  for (const auto &field : fields) {
+    putString(payload, field);
+  }
+  putRecord(out, payload);
+}
+
+void putBlockRecord(std::string &out, const Table &table, uint64_t block) {
+  const auto rows = table.blockRowsOf(block);
+  std::string payload(1, kBlockRecord);
+  putString(payload, table.name());
+  putU64(payload, block);
+  putU32(payload, static_cast<uint32_t>(rows.size()));
+  for (const auto &row : rows) {
+    putString(payload, row.keyConstRef());
+    for (const auto value : row.datumConstRef()) {
+      putU32(payload, static_cast<uint32_t>(value));
+    }
+  }
+  putRecord(out, payload);
+}
+
+void putCommitRecord(std::string &out, uint64_t sequence) {
+  std::string payload(1, kCommitRecord);
+  putU64(payload, sequence);
+  putRecord(out, payload);
+}
+
+/** Apply one record of a committed checkpoint; false if it is malformed */
+bool applyRecord(Images &images, std::string_view payload) {
+  PayloadReader reader(payload);
+  const char kind = reader.byte();
+  const auto name = reader.string();
+  if (kind == kTableRecord) {
+    const bool whole = reader.byte() != '\0';
+    const uint64_t rows = reader.u64();
+    const uint32_t fieldCount = reader.u32();
+    std::vector<std::string> fields;
+    for (uint32_t index = 0; index < fieldCount && reader.ok(); ++index) {
+      fields.emplace_back(reader.string());
+    }
+    if (!reader.ok()) [[unlikely]] {
+      return false;
+    }
+    auto &image = images[std::string(name)];
+    if (whole) {
+      image = TableImage{std::move(fields), rows, {}};
+      return true;
+    }
+    image.rows = rows;
+    image.blocks.erase(image.blocks.lower_bound(blockCount(rows)),
+                       image.blocks.end());
+    return true;
+  }
+  if (kind == kBlockRecord) {
+    const uint64_t block = reader.u64();
+    const auto image = images.find(name);
+    if (!reader.ok() || image == images.end()) [[unlikely]] {
+      return false;
+    }
+    image->second.blocks[block] = payload;
+    return true;
+  }
+  if (kind == kDropRecord) {
+    if (const auto image = images.find(name); image != images.end()) {
+      images.erase(image);
+    }
+    return reader.ok();
+  }
+  return false;
+}
+
+/**
+ * Read the committed checkpoints of a file
+ * @param end Set to the end of the last commit record
+ * @return false if the data is not a checkpoint file
+ */
+bool readImages(std::string_view data, Images &images, uint64_t &sequence,
+                size_t &end) {
+  if (data.size() < kHeaderBytes || !data.starts_with(kMagic) ||
+      getU32(data, kMagic.size()) != kVersion) [[unlikely]] {
+    return false;
+  }
+  end = kHeaderBytes;
+  size_t offset = kHeaderBytes;
+  std::vector<std::string_view> uncommitted;
+  while (const auto payload = RecordFraming::getRecord(data, offset)) {
+    if (payload->empty() || payload->front() != kCommitRecord) [[likely]] {
+      uncommitted.push_back(*payload);
+      continue;
+    }
+    PayloadReader reader(*payload);
+    (void)reader.byte();
+    const uint64_t committed = reader.u64();
+    if (!reader.ok()) [[unlikely]] {
+      break;
+    }
+    for (const auto record : uncommitted) {
+      if (!applyRecord(images, record)) [[unlikely]] {
+        return true;  // Malformed despite its CRC: stop before it
+      }
+    }
+    uncommitted.clear();
+    sequence = committed;
+    end = offset;
+  }
+  return true;
+}
+
+/** Build a table from its image */
+Table::Ptr buildTable(const std::string &name, const TableImage &image) {
+  auto table = std::make_unique<Table>(name, image.fields);
+  table->reserve(image.rows);
+  for (const auto &[index, payload] : image.blocks) {
+    if (index * Table::blockRows() != table->size()) [[unlikely]] {
+      break;  // A missing block would shift every later row
+    }
+    PayloadReader reader(payload);
+    (void)reader.byte();
+    (void)reader.string();
+    (void)reader.u64();
+    const uint32_t rows = reader.u32();
+    for (uint32_t row = 0; row < rows && table->size() < image.rows; ++row) {
+      std::string key(reader.string());
+      std::vector<Table::ValueType> values(image.fields.size());
+      for (auto &value : values) {
+        value = static_cast<Table::ValueType>(reader.u32());
+      }
+      if (!reader.ok()) [[unlikely]] {
+        break;
+      }
+      table->insertByIndex(key, std::move(values));
+    }
+  }
+  table->clearDirty();
+  return table;
+}
+
+bool readFile(int file, std::string &contents) {
+  std::vector<char> block(kReadBlockBytes);
+  while (true) {
+    const ssize_t got =
+        ::pread(file, block.data(), block.size(),
+                static_cast<off_t>(contents.size()));
+    if (got < 0 && errno == EINTR) [[unlikely]] {
+      continue;
+    }
+    if (got < 0) [[unlikely]] {
+      return false;
+    }
+    if (got == 0) {
+      return true;
+    }
+    contents.append(block.data(), static_cast<size_t>(got));
+  }
+}
+
+bool writeAll(int file, std::string_view data) {
+  while (!data.empty()) {
+    const ssize_t written = ::write(file, data.data(), data.size());
+    if (written < 0 && errno == EINTR) [[unlikely]] {
+      continue;
+    }
+    if (written < 0) [[unlikely]] {
+      return false;
+    }
+    data.remove_prefix(static_cast<size_t>(written));
+  }
+  return true;
+}
+
+void reportError(const char *what) {
+  std::cerr << "lemondb: error: checkpoint: " << what << ": "
+            << std::system_category().message(errno) << '\n';
+}
+}  // namespace
+
+Checkpointer::~Checkpointer() { close(); }
+
+std::optional<uint64_t> Checkpointer::open(const std::string &path) {
+  constexpr mode_t fileMode = 0644;
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+  const int file = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, fileMode);
+  if (file < 0) [[unlikely]] {
+    return std::nullopt;
+  }
+  std::string contents;
+  if (!readFile(file, contents)) [[unlikely]] {
+    ::close(file);
+    return std::nullopt;
+  }
+
+  if (contents.empty()) {
+    std::string header(kMagic);
+    putU32(header, kVersion);
+    if (!writeAll(file, header)) [[unlikely]] {
+      ::close(file);
+      return std::nullopt;
+    }
+    contents = std::move(header);
+  }
+  Images images;
+  size_t end = 0;
+  if (!readImages(contents, images, sequence, end)) [[unlikely]] {
+    ::close(file);
+    return std::nullopt;
+  }
+  // Cut off a torn checkpoint so that the next one follows the last good one
+  if ((end < contents.size() && ::ftruncate(file, static_cast<off_t>(end)) !=
+                                    0) ||
+      ::lseek(file, static_cast<off_t>(end), SEEK_SET) < 0) [[unlikely]] {
+    ::close(file);
+    return std::nullopt;
+  }
+
+  try {
+    auto &database = Database::getInstance();
+    for (const auto &[name, image] : images) {
+      database.registerTable(buildTable(name, image));
+      known.insert(name);
+    }
+  } catch (const std::exception &exc) {
+    std::cerr << "lemondb: error: checkpoint: " << exc.what() << '\n';
+    ::close(file);
+    return std::nullopt;
+  }
+
+  fd = file;
+  this->path = path;
+  fileBytes = mergedBytes = end;
+  enabled.store(true, std::memory_order_relaxed);
+  return sequence;
+}
+
+std::optional<Checkpointer::Summary> Checkpointer::checkpoint() {
+  if (!isEnabled()) [[unlikely]] {
+    return std::nullopt;
+  }
+  const std::scoped_lock serial(checkpointMutex);
+  auto &wal = WriteAheadLog::getInstance();
+  std::string records;
+  Summary summary;
+  WriteAheadLog::Position cut;
+  {
+    std::unordered_set<std::string> present;
+    Database::getInstance().forEachTable([&](Table &table) {
+      present.insert(table.name());
+      const bool whole =
+          table.isFullyDirty() || !known.contains(table.name());
+      std::vector<Table::SizeType> blocks;
+      if (whole) {
+        for (uint64_t block = 0; block < blockCount(table.size()); ++block) {
+          blocks.push_back(block);
+        }
+      } else {
+        blocks = table.dirtyBlockList();
+        if (blocks.empty()) [[likely]] {
+          return;
+        }
+      }
+      putTableRecord(records, table.name(), whole, table.size(),
+                     table.field());
+      for (const auto block : blocks) {
+        if (block < blockCount(table.size())) {
+          putBlockRecord(records, table, block);
+          ++summary.blocks;
+        }
+      }
+      table.clearDirty();
+      ++summary.tables;
+    });
+    for (const auto &name : known) {
+      if (!present.contains(name)) {
+        std::string payload(1, kDropRecord);
+        putString(payload, name);
+        putRecord(records, payload);
+      }
+    }
+    known = std::move(present);
+    if (wal.isEnabled()) {
+      cut = wal.position();
+      sequence = cut.sequence;
+    }
+  }
+  putCommitRecord(records, sequence);
+  summary.bytes = records.size();
+
+  {
+    const std::scoped_lock fileLock(fileMutex);
+    if (!writeAll(fd, records) || ::fdatasync(fd) != 0) [[unlikely]] {
+      reportError("write");
+      // Drop the torn checkpoint; the next one writes every table whole
+      if (::ftruncate(fd, static_cast<off_t>(fileBytes)) != 0 ||
+          ::lseek(fd, static_cast<off_t>(fileBytes), SEEK_SET) < 0) {
+        reportError("ftruncate");
+      }
+      known.clear();
+      return std::nullopt;
+    }
+    fileBytes += records.size();
+    if (!merging && fileBytes >= kMinMergeBytes &&
+        fileBytes >= mergedBytes * kMergeGrowth) [[unlikely]] {
+      if (merger.joinable()) {
+        merger.join();
+      }
+      merging = true;
+      merger = std::thread(&Checkpointer::merge, this);
+    }
+  }
+
+  if (wal.isEnabled()) {
+    wal.truncate(cut);
+  }
+  return summary;
+}
+
+void Checkpointer::close() {
+  enabled.store(false, std::memory_order_relaxed);
+  if (merger.joinable()) {
+    merger.join();
+  }
+  if (fd >= 0) {
+    ::close(fd);
+    fd = -1;
+  }
+}
+
+void Checkpointer::merge() {
+  // fileMutex is held throughout, so nobody sees merging cleared early
+  const std::scoped_lock fileLock(fileMutex);
+  merging = false;
+
+  std::string contents;
+  if (!readFile(fd, contents)) [[unlikely]] {
+    reportError("read");
+    return;
+  }
+  Images images;
+  uint64_t committed = 0;
+  size_t end = 0;
+  if (!readImages(contents, images, committed, end)) [[unlikely]] {
+    return;
+  }
+
+  std::string merged(kMagic);
+  putU32(merged, kVersion);
+  for (const auto &[name, image] : images) {
+    putTableRecord(merged, name, true, image.rows, image.fields);
+    for (const auto &[index, payload] : image.blocks) {
+      putRecord(merged, payload);
+    }
+  }
+  putCommitRecord(merged, committed);
+
+  // Write the merged file next to the old one and swap them atomically
+  const std::string temporary = path + ".tmp";
+  constexpr mode_t fileMode = 0644;
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+  const int file = ::open(temporary.c_str(),
+                          O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, fileMode);
+  if (file < 0) [[unlikely]] {
+    reportError("open");
+    return;
+  }
+  if (!writeAll(file, merged) || ::fdatasync(file) != 0 ||
+      ::rename(temporary.c_str(), path.c_str()) != 0) [[unlikely]] {
+    reportError("merge");
+    ::close(file);
+    ::unlink(temporary.c_str());
+    return;
+  }
+  ::close(fd);
+  fd = file;
+  fileBytes = mergedBytes = merged.size();
+}
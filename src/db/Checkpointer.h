@@ -0,0 +1,119 @@
+#ifndef PROJECT_CHECKPOINTER_H
+#define PROJECT_CHECKPOINTER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_set>
+
+/**
+ * Checkpointer: incremental checkpoints of the database
+ *
+ * Tables track which blocks of Table::blockRows() rows writers changed
+ * (see Table::markDirty). CHECKPOINT appends only those blocks to the
+ * checkpoint file, so its cost follows the volume of changes, not the size of
+ * the tables; new, loaded and truncated tables are written whole.
+ *
+ * File layout: an 8 byte header ("LCKP", u32 version), then records framed
+ * like the write-ahead log (u32 payload length, u32 CRC-32, payload). The
+ * first payload byte gives the kind of record:
+ *  - 'T' table: name, whole flag, row count, field names. A whole table
+ *    replaces what came before; otherwise blocks past the row count are
+ *    dropped.
+ *  - 'B' block: table name, block index, row count, then each row's key and
+ *    values.
+ *  - 'D' dropped table: name.
+ *  - 'C' commit: the write-ahead log sequence number the checkpoint covers.
+ * The records of a checkpoint only count once its commit record is read, so
+ * a checkpoint torn by a crash is ignored and cut off.
+ *
+ * A checkpoint runs while no query does (CHECKPOINT is a barrier), so the
+ * tables and the end of the write-ahead log agree: every logged writer is in
+ * the checkpoint. The log is then truncated to that position.
+ *
+ * Since blocks are only appended, the file keeps old versions of them. Once
+ * it has grown to kMergeGrowth times its size after the last merge, a
+ * background thread rewrites it with the latest version of every block.
+ */
+class Checkpointer {
+public:
+  static constexpr size_t kMergeGrowth = 2;
+  /** Files smaller than this are never merged */
+  static constexpr uint64_t kMinMergeBytes = uint64_t{4} << 20U;
+
+  /** What a checkpoint wrote */
+  struct Summary {
+    size_t tables = 0;
+    size_t blocks = 0;
+    uint64_t bytes = 0;
+  };
+
+  [[nodiscard]] static Checkpointer &getInstance() {
+    static Checkpointer instance;
+    return instance;
+  }
+
+  Checkpointer(const Checkpointer &) = delete;
+  Checkpointer &operator=(const Checkpointer &) = delete;
+  Checkpointer(Checkpointer &&) = delete;
+  Checkpointer &operator=(Checkpointer &&) = delete;
+  ~Checkpointer();
+
+  /**
+   * Open (or create) the checkpoint file and register its tables in the
+   * database; call before the write-ahead log is replayed
+   * @param path The checkpoint file
+   * @return the write-ahead log sequence number the checkpoint covers, or
+   *         nullopt if the file cannot be opened or is not a checkpoint
+   */
+  [[nodiscard]] std::optional<uint64_t> open(const std::string &path);
+
+  /**
+   * Check whether checkpoints are enabled
+   */
+  [[nodiscard]] bool isEnabled() const {
+    return enabled.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Write the blocks changed since the last checkpoint and truncate the
+   * write-ahead log; no query may run meanwhile
+   * @return what was written, or nullopt if checkpoints are disabled or the
+   *         file could not be written
+   */
+  std::optional<Summary> checkpoint();
+
+  /**
+   * Wait for a running merge and close the file
+   */
+  void close();
+
+private:
+  Checkpointer() = default;
+
+  int fd = -1;
+  std::string path;
+  std::atomic<bool> enabled{false};
+  /** Write-ahead log sequence number of the last checkpoint */
+  uint64_t sequence = 0;
+  /** Tables in the file */
+  std::unordered_set<std::string> known;
+
+  /** Serializes checkpoints */
+  std::mutex checkpointMutex;
+  /** Held while fd is written or replaced; taken after checkpointMutex */
+  std::mutex fileMutex;
+  uint64_t fileBytes = 0;
+  uint64_t mergedBytes = 0;
+  bool merging = false;
+  std::thread merger;
+
+  /** Rewrite the file with the latest version of every block */
+  void merge();
+};
+
+#endif  // PROJECT_CHECKPOINTER_H
@@ -5,16 +5,18 @@
 #include <iostream>
 #include <memory>
 #include <mutex>
-#include <shared_mutex>
 #include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "../threading/EpochManager.h"
+#include "../utils/QueryProfile.h"
 #include "../utils/formatter.h"
 #include "../utils/uexception.h"
 #include "Database.h"
 #include "Table.h"
+#include "TableCodec.h"
 
 std::unique_ptr<Database> Database::instance = nullptr;
 
@@ -27,18 +29,33 @@ void Database::testDuplicate(const std::string &tableName) {
   }
 }
 
+Database::~Database() { delete index.load(); }
+
+void Database::publishIndex() {
+  auto next = std::make_unique<TableIndex>();
+  next->reserve(tables.size());
+  for (const auto &[name, table] : tables) {
+    next->emplace(name, table.get());
+  }
+  std::unique_ptr<const TableIndex> previous(index.exchange(next.release()));
+  EpochManager::getInstance().retire(std::move(previous));
+}
+
 Table &Database::registerTable(Table::Ptr &&table) {
-  const std::unique_lock lock(tablesMutex);
+  const std::scoped_lock lock(tablesMutex);
   auto name = table->name();
   this->testDuplicate(table->name());
   auto result = this->tables.emplace(name, std::move(table));
+  publishIndex();
   return *(result.first->second);
 }
 
 Table &Database::operator[](const std::string &tableName) {
-  const std::shared_lock lock(tablesMutex);
-  auto iterator = this->tables.find(tableName);
-  if (iterator == this->tables.end()) [[unlikely]] {
+  const QueryProfile::StageTimer timer(QueryProfile::Stage::TableLookup);
+  const EpochManager::Guard guard;
+  const auto *current = index.load();
+  auto iterator = current->find(tableName);
+  if (iterator == current->end()) [[unlikely]] {
     throw TableNameNotFound("Error accesing table \"" + tableName +
                             "\". Table not found.");
   }
@@ -46,9 +63,11 @@ Table &Database::operator[](const std::string &tableName) {
 }
 
 const Table &Database::operator[](const std::string &tableName) const {
-  const std::shared_lock lock(tablesMutex);
-  auto iterator = this->tables.find(tableName);
-  if (iterator == this->tables.end()) [[unlikely]] {
+  const QueryProfile::StageTimer timer(QueryProfile::Stage::TableLookup);
+  const EpochManager::Guard guard;
+  const auto *current = index.load();
+  auto iterator = current->find(tableName);
+  if (iterator == current->end()) [[unlikely]] {
     throw TableNameNotFound("Error accesing table \"" + tableName +
                             "\". Table not found.");
   }
@@ -56,31 +75,35 @@ const Table &Database::operator[](const std::string &tableName) const {
 }
 
 void Database::dropTable(const std::string &tableName) {
-  const std::unique_lock lock(tablesMutex);
+  const std::scoped_lock lock(tablesMutex);
   auto iterator = this->tables.find(tableName);
   if (iterator == this->tables.end()) [[unlikely]] {
     throw TableNameNotFound("Error when trying to drop table \"" + tableName +
                             "\". Table not found.");
   }
+  auto table = std::move(iterator->second);
   this->tables.erase(iterator);
+  publishIndex();
+  const size_t bytes = table->storageBytes();
+  EpochManager::getInstance().retire(std::move(table), bytes);
 }
 
-void Database::printAllTable() {
-  const std::shared_lock lock(tablesMutex);
+void Database::printAllTable(std::ostream &out) {
+  const std::scoped_lock lock(tablesMutex);
   const int width = 15;
-  std::cout << "Database overview:" << '\n';
-  std::cout << "=========================" << '\n';
-  std::cout << std::setw(width) << "Table name";
-  std::cout << std::setw(width) << "# of fields";
-  std::cout << std::setw(width) << "# of entries" << '\n';
+  out << "Database overview:" << '\n';
+  out << "=========================" << '\n';
+  out << std::setw(width) << "Table name";
+  out << std::setw(width) << "# of fields";
+  out << std::setw(width) << "# of entries" << '\n';
   for (const auto &table : this->tables) [[likely]]
   {
-    std::cout << std::setw(width) << table.first;
-    std::cout << std::setw(width) << (*table.second).field().size() + 1;
-    std::cout << std::setw(width) << (*table.second).size() << '\n';
+    out << std::setw(width) << table.first;
+    out << std::setw(width) << (*table.second).field().size() + 1;
+    out << std::setw(width) << (*table.second).size() << '\n';
   }
-  std::cout << "Total " << this->tables.size() << " tables." << '\n';
-  std::cout << "=========================" << '\n';
+  out << "Total " << this->tables.size() << " tables." << '\n';
+  out << "=========================" << '\n';
 }
 
 Database &Database::getInstance() {
@@ -100,12 +123,16 @@ std::string Database::getFileTableName(const std::string &fileName) {
   const std::unique_lock lock(fileTableNameMutex);
   auto iterator = fileTableNameMap.find(fileName);
   if (iterator == fileTableNameMap.end()) [[unlikely]] {
-    std::ifstream infile(fileName);
+    std::ifstream infile(fileName, std::ios::binary);
     if (!infile.is_open()) [[unlikely]] {
       return "";
     }
     std::string tableName;
-    infile >> tableName;
+    if (TableCodec::isCompressed(infile)) {
+      tableName = TableCodec::readTableName(infile);
+    } else {
+      infile >> tableName;
+    }
     infile.close();
     fileTableNameMap.emplace(fileName, tableName);
     return tableName;
@@ -115,7 +142,13 @@ std::string Database::getFileTableName(const std::string &fileName) {
 
 Table &Database::loadTableFromStream(std::istream &input_stream,
                                      const std::string &source) {
-  auto &database = Database::getInstance();
+  return Database::getInstance().registerTable(
+      readTableFromStream(input_stream, source));
+}
+
+Table::Ptr Database::readTableFromStream(std::istream &input_stream,
+                                         const std::string &source,
+                                         bool checkDuplicate) {
   const std::string errString =
       !source.empty() ? R"(Invalid table (from "?") format: )"_f % source
                       : "Invalid table format: ";
@@ -142,9 +175,11 @@ Table &Database::loadTableFromStream(std::istream &input_stream,
                                   "Failed to parse table metadata.");
   }
 
-  std::unique_lock lock(database.tablesMutex);
-  database.testDuplicate(tableName);
-  lock.unlock();  // Explicitly unlock before potentially expensive file I/O
+  if (checkDuplicate) {
+    auto &database = Database::getInstance();
+    const std::scoped_lock lock(database.tablesMutex);
+    database.testDuplicate(tableName);
+  }
 
   if (!(std::getline(input_stream, line))) [[unlikely]] {
     throw LoadFromStreamException(errString + "Failed to load field names.");
@@ -214,6 +249,24 @@ Table &Database::loadTableFromStream(std::istream &input_stream,
   // Batch insert all rows at once (with duplicate checking)
   table->insertBatch(std::move(batchData));
 
+  return table;
+}
+
+Table &Database::loadTableFromCompressedStream(std::istream &input_stream,
+                                               const std::string &source) {
+  auto &database = Database::getInstance();
+
+  // Reject duplicated names before decoding the whole file
+  const auto start = input_stream.tellg();
+  const std::string tableName = TableCodec::readTableName(input_stream);
+  input_stream.clear();
+  input_stream.seekg(start);
+  if (!tableName.empty()) [[likely]] {
+    const std::scoped_lock lock(database.tablesMutex);
+    database.testDuplicate(tableName);
+  }
+
+  auto table = TableCodec::decode(input_stream, source);
   return database.registerTable(std::move(table));
 }
 
@@ -5,8 +5,10 @@
 #ifndef PROJECT_DB_H
 #define PROJECT_DB_H
 
+#include <atomic>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <shared_mutex>
 #include <string>
 #include <unordered_map>
@@ -26,9 +28,22 @@ private:
   std::unordered_map<std::string, Table::Ptr> tables;
 
   /**
-   * Mutex to protect the tables map
+   * Mutex to protect the tables map; only taken to change it
    */
-  mutable std::shared_mutex tablesMutex;
+  mutable std::mutex tablesMutex;
+
+  using TableIndex = std::unordered_map<std::string, Table *>;
+
+  /**
+   * Immutable copy of the tables map that lookups read inside an epoch
+   * guard; replaced, and the old one retired, whenever the map changes
+   */
+  std::atomic<const TableIndex *> index{new TableIndex};
+
+  /**
+   * Publish a new index of the tables map (tablesMutex must be held)
+   */
+  void publishIndex();
 
   /**
    * Mutex to protect the fileTableNameMap
@@ -64,18 +79,35 @@ public:
   Table &registerTable(Table::Ptr &&table);
 
   /**
-   * Drop a table from the database
+   * Drop a table from the database; it is destroyed once no thread can
+   * still be using it (see operator[])
    * @param tableName The name of the table to drop
    */
   void dropTable(const std::string &tableName);
 
+  /**
+   * Call a function on every table
+   * @param function Called with each table while the table map is locked
+   */
+  template <class Function> void forEachTable(Function &&function) {
+    const std::scoped_lock lock(tablesMutex);
+    for (auto &entry : tables) {
+      function(*entry.second);
+    }
+  }
+
   /**
    * Print information about all tables
+   * @param out The stream printed to
    */
-  void printAllTable();
+  void printAllTable(std::ostream &out);
 
   /**
    * Access a table by name (non-const)
+   * Wait-free: reads the published index inside an epoch guard. A dropped
+   * table is destroyed only after every thread that was inside a guard when
+   * it was dropped has left it, so the reference stays valid for the rest of
+   * the caller's guard (queries run inside one)
    * @param tableName The name of the table to access
    */
   [[nodiscard]] Table &operator[](const std::string &tableName);
@@ -94,7 +126,7 @@ public:
 
   Database(Database &&) = delete;
 
-  ~Database() = default;
+  ~Database();
 
   /**
    * Get the singleton instance of the database
@@ -125,6 +157,27 @@ public:
   static Table &loadTableFromStream(std::istream &input_stream,
                                     const std::string &source = "");
 
+  /**
+   * Read a table from an input stream without registering it
+   * @param input_stream The stream to read from
+   * @param source Optional source description
+   * @param checkDuplicate Reject a name that is already registered as soon
+   * as the header is read
+   * @return the table
+   */
+  static Table::Ptr readTableFromStream(std::istream &input_stream,
+                                        const std::string &source = "",
+                                        bool checkDuplicate = true);
+
+  /**
+   * Load a table from a compressed (LTC) input stream
+   * @param input_stream The binary stream to read from
+   * @param source Optional source description
+   * @return reference of loaded table
+   */
+  static Table &loadTableFromCompressedStream(std::istream &input_stream,
+                                              const std::string &source = "");
+
   /**
    * Signal that QUIT has been called and no more queries should be read
    */
@@ -0,0 +1,172 @@
+#include "LoadPrefetcher.h"
+
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "../threading/Threadpool.h"
+#include "../utils/Tracer.h"
+#include "Database.h"
+#include "Table.h"
+#include "TableCodec.h"
+
+LoadPrefetcher::~LoadPrefetcher() { shutdown(); }
+
+void LoadPrefetcher::prefetch(const std::string &fileName) {
+  if (!ThreadPool::isInitialized()) [[unlikely]] {
+    return;
+  }
+
+  std::error_code error;
+  const auto bytes =
+      static_cast<size_t>(std::filesystem::file_size(fileName, error));
+  if (error) [[unlikely]] {
+    return;
+  }
+  const auto modified = std::filesystem::last_write_time(fileName, error);
+  if (error) [[unlikely]] {
+    return;
+  }
+
+  const std::scoped_lock lock(mutex);
+  if (stopping || excluded.contains(fileName) || staged.contains(fileName) ||
+      chargedBytes + bytes > budgetBytes) {
+    return;
+  }
+  auto entry = std::make_shared<Entry>();
+  entry->bytes = bytes;
+  entry->charged = bytes;
+  entry->modified = modified;
+  staged.emplace(fileName, std::move(entry));
+  chargedBytes += bytes;
+  queue.push_back(fileName);
+
+  if (loaders.size() < kMaxLoaderThreads) {
+    loaders.emplace_back(&LoadPrefetcher::loaderLoop, this);
+  }
+  changed.notify_all();
+}
+
+void LoadPrefetcher::exclude(const std::string &fileName) {
+  const std::scoped_lock lock(mutex);
+  excluded.insert(fileName);
+}
+
+Table::Ptr LoadPrefetcher::take(const std::string &fileName) {
+  std::unique_lock lock(mutex);
+  const auto iter = staged.find(fileName);
+  if (iter == staged.end()) [[unlikely]] {
+    return nullptr;
+  }
+  const auto entry = iter->second;
+  if (entry->state == State::Loading) {
+    changed.wait(lock, [this, &entry] {
+      return entry->state == State::Done || stopping;
+    });
+  }
+
+  // A queued entry is dropped: reading the file now is faster than waiting
+  // for a loader to get to it
+  const auto current = staged.find(fileName);
+  if (current != staged.end() && current->second == entry) [[likely]] {
+    staged.erase(current);
+    chargedBytes -= entry->charged;
+  }
+  Table::Ptr table =
+      entry->state == State::Done ? std::move(entry->table) : nullptr;
+  lock.unlock();
+  if (table == nullptr) [[unlikely]] {
+    return nullptr;
+  }
+
+  // The staged table is only valid if the file is still what was read
+  std::error_code error;
+  const auto bytes = std::filesystem::file_size(fileName, error);
+  if (error || bytes != entry->bytes) [[unlikely]] {
+    return nullptr;
+  }
+  if (std::filesystem::last_write_time(fileName, error) != entry->modified ||
+      error) [[unlikely]] {
+    return nullptr;
+  }
+  return table;
+}
+
+void LoadPrefetcher::shutdown() {
+  {
+    const std::scoped_lock lock(mutex);
+    stopping = true;
+    queue.clear();
+  }
+  changed.notify_all();
+  for (auto &loader : loaders) {
+    if (loader.joinable()) {
+      loader.join();
+    }
+  }
+
+  const std::scoped_lock lock(mutex);
+  loaders.clear();
+  staged.clear();
+  chargedBytes = 0;
+}
+
+void LoadPrefetcher::loaderLoop() {
+  std::unique_lock lock(mutex);
+  while (true) {
+    changed.wait(lock, [this] { return stopping || !queue.empty(); });
+    if (stopping) {
+      return;
+    }
+    const std::string fileName = std::move(queue.front());
+    queue.pop_front();
+    const auto iter = staged.find(fileName);
+    if (iter == staged.end() || iter->second->state != State::Queued) {
+      continue;  // Claimed before it was started
+    }
+    const auto entry = iter->second;
+    entry->state = State::Loading;
+    lock.unlock();
+
+    Table::Ptr table;
+    try {
+      table = readFile(fileName);
+    } catch (const std::exception & /*ignored*/) {
+      // The LOAD query reports the error when it reads the file itself
+    }
+
+    lock.lock();
+    if (table != nullptr) [[likely]] {
+      const size_t tableBytes =
+          Table::estimateBytes(table->size(), table->field().size());
+      chargedBytes -= entry->charged;
+      entry->charged = 0;
+      if (chargedBytes + tableBytes <= budgetBytes) [[likely]] {
+        chargedBytes += tableBytes;
+        entry->charged = tableBytes;
+      } else {
+        table = nullptr;  // The LOAD query reads the file itself
+      }
+    }
+    entry->table = std::move(table);
+    entry->state = State::Done;
+    changed.notify_all();
+  }
+}
+
+Table::Ptr LoadPrefetcher::readFile(const std::string &fileName) {
+  const Tracer::Span span("Read file", fileName);
+  std::ifstream infile(fileName, std::ios::binary);
+  if (!infile.is_open()) [[unlikely]] {
+    return nullptr;
+  }
+  if (TableCodec::isCompressed(infile)) {
+    return TableCodec::decode(infile, fileName);
+  }
+  return Database::readTableFromStream(infile, fileName, false);
+}
@@ -0,0 +1,108 @@
+#ifndef PROJECT_LOAD_PREFETCHER_H
+#define PROJECT_LOAD_PREFETCHER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Table.h"
+
+/**
+ * LoadPrefetcher: speculative background loading of LOAD files
+ *
+ * When a LOAD statement is parsed, its file is queued here and read into a
+ * staged (unregistered) table by a loader thread, while the LOAD query waits
+ * for its turn in the table queue. When the query executes it takes the
+ * staged table and registers it in one step, falling back to reading the file
+ * itself whenever the prefetch is unusable (not started yet, failed, or the
+ * file changed since it was read).
+ *
+ * Staged tables are charged against a memory budget: a file is first charged
+ * its size, a lower bound of its table's, and once read its table's
+ * estimated size (see Table::estimateBytes), which for a compressed file is
+ * many times larger. Files beyond the budget are not prefetched, and a table
+ * that turns out not to fit is dropped. Files written by DUMP in this session
+ * are excluded, since their content depends on query order.
+ *
+ * Loader threads are dedicated (not ThreadPool workers) because decoding a
+ * compressed table itself waits on ThreadPool tasks.
+ */
+class LoadPrefetcher {
+public:
+  static constexpr size_t kDefaultBudgetBytes = size_t{512} << 20U;
+  static constexpr size_t kMaxLoaderThreads = 4;
+
+  [[nodiscard]] static LoadPrefetcher &getInstance() {
+    static LoadPrefetcher instance;
+    return instance;
+  }
+
+  LoadPrefetcher(const LoadPrefetcher &) = delete;
+  LoadPrefetcher &operator=(const LoadPrefetcher &) = delete;
+  LoadPrefetcher(LoadPrefetcher &&) = delete;
+  LoadPrefetcher &operator=(LoadPrefetcher &&) = delete;
+  ~LoadPrefetcher();
+
+  /**
+   * Start loading a file in the background if it fits the budget. Only done
+   * when the ThreadPool is running, i.e. outside small workloads.
+   * @param fileName The file named by a LOAD statement
+   */
+  void prefetch(const std::string &fileName);
+
+  /**
+   * Never prefetch a file again (it is written by this session)
+   * @param fileName The file named by a DUMP statement
+   */
+  void exclude(const std::string &fileName);
+
+  /**
+   * Claim the staged table of a file, waiting for a load in progress
+   * @param fileName The file being loaded
+   * @return the table, or nullptr if the caller must read the file itself
+   */
+  [[nodiscard]] Table::Ptr take(const std::string &fileName);
+
+  /**
+   * Stop the loader threads and drop all staged tables
+   */
+  void shutdown();
+
+private:
+  LoadPrefetcher() = default;
+
+  enum class State { Queued, Loading, Done };
+
+  struct Entry {
+    State state = State::Queued;
+    /** Size of the file when it was queued */
+    size_t bytes = 0;
+    /** Bytes charged against the budget */
+    size_t charged = 0;
+    std::filesystem::file_time_type modified;
+    Table::Ptr table;
+  };
+
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::unordered_map<std::string, std::shared_ptr<Entry>> staged;
+  std::unordered_set<std::string> excluded;
+  std::deque<std::string> queue;
+  std::vector<std::thread> loaders;
+  size_t budgetBytes = kDefaultBudgetBytes;
+  size_t chargedBytes = 0;
+  bool stopping = false;
+
+  void loaderLoop();
+  static Table::Ptr readFile(const std::string &fileName);
+};
+
+#endif  // PROJECT_LOAD_PREFETCHER_H
@@ -2,17 +2,27 @@
 #define PROJECT_QUERY_BASE_H
 
 #include <memory>
+#include <span>
 #include <string>
+#include <string_view>
+#include <typeinfo>
 #include <utility>
+#include <vector>
 
 #include "../query/QueryResult.h"
 
+class Table;
+
 class Query {
   // private:
   //   int id = -1;
 
 private:
   std::string targetTable;
+  /** Statement text of a writer, kept for the write-ahead log */
+  std::string statement;
+  /** Keyword the statement starts with, set by the parser */
+  std::string_view keywordName;
 
 public:
   Query() = default;
@@ -44,12 +54,82 @@ public:
   Query(Query &&) = default;
   Query &operator=(Query &&) = default;
 
+  /**
+   * Keep the statement text this query was parsed from (only done for
+   * writers while the write-ahead log is enabled)
+   * @param text The statement without its terminating ';'
+   */
+  void setStatement(std::string text) { statement = std::move(text); }
+
+  /** The statement text, empty unless setStatement was called */
+  [[nodiscard]] const std::string &statementRef() const { return statement; }
+
+  /**
+   * Keep the keyword of the statement this query was parsed from
+   * @param keyword The keyword, which must outlive the query
+   */
+  void setKeyword(std::string_view keyword) { keywordName = keyword; }
+
+  /** The keyword (e.g. "SELECT"), empty if the query was not parsed */
+  [[nodiscard]] std::string_view keyword() const { return keywordName; }
+
   // For thread safety: indicate if this query modifies data
   [[nodiscard]] virtual bool isWriter() const { return false; }
 
+  // For thread safety: indicate if this query, a writer, changes at most a
+  // couple of rows (by KEY, or by appending), so it copies few of the blocks
+  // it shares with a snapshot
+  [[nodiscard]] virtual bool isPointWriter() const { return false; }
+
+  // For execution order: indicate if consecutive queries on the same table
+  // can run together through executeBatch (INSERT, and reads that scan)
+  [[nodiscard]] virtual bool isBatchable() const { return false; }
+
+  /**
+   * Check whether a query queued right behind this batchable one can join
+   * its batch; by default it must be of the same type
+   * @param other The query behind
+   */
+  [[nodiscard]] virtual bool batchesWith(const Query &other) const {
+    return other.isBatchable() && typeid(other) == typeid(*this);
+  }
+
+  /**
+   * Execute a run of consecutive queries on this query's table that batch
+   * with it, this one first; the default executes them one by one
+   * @param batch The queries, in submission order
+   * @return one result per query, in the same order
+   */
+  virtual std::vector<QueryResult::Ptr> executeBatch(std::span<Query *> batch) {
+    std::vector<QueryResult::Ptr> results;
+    results.reserve(batch.size());
+    for (auto *query : batch) {
+      results.push_back(query->execute());
+    }
+    return results;
+  }
+
   // For execution order: indicate if this query must execute immediately (not
   // parallel) e.g., LOAD and QUIT must execute serially
   [[nodiscard]] virtual bool isInstant() const { return false; }
+
+  // For execution order: indicate if this query must run alone, after every
+  // query submitted before it and before any submitted after it (CHECKPOINT)
+  [[nodiscard]] virtual bool isBarrier() const { return false; }
+
+  // For execution order: indicate if this query only reads its target table
+  // and can run on a snapshot of it (see pinSnapshot) while the queries after
+  // it go on
+  [[nodiscard]] virtual bool readsSnapshot() const { return false; }
+
+  /**
+   * Read this snapshot of the target table instead of locking the table
+   * (only called if readsSnapshot() is true)
+   * @param snapshot The table as of the query's place in the table's order
+   */
+  virtual void pinSnapshot(std::shared_ptr<const Table> snapshot) {
+    (void)snapshot;
+  }
 };
 
 #endif
\ No newline at end of file
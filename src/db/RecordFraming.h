@@ -0,0 +1,101 @@
+#ifndef PROJECT_RECORD_FRAMING_H
+#define PROJECT_RECORD_FRAMING_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * Little endian integers and CRC-checked records, shared by the write-ahead
+ * log and the checkpoint file.
+ *
+ * A record is a u32 payload length, the u32 CRC-32 of the payload and the
+ * payload.
+ */
+namespace RecordFraming {
+constexpr size_t kRecordHeaderBytes = 8;
+
+constexpr auto kCrcTable = [] {
+  constexpr uint32_t polynomial = 0xEDB88320U;
+  std::array<uint32_t, 256> table{};
+  for (uint32_t index = 0; index < table.size(); ++index) {
+    uint32_t value = index;
+    for (int bit = 0; bit < 8; ++bit) {
+      value = (value & 1U) != 0 ? (value >> 1U) ^ polynomial : value >> 1U;
+    }
+    table[index] = value;
+  }
+  return table;
+}();
+
+inline uint32_t crc32(std::string_view data) {
+  uint32_t crc = 0xFFFFFFFFU;
+  for (const char byte : data) {
+    crc = kCrcTable[(crc ^ static_cast<unsigned char>(byte)) & 0xFFU] ^
+          (crc >> 8U);
+  }
+  return ~crc;
+}
+
+inline void putU32(std::string &out, uint32_t value) {
+  for (unsigned shift = 0; shift < 32; shift += 8) {
+    out.push_back(static_cast<char>((value >> shift) & 0xFFU));
+  }
+}
+
+inline void putU64(std::string &out, uint64_t value) {
+  for (unsigned shift = 0; shift < 64; shift += 8) {
+    out.push_back(static_cast<char>((value >> shift) & 0xFFU));
+  }
+}
+
+inline uint32_t getU32(std::string_view in, size_t offset) {
+  uint32_t value = 0;
+  for (unsigned index = 0; index < 4; ++index) {
+    const auto byte = static_cast<unsigned char>(in[offset + index]);
+    value |= static_cast<uint32_t>(byte) << (index * 8);
+  }
+  return value;
+}
+
+inline uint64_t getU64(std::string_view in, size_t offset) {
+  return getU32(in, offset) |
+         (static_cast<uint64_t>(getU32(in, offset + 4)) << 32U);
+}
+
+/** Append a framed record */
+inline void putRecord(std::string &out, std::string_view payload) {
+  putU32(out, static_cast<uint32_t>(payload.size()));
+  putU32(out, crc32(payload));
+  out.append(payload);
+}
+
+/**
+ * Read the framed record at an offset
+ * @param in The data
+ * @param offset Start of the record; moved past it on success
+ * @return the payload, or nullopt if the record is torn or corrupt
+ */
+inline std::optional<std::string_view> getRecord(std::string_view in,
+                                                 size_t &offset) {
+  if (in.size() - offset < kRecordHeaderBytes) {
+    return std::nullopt;
+  }
+  const size_t length = getU32(in, offset);
+  const uint32_t checksum = getU32(in, offset + 4);
+  if (in.size() - offset - kRecordHeaderBytes < length) {
+    return std::nullopt;
+  }
+  const auto payload = in.substr(offset + kRecordHeaderBytes, length);
+  if (crc32(payload) != checksum) [[unlikely]] {
+    return std::nullopt;
+  }
+  offset += kRecordHeaderBytes + length;
+  return payload;
+}
+}  // namespace RecordFraming
+
+#endif  // PROJECT_RECORD_FRAMING_H
@@ -5,9 +5,20 @@
 #include "Table.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
 #include <iomanip>
+#include <initializer_list>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -29,26 +40,78 @@ Table::getFieldIndex(const Table::FieldNameType &field) const {
   }
 }
 
+std::optional<Table::FieldIndex>
+Table::findFieldIndex(const Table::FieldNameType &field) const {
+  const auto iter = this->fieldMap.find(field);
+  if (iter == this->fieldMap.end()) [[unlikely]] {
+    return std::nullopt;
+  }
+  return iter->second;
+}
+
+uint64_t Table::nextGeneration() {
+  static std::atomic<uint64_t> counter{0};
+  return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+std::shared_ptr<const Table> Table::snapshot() const {
+  auto copy = std::make_shared<Table>(tableName, *this);
+  copy->generation = generation;
+  // Without a key index: sharing it would make the next insert or delete
+  // copy all of it, while snapshots rarely look keys up
+  copy->keyMap = nullptr;
+  const std::scoped_lock lock(statsMutex);
+  copy->stats = stats;
+  return copy;
+}
+
+void Table::analyze() const {
+  auto fresh = TableStatistics::build(*this);
+  const std::scoped_lock lock(statsMutex);
+  stats = std::move(fresh);
+}
+
+std::shared_ptr<const TableStatistics> Table::statistics() const {
+  std::shared_ptr<const TableStatistics> current;
+  {
+    const std::scoped_lock lock(statsMutex);
+    current = stats;
+  }
+  if (current == nullptr || !current->isStale(blocks.size())) [[likely]] {
+    return current;
+  }
+  // One reader refreshes them; the others go on with the stale ones, whose
+  // zone map still only trusts unchanged blocks
+  if (statsRefreshing.exchange(true, std::memory_order_acquire)) {
+    return current;
+  }
+  analyze();
+  statsRefreshing.store(false, std::memory_order_release);
+  const std::scoped_lock lock(statsMutex);
+  return stats;
+}
+
 bool Table::evalDuplicateCopy(Table::KeyType key) {
   key = key.append("_copy");
-  return this->keyMap.contains(key);
+  return this->keyMap->contains(key);
 }
 
 void Table::duplicateKeyData(const Table::KeyType &key) {
   Table::KeyType copyKey(key);
   copyKey.append("_copy");
-  std::vector<ValueType> copyData = ((*this)[key])->it->datumRef();
+  std::vector<ValueType> copyData = ((*this)[key])->datumAccess();
   this->insertByIndex(copyKey, std::move(copyData));
 }
 
 void Table::insertByIndex(const KeyType &key, std::vector<ValueType> &&data) {
-  if (this->keyMap.contains(key)) [[unlikely]] {
-    const std::string err = "In Table \"" + this->tableName + "\" : Key \"" +
-                            key + "\" already exists!";
-    throw ConflictingKey(err);
+  if (this->keyMap->contains(key)) [[unlikely]] {
+    throw ConflictingKey(keyExistsMessage(key));
+  }
+  ownKeyMap().emplace(key, rowCount);
+  appendRow(Datum(key, std::move(data)));
+  if (!allDirty) [[unlikely]] {
+    markRowDirty(rowCount - 1);
   }
-  this->keyMap.emplace(key, this->data.size());
-  this->data.emplace_back(key, std::move(data));
 }
 
 void Table::insertBatch(
@@ -56,10 +119,8 @@ void Table::insertBatch(
   auto localBatch = std::move(batch);
   // First, check for conflicts with existing keys and within the batch
   for (const auto &[key, unused] : localBatch) [[likely]] {
-    if (this->keyMap.contains(key)) [[unlikely]] {
-      const std::string err = "In Table \"" + this->tableName + "\" : Key \"" +
-                              key + "\" already exists!";
-      throw ConflictingKey(err);
+    if (this->keyMap->contains(key)) [[unlikely]] {
+      throw ConflictingKey(keyExistsMessage(key));
     }
   }
 
@@ -74,51 +135,441 @@ void Table::insertBatch(
   }
 
   // All keys are unique, now insert them
-  const size_t startIndex = this->data.size();
+  const size_t startIndex = rowCount;
+  auto &keys = ownKeyMap();
   for (size_t i = 0; i < localBatch.size(); ++i) [[likely]]
   {
-    const auto &[key, data] = localBatch[i];
-    this->keyMap.emplace(key, startIndex + i);
-    this->data.emplace_back(key, std::move(localBatch[i].second));
+    auto &[key, data] = localBatch[i];
+    keys.emplace(key, startIndex + i);
+    appendRow(Datum(std::move(key), std::move(data)));
+  }
+  if (!allDirty && !localBatch.empty()) [[unlikely]] {
+    for (size_t row = startIndex; row < rowCount; row += blockRows()) {
+      markRowDirty(row);
+    }
+    markRowDirty(rowCount - 1);
   }
 }
 
-void Table::deleteByIndex(const KeyType &key) {
-  // the key to delete
-  auto iterator = this->keyMap.find(key);
+std::vector<bool> Table::tryInsertBatch(
+    std::vector<std::pair<KeyType, std::vector<ValueType>>> &&batch) {
+  auto localBatch = std::move(batch);
+  std::vector<bool> inserted(localBatch.size(), false);
+  const size_t startIndex = rowCount;
+  auto &keys = ownKeyMap();
+  for (size_t i = 0; i < localBatch.size(); ++i) [[likely]]
+  {
+    auto &[key, data] = localBatch[i];
+    if (!keys.try_emplace(key, rowCount).second) [[unlikely]] {
+      continue;
+    }
+    inserted[i] = true;
+    appendRow(Datum(std::move(key), std::move(data)));
+  }
+  if (!allDirty && rowCount != startIndex) [[unlikely]] {
+    for (size_t row = startIndex; row < rowCount; row += blockRows()) {
+      markRowDirty(row);
+    }
+    markRowDirty(rowCount - 1);
+  }
+  return inserted;
+}
 
+void Table::deleteByIndex(const KeyType &key) {
   // the key doesn't exist
-  if (iterator == this->keyMap.end()) [[unlikely]] {
+  const auto found = keyMap->find(key);
+  if (found == keyMap->end()) [[unlikely]] {
     const std::string err = "In Table \"" + this->tableName + "\" : Key \"" +
                             key + "\" doesn't exist!";
     throw NotFoundKey(err);
   }
+  removeRow(found->second, nullptr);
+}
 
-  // the index of the key to delete
-  const SizeType index = iterator->second;
-  keyMap.erase(iterator);
+void Table::removeRow(SizeType index, DeletedRows *deleted) {
+  auto &keys = ownKeyMap();
+  const auto iterator = keys.find(rowRef(index).keyConstRef());
+  if (viewSet.isFollowing()) [[unlikely]] {
+    viewSet.beforeRemove(*this, std::span(&index, 1));
+  }
+  if (deleted != nullptr) {
+    deleted->keys.push_back(keys.extract(iterator));
+  } else {
+    keys.erase(iterator);
+  }
 
   // swap the current data to the last one and pop back
-  if (index != this->data.size() - 1) [[likely]] {
-    Datum &lastDatum = this->data.back();
-    // Save the key before moving
-    const KeyType lastKey = lastDatum.keyConstRef();
-    this->data[index] = std::move(lastDatum);
-    this->keyMap[lastKey] = index;
+  const SizeType last = rowCount - 1;
+  for (const SizeType block : {index / blockRows(), last / blockRows()}) {
+    if (!ownsAlone(blocks[block])) [[unlikely]] {
+      ownBlock(block);
+    }
+    if (stats != nullptr) [[unlikely]] {
+      stats->touch(block);
+    }
+  }
+  if (index != last) [[likely]] {
+    Datum &lastDatum = rowRef(last);
+    keys[lastDatum.keyConstRef()] = index;
+    rowRef(index) = std::move(lastDatum);
+  }
+  if (!allDirty) [[unlikely]] {
+    markRowDirty(index);
+    markRowDirty(last);
+  }
+  blocks.back()->pop_back();
+  if (blocks.back()->empty()) {
+    blocks.pop_back();
+  }
+  --rowCount;
+}
+
+namespace {
+/**
+ * Run a task for each index, on the thread pool if there is more than one
+ * @param count Number of indices
+ * @param task Called with each index in [0, count)
+ */
+void forEachIndex(size_t count, const std::function<void(size_t)> &task) {
+  if (count <= 1 || !ThreadPool::isInitialized() ||
+      ThreadPool::getInstance().getThreadCount() <= 1) {
+    for (size_t index = 0; index < count; ++index) {
+      task(index);
+    }
+    return;
+  }
+  const ThreadPool &pool = ThreadPool::getInstance();
+  std::vector<std::future<void>> futures;
+  futures.reserve(count);
+  for (size_t index = 0; index < count; ++index) {
+    futures.push_back(pool.submit([&task, index]() { task(index); }));
+  }
+  for (auto &future : futures) {
+    future.get();
   }
-  data.pop_back();
+}
+}  // namespace
+
+Table::SizeType
+Table::deleteWhere(const std::function<bool(const ConstObject &)> &matches,
+                   DeletedRows *deleted) {
+  const SizeType blockCount = blocks.size();
+
+  // Test the rows and count the survivors of each block
+  std::vector<std::vector<char>> survives(blockCount);
+  std::vector<SizeType> offsets(blockCount + 1, 0);
+  forEachIndex(blockCount, [&](size_t block) {
+    const Table *self = this;
+    const SizeType first = block * blockRows();
+    auto &flags = survives[block];
+    flags.resize(blocks[block]->size());
+    for (SizeType row = 0; row < flags.size(); ++row) {
+      flags[row] = matches(ConstObject(first + row, self)) ? 0 : 1;
+      offsets[block + 1] += static_cast<SizeType>(flags[row]);
+    }
+  });
+  for (SizeType block = 0; block < blockCount; ++block) {
+    offsets[block + 1] += offsets[block];
+  }
+  const SizeType survivors = offsets[blockCount];
+  const SizeType removed = rowCount - survivors;
+  if (removed == 0) [[unlikely]] {
+    return 0;
+  }
+
+  if (removed < compactAfterRows()) [[likely]] {
+    // Each row is swapped with the last one, from the highest index down:
+    // the row moved into a hole is then never one still to delete
+    for (SizeType block = blockCount; block-- > 0;) {
+      for (SizeType row = survives[block].size(); row-- > 0;) {
+        if (survives[block][row] == 0) {
+          removeRow(block * blockRows() + row, deleted);
+        }
+      }
+    }
+    return removed;
+  }
+
+  noteWrite();
+  if (viewSet.isFollowing()) [[unlikely]] {
+    std::vector<SizeType> removedRows;
+    removedRows.reserve(removed);
+    for (SizeType block = 0; block < blockCount; ++block) {
+      for (SizeType row = 0; row < survives[block].size(); ++row) {
+        if (survives[block][row] == 0) {
+          removedRows.push_back(block * blockRows() + row);
+        }
+      }
+    }
+    viewSet.beforeRemove(*this, removedRows);
+  }
+
+  // The blocks before the first deletion stay as they are
+  SizeType firstMoved = 0;
+  while (offsets[firstMoved + 1] == (firstMoved + 1) * blockRows()) {
+    ++firstMoved;
+  }
+  const SizeType base = firstMoved * blockRows();
+  if (stats != nullptr) [[unlikely]] {
+    for (SizeType block = firstMoved; block < blockCount; ++block) {
+      stats->touch(block);  // The survivors move up
+    }
+  }
+
+  // Move the survivors from there on into new blocks, and note where each
+  // row went; a block shared with another table is copied from instead
+  constexpr SizeType gone = std::numeric_limits<SizeType>::max();
+  std::vector<SizeType> moved(rowCount - base);
+  std::vector<std::shared_ptr<Block>> compacted(
+      (survivors + blockRows() - 1) / blockRows());
+  std::copy(blocks.begin(),
+            blocks.begin() + static_cast<std::ptrdiff_t>(firstMoved),
+            compacted.begin());
+  forEachIndex(compacted.size() - firstMoved, [&](size_t index) {
+    const SizeType block = firstMoved + index;
+    compacted[block] = std::make_shared<Block>(
+        std::min(blockRows(), survivors - block * blockRows()));
+  });
+  forEachIndex(blockCount - firstMoved, [&](size_t index) {
+    const SizeType block = firstMoved + index;
+    Block &source = *blocks[block];
+    const bool shared = !ownsAlone(blocks[block]);
+    const SizeType first = block * blockRows() - base;
+    SizeType target = offsets[block];
+    for (SizeType row = 0; row < source.size(); ++row) {
+      if (survives[block][row] == 0) {
+        moved[first + row] = gone;
+        continue;
+      }
+      Datum &slot = (*compacted[target / blockRows()])[target % blockRows()];
+      if (shared) [[unlikely]] {
+        slot = source[row];
+      } else {
+        slot = std::move(source[row]);
+      }
+      moved[first + row] = target++;
+    }
+  });
+
+  if (!ownsAlone(keyMap)) [[unlikely]] {
+    // Shared with another table: index the survivors rather than copy the
+    // whole index and then patch it
+    auto rebuilt = std::make_shared<KeyMap>();
+    rebuilt->reserve(survivors);
+    for (SizeType row = 0; row < survivors; ++row) {
+      rebuilt->emplace(
+          (*compacted[row / blockRows()])[row % blockRows()].keyConstRef(),
+          row);
+    }
+    keyMap = std::move(rebuilt);
+  } else if (moved.size() * kWalkKeysFraction >= keyMap->size()) {
+    // Most rows moved: one walk over the key index patches it, without
+    // hashing a key
+    auto &keys = *keyMap;
+    for (auto entry = keys.begin(); entry != keys.end();) {
+      if (entry->second < base) [[unlikely]] {
+        ++entry;
+        continue;
+      }
+      const SizeType target = moved[entry->second - base];
+      if (target != gone) [[likely]] {
+        entry->second = target;
+        ++entry;
+      } else if (deleted != nullptr) [[likely]] {
+        deleted->keys.push_back(keys.extract(entry++));
+      } else {
+        entry = keys.erase(entry);
+      }
+    }
+  } else {
+    // Look up the keys of the rows from the first deletion on
+    auto &keys = *keyMap;
+    for (SizeType row = 0; row < moved.size(); ++row) {
+      const SizeType target = moved[row];
+      if (target == gone) {
+        const SizeType old = base + row;
+        const auto entry =
+            keys.find((*blocks[old / blockRows()])[old % blockRows()]
+                          .keyConstRef());
+        if (deleted != nullptr) [[likely]] {
+          deleted->keys.push_back(keys.extract(entry));
+        } else {
+          keys.erase(entry);
+        }
+        continue;
+      }
+      keys.find((*compacted[target / blockRows()])[target % blockRows()]
+                    .keyConstRef())
+          ->second = target;
+    }
+  }
+
+  // Every block from the first moved row on has changed
+  if (!allDirty) [[unlikely]] {
+    dirtyBlocks.resize(compacted.size(), 0);
+    for (SizeType block = firstMoved; block < compacted.size(); ++block) {
+      dirtyBlocks[block] = 1;
+    }
+  }
+
+  if (deleted != nullptr) [[likely]] {
+    deleted->blocks.assign(
+        std::make_move_iterator(blocks.begin() +
+                                static_cast<std::ptrdiff_t>(firstMoved)),
+        std::make_move_iterator(blocks.end()));
+  }
+  blocks = std::move(compacted);
+  rowCount = survivors;
+  return removed;
+}
+
+Table::SizeType Table::appendUnique(std::vector<Datum> &&rows) {
+  auto batch = std::move(rows);
+  const auto chunksOf = [](size_t count) {
+    return (count + blockRows() - 1) / blockRows();
+  };
+
+  // Probe the existing keys
+  std::vector<char> fresh(batch.size());
+  const KeyMap &existing = *keyMap;
+  forEachIndex(chunksOf(batch.size()), [&](size_t chunk) {
+    const size_t end = std::min(batch.size(), (chunk + 1) * blockRows());
+    for (size_t index = chunk * blockRows(); index < end; ++index) {
+      fresh[index] = existing.contains(batch[index].keyConstRef()) ? 0 : 1;
+    }
+  });
+  size_t kept = 0;
+  for (size_t index = 0; index < batch.size(); ++index) {
+    if (fresh[index] == 0) [[unlikely]] {
+      continue;
+    }
+    if (kept != index) {
+      batch[kept] = std::move(batch[index]);
+    }
+    ++kept;
+  }
+  batch.erase(batch.begin() + static_cast<std::ptrdiff_t>(kept), batch.end());
+  if (batch.empty()) [[unlikely]] {
+    return 0;
+  }
+
+  // Allocate the index nodes in parallel, then splice them in
+  const SizeType startIndex = rowCount;
+  std::vector<KeyMap> partitions(chunksOf(batch.size()));
+  forEachIndex(partitions.size(), [&](size_t chunk) {
+    const size_t end = std::min(batch.size(), (chunk + 1) * blockRows());
+    auto &partition = partitions[chunk];
+    partition.reserve(end - chunk * blockRows());
+    for (size_t index = chunk * blockRows(); index < end; ++index) {
+      partition.emplace(batch[index].keyConstRef(), startIndex + index);
+    }
+  });
+  auto &keys = ownKeyMap();
+  keys.reserve(keys.size() + batch.size());
+  for (auto &partition : partitions) {
+    keys.merge(partition);
+  }
+
+  blocks.reserve(chunksOf(rowCount + batch.size()));
+  for (auto &datum : batch) {
+    appendRow(std::move(datum));
+  }
+  if (!allDirty) [[unlikely]] {
+    for (size_t row = startIndex; row < rowCount; row += blockRows()) {
+      markRowDirty(row);
+    }
+    markRowDirty(rowCount - 1);
+  }
+  return batch.size();
+}
+
+void Table::ownBlock(SizeType block) {
+  noteWrite();
+  blocks[block] = std::make_shared<Block>(*blocks[block]);
+}
+
+Table::KeyMap &Table::ownKeyMap() {
+  noteWrite();
+  if (!ownsAlone(keyMap)) [[unlikely]] {
+    keyMap = std::make_shared<KeyMap>(*keyMap);
+  }
+  return *keyMap;
+}
+
+void Table::appendRow(Datum &&datum) {
+  noteWrite();
+  if (rowCount % blockRows() == 0) {
+    blocks.push_back(std::make_shared<Block>());
+    blocks.back()->reserve(blockRows());
+  } else if (!ownsAlone(blocks.back())) [[unlikely]] {
+    ownBlock(blocks.size() - 1);
+    blocks.back()->reserve(blockRows());
+  }
+  blocks.back()->push_back(std::move(datum));
+  ++rowCount;
+  if (stats != nullptr) [[unlikely]] {
+    stats->touch(blocks.size() - 1);
+  }
+  if (viewSet.isFollowing()) [[unlikely]] {
+    viewSet.added(blocks.back()->back());
+  }
+}
+
+void Table::markRowDirty(SizeType row) {
+  const SizeType block = row / blockRows();
+  // Only appends grow the table, and they run alone
+  if (block >= dirtyBlocks.size()) [[unlikely]] {
+    dirtyBlocks.resize(block + 1, 0);
+  }
+  dirtyBlocks[block] = 1;
+}
+
+std::vector<Table::SizeType> Table::dirtyBlockList() const {
+  std::vector<SizeType> blocks;
+  for (SizeType block = 0; block < dirtyBlocks.size(); ++block) {
+    if (dirtyBlocks[block] != 0) {
+      blocks.push_back(block);
+    }
+  }
+  return blocks;
+}
+
+void Table::clearDirty() {
+  allDirty = false;
+  dirtyBlocks.assign(blocks.size(), 0);
+}
+
+std::span<const Datum> Table::blockRowsOf(SizeType block) const {
+  if (block >= blocks.size()) {
+    return {};
+  }
+  return *blocks[block];
 }
 
 Table::Object::Ptr Table::operator[](const Table::KeyType &key) {
-  auto iterator = this->keyMap.find(key);
-  if (iterator == keyMap.end()) [[unlikely]] {
+  auto iterator = this->keyMap->find(key);
+  if (iterator == keyMap->end()) [[unlikely]] {
     // not found
     return nullptr;
   }
-  return createProxy(
-      data.begin() +
-          static_cast<std::vector<Datum>::difference_type>(iterator->second),
-      this);
+  return createProxy(iterator->second, this);
+}
+
+Table::ConstObject::Ptr Table::operator[](const Table::KeyType &key) const {
+  if (keyMap == nullptr) [[unlikely]] {
+    // A snapshot scans for the key
+    for (SizeType row = 0; row < rowCount; ++row) {
+      if (rowRef(row).keyConstRef() == key) {
+        return createProxy(row, this);
+      }
+    }
+    return nullptr;
+  }
+  auto iterator = this->keyMap->find(key);
+  if (iterator == keyMap->end()) [[unlikely]] {
+    return nullptr;
+  }
+  return createProxy(iterator->second, this);
 }
 
 std::ostream &operator<<(std::ostream &out, const Table &table) {
@@ -132,14 +583,17 @@ std::ostream &operator<<(std::ostream &out, const Table &table) {
   }
   buffer << "\n";
   auto numFields = table.fields.size();
-  for (const auto &datum : table.data) [[likely]]
+  for (const auto &block : table.blocks) [[likely]]
   {
-    buffer << std::setw(width) << datum.keyConstRef();
-    for (decltype(numFields) i = 0; i < numFields; ++i) [[likely]]
+    for (const auto &datum : *block) [[likely]]
     {
-      buffer << std::setw(width) << datum.datumConstRef()[i];
+      buffer << std::setw(width) << datum.keyConstRef();
+      for (decltype(numFields) i = 0; i < numFields; ++i) [[likely]]
+      {
+        buffer << std::setw(width) << datum.datumConstRef()[i];
+      }
+      buffer << "\n";
     }
-    buffer << "\n";
   }
   return out << buffer.str();
 }
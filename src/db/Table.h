@@ -5,13 +5,18 @@
 #ifndef PROJECT_DB_TABLE_H
 #define PROJECT_DB_TABLE_H
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iterator>
 #include <limits>
 #include <list>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <ostream>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <type_traits>
@@ -23,6 +28,8 @@
 #include "../utils/uexception.h"
 #include "Datum.h"
 #include "QueryBase.h"
+#include "TableStatistics.h"
+#include "TableView.h"
 
 class Table {
 public:
@@ -37,24 +44,63 @@ public:
   using SizeType = size_t;
 
 private:
-  /** A row in the table */
-
-  using DataIterator = std::vector<Datum>::iterator;
-  using ConstDataIterator = std::vector<Datum>::const_iterator;
+  /** A block of consecutive rows; all blocks but the last are full */
+  using Block = std::vector<Datum>;
+  using KeyMap = std::unordered_map<KeyType, SizeType>;
 
   /** The fields, ordered as defined in fieldMap */
   std::vector<FieldNameType> fields;
   /** Map field name into index */
   std::unordered_map<FieldNameType, FieldIndex> fieldMap;
 
-  /** The rows are saved in a vector, which is unsorted */
-  std::vector<Datum> data;
+  /**
+   * The rows, unsorted, in blocks of blockRows() rows. A copy of the table
+   * shares the blocks and the key index with its origin until either side
+   * writes them (copy-on-write, see markDirty), so a shared block is never
+   * modified.
+   */
+  std::vector<std::shared_ptr<Block>> blocks;
+  SizeType rowCount = 0;
   /** Used to keep the keys unique and provide O(1) access with key */
-  std::unordered_map<KeyType, SizeType> keyMap;
+  std::shared_ptr<KeyMap> keyMap = std::make_shared<KeyMap>();
 
   /** The name of table */
   std::string tableName;
 
+  /** Identifies the field layout; unique to each table object */
+  uint64_t generation = nextGeneration();
+  static uint64_t nextGeneration();
+
+  /**
+   * Identifies the contents of the rows (see dataVersion); drawn from the
+   * same sequence as generation, so no two tables ever share one by chance
+   */
+  std::atomic<uint64_t> version{nextGeneration()};
+  /** Whether version was handed out since it was last changed */
+  mutable std::atomic<bool> versionSeen{false};
+
+  /** Aggregates kept up to date with the rows; a copy starts without any */
+  mutable TableViewSet viewSet;
+
+  /**
+   * Statistics of the rows once ANALYZE gathered them, shared with
+   * snapshots. Readers may refresh them (see statistics), so they swap the
+   * pointer under statsMutex; writers run alone and only read it.
+   */
+  mutable std::shared_ptr<TableStatistics> stats;
+  mutable std::mutex statsMutex;
+  /** A reader is gathering fresh statistics */
+  mutable std::atomic<bool> statsRefreshing{false};
+
+  /**
+   * One flag per block of blockRows() rows changed since the last
+   * checkpoint. Covers every row while allDirty is false, so writers running
+   * on separate blocks in parallel never resize it.
+   */
+  std::vector<uint8_t> dirtyBlocks;
+  /** Every row counts as changed (new or cleared table) */
+  bool allDirty = true;
+
   bool initialized = false;
   std::list<Query *> queryQueue;
   int queryQueueCounter = 0;
@@ -66,30 +112,40 @@ public:
     return part;
   }
 
+  /**
+   * Rows per storage and dirty-tracking block: the chunk size of parallel
+   * writers, so that no two of them write the same block
+   */
+  static constexpr size_t blockRows() { return splitsize(); }
+
   using Ptr = std::unique_ptr<Table>;
+  struct DeletedRows;
 
   /**
    * A proxy class that provides abstraction on internal Implementation.
    * Allows independent variation on the representation for a table object
    *
-   * @tparam Iterator
+   * The row is looked up on every access, so an object stays valid when
+   * its block is copied on write.
+   *
    * @tparam VType
    */
-  template <class Iterator, class VType> class ObjectImpl {
+  template <class VType> class ObjectImpl {
     friend class Table;
 
-    /** Not const because key can be updated */
-    Iterator it;
+    SizeType rowIndex;
     // Use const Table* for const VType, Table* for non-const VType
     using TablePtrType =
         std::conditional_t<std::is_const_v<VType>, const Table *, Table *>;
     TablePtrType table;
 
+    [[nodiscard]] auto &datum() const { return table->rowRef(rowIndex); }
+
   public:
     using Ptr = std::unique_ptr<ObjectImpl>;
 
-    ObjectImpl(Iterator datumIt, TablePtrType table_ptr)
-        : it(datumIt), table(table_ptr) {}
+    ObjectImpl(SizeType row, TablePtrType table_ptr)
+        : rowIndex(row), table(table_ptr) {}
 
     ObjectImpl(const ObjectImpl &) = default;
     ObjectImpl(ObjectImpl &&) noexcept = default;
@@ -97,23 +153,25 @@ public:
     ObjectImpl &operator=(ObjectImpl &&) noexcept = default;
     ~ObjectImpl() = default;
 
-    [[nodiscard]] const KeyType &key() const { return it->keyConstRef(); }
+    [[nodiscard]] const KeyType &key() const { return datum().keyConstRef(); }
 
     // Helper to obtain the correct datum reference type depending on VType
     template <typename T = VType> [[nodiscard]] auto &datumAccess() const {
       if constexpr (std::is_const_v<T>) {
-        return it->datumConstRef();
+        return datum().datumConstRef();
       } else {
-        return it->datumRef();
+        return datum().datumRef();
       }
     }
 
     void setKey(KeyType key) {
-      auto keyMapIt = table->keyMap.find(it->keyConstRef());
+      table->markDirty(*this);
+      auto &keys = table->ownKeyMap();
+      auto keyMapIt = keys.find(datum().keyConstRef());
       auto dataIt = std::move(keyMapIt->second);
-      table->keyMap.erase(keyMapIt);
-      table->keyMap.emplace(key, std::move(dataIt));
-      it->setKey(std::move(key));
+      keys.erase(keyMapIt);
+      keys.emplace(key, std::move(dataIt));
+      datum().setKey(std::move(key));
     }
 
     /**
@@ -159,15 +217,14 @@ public:
     }
   };
 
-  using Object = ObjectImpl<DataIterator, ValueType>;
-  using ConstObject = ObjectImpl<ConstDataIterator, const ValueType>;
+  using Object = ObjectImpl<ValueType>;
+  using ConstObject = ObjectImpl<const ValueType>;
 
   /**
    * A proxy class that provides iteration on the table
    * @tparam ObjType
-          return datumAccess().at(index);
    */
-  template <typename ObjType, typename DatumIterator> class IteratorImpl {
+  template <typename ObjType> class IteratorImpl {
     using difference_type = std::ptrdiff_t;
     using value_type = ObjType;
     using pointer = typename ObjType::Ptr;
@@ -177,14 +234,14 @@ public:
 
     friend class Table;
 
-    DatumIterator it;
+    SizeType row = 0;
     // Use const Table* for ConstObject, Table* for Object
     using TablePtrType = typename ObjType::TablePtrType;
     TablePtrType table = nullptr;
 
   public:
-    IteratorImpl(DatumIterator datumIt, TablePtrType table_ptr)
-        : it(datumIt), table(table_ptr) {}
+    IteratorImpl(SizeType index, TablePtrType table_ptr)
+        : row(index), table(table_ptr) {}
 
     IteratorImpl() = default;
 
@@ -198,80 +255,163 @@ public:
 
     ~IteratorImpl() = default;
 
-    pointer operator->() { return createProxy(it, table); }
+    pointer operator->() { return createProxy(row, table); }
 
-    reference operator*() { return *createProxy(it, table); }
+    reference operator*() { return *createProxy(row, table); }
 
     pointer operator->() const {
       if constexpr (std::is_same_v<ObjType, ConstObject>) {
-        return createProxy(it, table);
+        return createProxy(row, table);
       } else {
-        return std::make_unique<Object>(it, table);
+        return std::make_unique<Object>(row, table);
       }
     }
 
     reference operator*() const {
       if constexpr (std::is_same_v<ObjType, ConstObject>) {
-        return *createProxy(it, table);
+        return *createProxy(row, table);
       } else {
-        return *std::make_unique<Object>(it, table);
+        return *std::make_unique<Object>(row, table);
       }
     }
 
-    IteratorImpl operator+(int n) { return IteratorImpl(it + n, table); }
+    IteratorImpl operator+(int n) {
+      return IteratorImpl(row + static_cast<SizeType>(n), table);
+    }
 
-    IteratorImpl operator-(int n) { return IteratorImpl(it - n, table); }
+    IteratorImpl operator-(int n) {
+      return IteratorImpl(row - static_cast<SizeType>(n), table);
+    }
 
-    IteratorImpl &operator+=(int n) { return it += n, *this; }
+    IteratorImpl &operator+=(int n) {
+      return row += static_cast<SizeType>(n), *this;
+    }
 
-    IteratorImpl &operator-=(int n) { return it -= n, *this; }
+    IteratorImpl &operator-=(int n) {
+      return row -= static_cast<SizeType>(n), *this;
+    }
 
-    IteratorImpl &operator++() { return ++it, *this; }
+    IteratorImpl &operator++() { return ++row, *this; }
 
-    IteratorImpl &operator--() { return --it, *this; }
+    IteratorImpl &operator--() { return --row, *this; }
 
     IteratorImpl operator++(int) {
       auto retVal = IteratorImpl(*this);
-      ++it;
+      ++row;
       return retVal;
     }
 
     IteratorImpl operator--(int) {
       auto retVal = IteratorImpl(*this);
-      --it;
+      --row;
       return retVal;
     }
 
     bool operator==(const IteratorImpl &other) const {
-      return this->it == other.it;
+      return this->row == other.row;
     }
 
     friend bool operator!=(const IteratorImpl &lhs, const IteratorImpl &rhs) {
-      return lhs.it != rhs.it;
+      return lhs.row != rhs.row;
     }
 
-    bool operator<=(const IteratorImpl &other) { return this->it <= other.it; }
+    bool operator<=(const IteratorImpl &other) {
+      return this->row <= other.row;
+    }
 
-    bool operator>=(const IteratorImpl &other) { return this->it >= other.it; }
+    bool operator>=(const IteratorImpl &other) {
+      return this->row >= other.row;
+    }
 
-    bool operator<(const IteratorImpl &other) { return this->it < other.it; }
+    bool operator<(const IteratorImpl &other) { return this->row < other.row; }
 
-    bool operator>(const IteratorImpl &other) { return this->it > other.it; }
+    bool operator>(const IteratorImpl &other) { return this->row > other.row; }
   };
 
-  using Iterator = IteratorImpl<Object, decltype(data.begin())>;
-  using ConstIterator = IteratorImpl<ConstObject, decltype(data.cbegin())>;
+  using Iterator = IteratorImpl<Object>;
+  using ConstIterator = IteratorImpl<ConstObject>;
 
 private:
-  static ConstObject::Ptr createProxy(ConstDataIterator iterator,
-                                      const Table *table) {
-    return std::make_unique<ConstObject>(iterator, table);
+  static ConstObject::Ptr createProxy(SizeType row, const Table *table) {
+    return std::make_unique<ConstObject>(row, table);
+  }
+
+  static Object::Ptr createProxy(SizeType row, Table *table) {
+    return std::make_unique<Object>(row, table);
+  }
+
+  [[nodiscard]] Datum &rowRef(SizeType row) {
+    return (*blocks[row / blockRows()])[row % blockRows()];
   }
 
-  static Object::Ptr createProxy(DataIterator iterator, Table *table) {
-    return std::make_unique<Object>(iterator, table);
+  [[nodiscard]] const Datum &rowRef(SizeType row) const {
+    return (*blocks[row / blockRows()])[row % blockRows()];
   }
 
+  /** deleteWhere removes fewer matches than this one by one */
+  static constexpr SizeType compactAfterRows() { return blockRows(); }
+  /**
+   * deleteWhere walks the whole key index rather than look up the moved
+   * rows once they are at least 1/kWalkKeysFraction of it
+   */
+  static constexpr SizeType kWalkKeysFraction = 2;
+
+  /**
+   * Remove a row by swapping the last row into its place
+   * @param index The row
+   * @param deleted If given, receives its key index node
+   */
+  void removeRow(SizeType index, DeletedRows *deleted);
+
+  /**
+   * Check whether this table holds the only reference to a block or key
+   * index, which it may then write in place. The other owners (a COPYTABLE
+   * clone, a snapshot reader) read it on other threads and drop their
+   * reference when done; use_count() is only a relaxed load, so the acquire
+   * fence is what orders their reads before our writes, pairing with the
+   * release in the decrement of their reference. ThreadSanitizer does not
+   * support fences, so its builds take a copy instead: the increment is an
+   * acquire read-modify-write of the count itself, which every earlier
+   * decrement releases to.
+   * @param storage The block or key index
+   */
+  template <typename Storage>
+  [[nodiscard]] static bool ownsAlone(const std::shared_ptr<Storage> &storage) {
+#if defined(__SANITIZE_THREAD__)
+    const std::shared_ptr<Storage> pinned = storage;
+    return pinned.use_count() == 2;
+#else
+    if (storage.use_count() != 1) [[unlikely]] {
+      return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return true;
+#endif
+  }
+
+  /**
+   * Replace a block shared with another table by a private copy; a block
+   * not shared may be written in place only once ownsAlone() said so
+   */
+  void ownBlock(SizeType block);
+  /** Get the key index for writing, copying it first if it is shared */
+  KeyMap &ownKeyMap();
+  /** Append a row to the last block */
+  void appendRow(Datum &&datum);
+
+  /**
+   * Record that the rows are about to change: give the table a new data
+   * version if the current one was handed out. Writers may call this from
+   * several threads at once; after the first, it only reads a flag.
+   */
+  void noteWrite() {
+    if (versionSeen.load(std::memory_order_relaxed)) [[unlikely]] {
+      versionSeen.store(false, std::memory_order_relaxed);
+      version.store(nextGeneration(), std::memory_order_relaxed);
+    }
+  }
+  void markRowDirty(SizeType row);
+
 public:
   Table() = delete;
 
@@ -287,13 +427,27 @@ public:
   Table(const std::string &name, const FieldIDContainer &fields);
 
   /**
-   * Copy constructor from another table
+   * Copy constructor from another table. The copy shares the rows and the
+   * key index with the origin, so this only copies one pointer per block;
+   * each block is copied once either table writes it.
    * @param name: the table name (must be unique in the database)
    * @param origin: the original table copied from
    */
   Table(std::string name, const Table &origin)
-      : fields(origin.fields), fieldMap(origin.fieldMap), data(origin.data),
-        keyMap(origin.keyMap), tableName(std::move(name)) {}
+      : fields(origin.fields), fieldMap(origin.fieldMap), blocks(origin.blocks),
+        rowCount(origin.rowCount), keyMap(origin.keyMap),
+        tableName(std::move(name)), version(origin.dataVersion()),
+        versionSeen(true) {}
+
+  /**
+   * Take a read-only snapshot of the table: a copy that shares the rows (see
+   * the copy constructor) and the schema generation. Later writes to the
+   * table copy the blocks they change, so the snapshot keeps its version of
+   * the rows until it is released. It has no key index; looking a key up
+   * scans the rows.
+   * @return the snapshot
+   */
+  [[nodiscard]] std::shared_ptr<const Table> snapshot() const;
 
   /**
    * Check whether a key already exists in the table
@@ -315,6 +469,53 @@ public:
    */
   [[nodiscard]] FieldIndex getFieldIndex(const FieldNameType &field) const;
 
+  /**
+   * Find the index of a field without throwing
+   * @param field
+   * @return fieldIndex, or nullopt if the field doesn't exist
+   */
+  [[nodiscard]] std::optional<FieldIndex>
+  findFieldIndex(const FieldNameType &field) const;
+
+  /**
+   * Get the schema generation of the table. Every table object gets its own,
+   * so DROP, LOAD and COPYTABLE always give a table name a new generation.
+   * @return generation
+   */
+  [[nodiscard]] uint64_t schemaGeneration() const { return generation; }
+
+  /**
+   * Get the data version of the rows. Every write to the table after the
+   * version was read gives it a new one, and a copy of the table starts with
+   * its origin's, so results computed under one version stay valid for as
+   * long as a table under the same name has that version.
+   * @return version
+   */
+  [[nodiscard]] uint64_t dataVersion() const {
+    versionSeen.store(true, std::memory_order_relaxed);
+    return version.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Get the views kept up to date with the rows; the writers of the table
+   * report their changes to them
+   * @return views
+   */
+  [[nodiscard]] TableViewSet &views() const { return viewSet; }
+
+  /**
+   * Gather the statistics of the rows and their zone map (ANALYZE); the
+   * caller holds a lock of the table
+   */
+  void analyze() const;
+
+  /**
+   * Get the statistics of the rows, gathering them again first once writes
+   * made them stale; the caller holds a lock of the table
+   * @return the statistics, or nullptr if the table was never analyzed
+   */
+  [[nodiscard]] std::shared_ptr<const TableStatistics> statistics() const;
+
   /**
    * Insert a row of data by its key
    * @tparam ValueTypeContainer
@@ -331,18 +532,85 @@ public:
   void
   insertBatch(std::vector<std::pair<KeyType, std::vector<ValueType>>> &&batch);
 
+  /**
+   * Insert rows of data by their keys in order; a row whose key is already
+   * in the table, or earlier in the batch, is skipped instead of thrown for
+   * @param batch: vector of key-data pairs to insert
+   * @return whether each row was inserted
+   */
+  std::vector<bool> tryInsertBatch(
+      std::vector<std::pair<KeyType, std::vector<ValueType>>> &&batch);
+
+  /**
+   * Append the rows whose keys are not in the table yet, in order; a key
+   * already there is skipped, not an error
+   * Keys are probed and key index entries built in parallel partitions, which
+   * are then spliced into the index without copying their nodes
+   * @param rows The rows; their keys must differ from each other
+   * @return the number of rows appended
+   */
+  SizeType appendUnique(std::vector<Datum> &&rows);
+
+  /** Storage a table let go of in deleteWhere */
+  struct DeletedRows {
+    /** Key index nodes of the deleted rows */
+    std::vector<KeyMap::node_type> keys;
+    /** Replaced blocks, with the deleted rows still in them */
+    std::vector<std::shared_ptr<Block>> blocks;
+  };
+
+  /**
+   * Get the message of the ConflictingKey thrown for inserting an existing key
+   * @param key
+   */
+  [[nodiscard]] std::string keyExistsMessage(const KeyType &key) const {
+    return "In Table \"" + tableName + "\" : Key \"" + key +
+           "\" already exists!";
+  }
+
   /**
    * Delete a row of data by its key
    * @param key
    */
   void deleteByIndex(const KeyType &key);
 
+  /**
+   * Delete every row a predicate matches, in bulk
+   * Rows are tested in parallel, block by block. Fewer than
+   * compactAfterRows() matches are removed one by one, each swapped with the
+   * last row. Otherwise the survivors from the first block with a match on
+   * are moved, in order, into new blocks in one parallel pass (each block's
+   * offset is the prefix sum of the survivor counts before it), the blocks
+   * before it being kept, and the key index entries of the moved rows are
+   * patched.
+   * @param matches Tested on each row, from several threads at once
+   * @param deleted If given, receives the replaced blocks and key index nodes
+   * instead of destroying them, so they can be freed later (see Reclaimer)
+   * @return the number of rows deleted
+   */
+  SizeType deleteWhere(const std::function<bool(const ConstObject &)> &matches,
+                       DeletedRows *deleted = nullptr);
+
+  /**
+   * Estimate the heap bytes held by rows and their key index nodes
+   * @param rows Number of rows
+   * @param fieldCount Number of fields of each row
+   */
+  [[nodiscard]] static size_t estimateBytes(size_t rows, size_t fieldCount);
+
+  /**
+   * Estimate the heap bytes this table alone holds; blocks and a key index
+   * shared with another table are not counted
+   */
+  [[nodiscard]] size_t storageBytes() const;
+
   /**
    * Access the value according to the key
    * @param key
    * @return the Object that KEY = key, or nullptr if key doesn't exist
    */
   Object::Ptr operator[](const KeyType &key);
+  ConstObject::Ptr operator[](const KeyType &key) const;
 
   /**
    * Set the name of the table
@@ -375,7 +643,8 @@ public:
   [[nodiscard]] const std::vector<FieldNameType> &field() const;
 
   /**
-   * Clear all content in the table
+   * Clear all content in the table; the old rows are destroyed once no
+   * thread can still be reading them (see EpochManager)
    * @return rows affected
    */
   size_t clear();
@@ -386,12 +655,64 @@ public:
    * @param capacity number of rows to pre-allocate
    */
   void reserve(SizeType capacity) {
-    data.reserve(capacity);
-    keyMap.reserve(capacity);
+    blocks.reserve((capacity + blockRows() - 1) / blockRows());
+    ownKeyMap().reserve(capacity);
   }
 
   void drop();
 
+  /**
+   * Prepare a row to be changed in place: copy its block if it is shared
+   * with a copy of the table, and record the change for incremental
+   * checkpoints. Writers call this before they modify a row; rows of
+   * different blocks may be marked from different threads.
+   * @param row The row about to be modified
+   */
+  void markDirty(const Object &row) {
+    noteWrite();
+    if (viewSet.isFollowing()) [[unlikely]] {
+      viewSet.beforeChange(*this, row.rowIndex);
+    }
+    const SizeType block = row.rowIndex / blockRows();
+    if (!ownsAlone(blocks[block])) [[unlikely]] {
+      ownBlock(block);
+    }
+    if (stats != nullptr) [[unlikely]] {
+      stats->touch(block);
+    }
+    if (!allDirty) [[unlikely]] {
+      markRowDirty(row.rowIndex);
+    }
+  }
+
+  /**
+   * Check whether every row changed since the last checkpoint
+   * @return true for a table that is new or was cleared since then
+   */
+  [[nodiscard]] bool isFullyDirty() const { return allDirty; }
+
+  /**
+   * Get the blocks with rows changed since the last checkpoint
+   * @return indices of the changed blocks in order; after deletes they can
+   *         lie past the end of the table
+   */
+  [[nodiscard]] std::vector<SizeType> dirtyBlockList() const;
+
+  /**
+   * Forget all changes, once they are checkpointed
+   */
+  void clearDirty();
+
+  /**
+   * Get the rows of a block in storage order
+   * @param block The block index
+   * @return the rows, empty past the end of the table
+   */
+  [[nodiscard]] std::span<const Datum> blockRowsOf(SizeType block) const;
+
+  /** Get the number of blocks of rows */
+  [[nodiscard]] SizeType blockCount() const { return blocks.size(); }
+
   /**
    * Get a begin iterator similar to the standard iterator
    * @return begin iterator
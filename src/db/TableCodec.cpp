@@ -0,0 +1,502 @@
+#include "TableCodec.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <istream>
+#include <iterator>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "../threading/Threadpool.h"
+#include "../utils/formatter.h"
+#include "../utils/uexception.h"
+#include "Table.h"
+
+namespace {
+constexpr std::array<char, 4> kMagic = {'L', 'T', 'C', '1'};
+constexpr unsigned kByteBits = 8;
+constexpr unsigned kVarintPayloadBits = 7;
+constexpr std::uint8_t kVarintMask = 0x7F;
+constexpr std::uint8_t kVarintContinue = 0x80;
+constexpr std::uint32_t kSignShift = 31;
+constexpr unsigned kMaxWidth = 32;
+
+enum class ColumnMode : std::uint8_t { FrameOfReference = 0, Delta = 1 };
+
+using RowRef = std::pair<const Table::KeyType *, const std::vector<int> *>;
+using DecodedRow = std::pair<Table::KeyType, std::vector<Table::ValueType>>;
+
+std::uint32_t zigzag(std::int32_t value) {
+  return (static_cast<std::uint32_t>(value) << 1U) ^
+         static_cast<std::uint32_t>(value >> kSignShift);
+}
+
+std::int32_t unzigzag(std::uint32_t value) {
+  return static_cast<std::int32_t>((value >> 1U) ^ (0U - (value & 1U)));
+}
+
+unsigned bitWidth(std::uint32_t value) {
+  return static_cast<unsigned>(std::bit_width(value));
+}
+
+void putVarint(std::string &out, std::uint64_t value) {
+  while (value >= kVarintContinue) {
+    out.push_back(static_cast<char>((value & kVarintMask) | kVarintContinue));
+    value >>= kVarintPayloadBits;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+void putString(std::string &out, std::string_view value) {
+  putVarint(out, value.size());
+  out.append(value);
+}
+
+void packBits(std::string &out, const std::vector<std::uint32_t> &values,
+              unsigned width) {
+  if (width == 0) {
+    return;
+  }
+  std::uint64_t acc = 0;
+  unsigned bits = 0;
+  for (const auto value : values) {
+    acc |= static_cast<std::uint64_t>(value) << bits;
+    bits += width;
+    while (bits >= kByteBits) {
+      out.push_back(static_cast<char>(acc & 0xFFU));
+      acc >>= kByteBits;
+      bits -= kByteBits;
+    }
+  }
+  if (bits > 0) {
+    out.push_back(static_cast<char>(acc & 0xFFU));
+  }
+}
+
+/**
+ * Bounds-checked cursor over an encoded buffer.
+ */
+class Reader {
+  std::string_view buffer;
+  size_t pos = 0;
+  const std::string &error;
+
+public:
+  Reader(std::string_view buf, const std::string &err)
+      : buffer(buf), error(err) {}
+
+  [[noreturn]] void fail(const char *what) const {
+    throw LoadFromStreamException(error + what);
+  }
+
+  [[nodiscard]] size_t position() const { return pos; }
+
+  [[nodiscard]] bool atEnd() const { return pos >= buffer.size(); }
+
+  std::uint8_t byte() {
+    if (pos >= buffer.size()) [[unlikely]] {
+      fail("Unexpected end of data.");
+    }
+    return static_cast<std::uint8_t>(buffer[pos++]);
+  }
+
+  std::uint64_t varint() {
+    std::uint64_t value = 0;
+    for (unsigned shift = 0; shift < std::numeric_limits<std::uint64_t>::digits;
+         shift += kVarintPayloadBits) {
+      const std::uint8_t current = byte();
+      value |= static_cast<std::uint64_t>(current & kVarintMask) << shift;
+      if ((current & kVarintContinue) == 0) {
+        return value;
+      }
+    }
+    fail("Malformed varint.");
+  }
+
+  size_t length() {
+    const auto value = varint();
+    if (value > buffer.size() - pos) [[unlikely]] {
+      fail("Length exceeds data size.");
+    }
+    return static_cast<size_t>(value);
+  }
+
+  std::string_view bytes(size_t count) {
+    if (count > buffer.size() - pos) [[unlikely]] {
+      fail("Unexpected end of data.");
+    }
+    auto result = buffer.substr(pos, count);
+    pos += count;
+    return result;
+  }
+
+  std::uint32_t u32() {
+    const auto value = varint();
+    if (value > std::numeric_limits<std::uint32_t>::max()) [[unlikely]] {
+      fail("Value out of range.");
+    }
+    return static_cast<std::uint32_t>(value);
+  }
+
+  void unpackBits(std::vector<std::uint32_t> &values, size_t count,
+                  unsigned width) {
+    values.assign(count, 0);
+    if (width == 0 || count == 0) {
+      return;
+    }
+    if (width > kMaxWidth) [[unlikely]] {
+      fail("Invalid bit width.");
+    }
+    const auto packed = bytes((count * width + kByteBits - 1) / kByteBits);
+    const std::uint64_t mask = (std::uint64_t{1} << width) - 1;
+    std::uint64_t acc = 0;
+    unsigned bits = 0;
+    size_t next = 0;
+    for (auto &value : values) {
+      while (bits < width) {
+        acc |= static_cast<std::uint64_t>(
+                   static_cast<std::uint8_t>(packed[next++]))
+               << bits;
+        bits += kByteBits;
+      }
+      value = static_cast<std::uint32_t>(acc & mask);
+      acc >>= width;
+      bits -= width;
+    }
+  }
+};
+
+void encodeColumn(std::string &out, const std::vector<RowRef> &rows,
+                  size_t begin, size_t end, size_t column) {
+  const size_t count = end - begin;
+  std::int32_t minValue = std::numeric_limits<std::int32_t>::max();
+  std::int32_t maxValue = std::numeric_limits<std::int32_t>::min();
+  std::uint32_t maxDelta = 0;
+  for (size_t i = begin; i < end; ++i) {
+    const auto value = static_cast<std::int32_t>((*rows[i].second)[column]);
+    minValue = std::min(minValue, value);
+    maxValue = std::max(maxValue, value);
+    if (i > begin) {
+      const auto prev =
+          static_cast<std::int32_t>((*rows[i - 1].second)[column]);
+      maxDelta = std::max(maxDelta, zigzag(static_cast<std::int32_t>(
+                                        static_cast<std::uint32_t>(value) -
+                                        static_cast<std::uint32_t>(prev))));
+    }
+  }
+
+  const auto range = static_cast<std::uint32_t>(
+      static_cast<std::int64_t>(maxValue) - static_cast<std::int64_t>(minValue));
+  const unsigned forWidth = bitWidth(range);
+  const unsigned deltaWidth = bitWidth(maxDelta);
+
+  std::vector<std::uint32_t> packed;
+  packed.reserve(count);
+  if (deltaWidth < forWidth) {
+    out.push_back(static_cast<char>(ColumnMode::Delta));
+    auto prev = static_cast<std::int32_t>((*rows[begin].second)[column]);
+    putVarint(out, zigzag(prev));
+    out.push_back(static_cast<char>(deltaWidth));
+    for (size_t i = begin + 1; i < end; ++i) {
+      const auto value = static_cast<std::int32_t>((*rows[i].second)[column]);
+      packed.push_back(zigzag(static_cast<std::int32_t>(
+          static_cast<std::uint32_t>(value) - static_cast<std::uint32_t>(prev))));
+      prev = value;
+    }
+    packBits(out, packed, deltaWidth);
+    return;
+  }
+
+  out.push_back(static_cast<char>(ColumnMode::FrameOfReference));
+  putVarint(out, zigzag(minValue));
+  out.push_back(static_cast<char>(forWidth));
+  for (size_t i = begin; i < end; ++i) {
+    packed.push_back(static_cast<std::uint32_t>(
+        static_cast<std::int64_t>((*rows[i].second)[column]) - minValue));
+  }
+  packBits(out, packed, forWidth);
+}
+
+std::string encodeBlock(const std::vector<RowRef> &rows, size_t begin,
+                        size_t end, size_t numFields) {
+  std::string payload;
+  std::string_view previous;
+  for (size_t i = begin; i < end; ++i) {
+    const std::string_view key = *rows[i].first;
+    const auto shared = static_cast<size_t>(
+        std::mismatch(previous.begin(), previous.end(), key.begin(), key.end())
+            .first -
+        previous.begin());
+    putVarint(payload, shared);
+    putString(payload, key.substr(shared));
+    previous = key;
+  }
+  for (size_t column = 0; column < numFields; ++column) {
+    encodeColumn(payload, rows, begin, end, column);
+  }
+
+  std::string framed;
+  putVarint(framed, payload.size());
+  putVarint(framed, end - begin);
+  framed.append(payload);
+  return framed;
+}
+
+std::vector<DecodedRow> decodeBlock(std::string_view payload, size_t count,
+                                    size_t numFields,
+                                    const std::string &error) {
+  Reader reader(payload, error);
+  std::vector<DecodedRow> rows(count);
+  std::string previous;
+  for (auto &row : rows) {
+    const auto shared = reader.varint();
+    if (shared > previous.size()) [[unlikely]] {
+      reader.fail("Invalid key prefix.");
+    }
+    const auto suffix = reader.bytes(reader.length());
+    row.first.reserve(static_cast<size_t>(shared) + suffix.size());
+    row.first.assign(previous, 0, static_cast<size_t>(shared));
+    row.first.append(suffix);
+    previous = row.first;
+    row.second.resize(numFields);
+  }
+
+  std::vector<std::uint32_t> packed;
+  for (size_t column = 0; column < numFields && count > 0; ++column) {
+    const auto mode = reader.byte();
+    const auto base = unzigzag(reader.u32());
+    const unsigned width = reader.byte();
+    if (mode == static_cast<std::uint8_t>(ColumnMode::Delta)) {
+      reader.unpackBits(packed, count - 1, width);
+      auto value = static_cast<std::uint32_t>(base);
+      rows[0].second[column] = base;
+      for (size_t i = 1; i < count; ++i) {
+        value += static_cast<std::uint32_t>(unzigzag(packed[i - 1]));
+        rows[i].second[column] = static_cast<Table::ValueType>(value);
+      }
+    } else if (mode == static_cast<std::uint8_t>(ColumnMode::FrameOfReference)) {
+      reader.unpackBits(packed, count, width);
+      for (size_t i = 0; i < count; ++i) {
+        rows[i].second[column] = static_cast<Table::ValueType>(
+            static_cast<std::int64_t>(base) + packed[i]);
+      }
+    } else [[unlikely]] {
+      reader.fail("Unknown column encoding.");
+    }
+  }
+  if (!reader.atEnd()) [[unlikely]] {
+    reader.fail("Trailing bytes in block.");
+  }
+  return rows;
+}
+
+bool useThreadPool(size_t blocks) {
+  return blocks > 1 && ThreadPool::isInitialized() &&
+         ThreadPool::getInstance().getThreadCount() > 1;
+}
+}  // namespace
+
+namespace TableCodec {
+bool isCompressed(std::istream &input) {
+  const auto start = input.tellg();
+  std::array<char, kMagic.size()> magic{};
+  input.read(magic.data(), static_cast<std::streamsize>(magic.size()));
+  const bool matched = input.gcount() ==
+                           static_cast<std::streamsize>(magic.size()) &&
+                       magic == kMagic;
+  input.clear();
+  input.seekg(start);
+  return matched;
+}
+
+bool isCompressed(std::string_view data) {
+  return data.starts_with(std::string_view(kMagic.data(), kMagic.size()));
+}
+
+std::string readTableName(std::istream &input) {
+  std::string header(kMagic.size(), '\0');
+  input.read(header.data(), static_cast<std::streamsize>(header.size()));
+  // The name length is a varint followed by the name itself
+  std::uint64_t length = 0;
+  for (unsigned shift = 0; input && shift < kMaxWidth;
+       shift += kVarintPayloadBits) {
+    const int current = input.get();
+    if (current == std::char_traits<char>::eof()) {
+      return "";
+    }
+    length |= static_cast<std::uint64_t>(static_cast<unsigned>(current) &
+                                         kVarintMask)
+              << shift;
+    if ((static_cast<unsigned>(current) & kVarintContinue) == 0) {
+      std::string name(static_cast<size_t>(length), '\0');
+      input.read(name.data(), static_cast<std::streamsize>(name.size()));
+      return input ? name : "";
+    }
+  }
+  return "";
+}
+
+void encode(const Table &table, std::ostream &output) {
+  const size_t numFields = table.field().size();
+  std::vector<RowRef> rows;
+  rows.reserve(table.size());
+  for (const auto &object : table) {
+    rows.emplace_back(&object.key(), &object.datumAccess());
+  }
+  std::sort(rows.begin(), rows.end(), [](const RowRef &lhs, const RowRef &rhs) {
+    return *lhs.first < *rhs.first;
+  });
+
+  std::string header(kMagic.begin(), kMagic.end());
+  putString(header, table.name());
+  putVarint(header, numFields);
+  for (const auto &field : table.field()) {
+    putString(header, field);
+  }
+  putVarint(header, rows.size());
+  const size_t blocks = (rows.size() + kRowsPerBlock - 1) / kRowsPerBlock;
+  putVarint(header, blocks);
+  output.write(header.data(), static_cast<std::streamsize>(header.size()));
+
+  auto blockRange = [&rows](size_t block) {
+    const size_t begin = block * kRowsPerBlock;
+    return std::make_pair(begin, std::min(begin + kRowsPerBlock, rows.size()));
+  };
+
+  if (!useThreadPool(blocks)) {
+    for (size_t block = 0; block < blocks; ++block) {
+      const auto [begin, end] = blockRange(block);
+      const auto framed = encodeBlock(rows, begin, end, numFields);
+      output.write(framed.data(), static_cast<std::streamsize>(framed.size()));
+    }
+    return;
+  }
+
+  const ThreadPool &pool = ThreadPool::getInstance();
+  std::vector<std::future<std::string>> futures;
+  futures.reserve(blocks);
+  for (size_t block = 0; block < blocks; ++block) {
+    const auto [begin, end] = blockRange(block);
+    futures.push_back(pool.submit([&rows, begin, end, numFields]() {
+      return encodeBlock(rows, begin, end, numFields);
+    }));
+  }
+  // Wait for every block before a failure unwinds the rows they read
+  std::exception_ptr failure;
+  for (auto &future : futures) {
+    try {
+      const auto framed = future.get();
+      if (failure == nullptr) [[likely]] {
+        output.write(framed.data(),
+                     static_cast<std::streamsize>(framed.size()));
+      }
+    } catch (const std::exception &) {
+      if (failure == nullptr) {
+        failure = std::current_exception();
+      }
+    }
+  }
+  if (failure != nullptr) [[unlikely]] {
+    std::rethrow_exception(failure);
+  }
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+Table::Ptr decode(std::istream &input, const std::string &source) {
+  const std::string error =
+      !source.empty() ? R"(Invalid compressed table (from "?") format: )"_f %
+                            source
+                      : "Invalid compressed table format: ";
+  const std::string buffer{std::istreambuf_iterator<char>(input),
+                           std::istreambuf_iterator<char>()};
+  Reader reader(buffer, error);
+
+  if (reader.bytes(kMagic.size()) !=
+      std::string_view(kMagic.data(), kMagic.size())) [[unlikely]] {
+    reader.fail("Bad magic.");
+  }
+  const std::string tableName(reader.bytes(reader.length()));
+  const auto numFields = static_cast<size_t>(reader.length());
+  std::vector<Table::FieldNameType> fields;
+  fields.reserve(numFields);
+  for (size_t i = 0; i < numFields; ++i) {
+    fields.emplace_back(reader.bytes(reader.length()));
+  }
+  const auto totalRows = static_cast<size_t>(reader.varint());
+  const auto blocks = static_cast<size_t>(reader.length());
+
+  // Locate every block first so they can be decoded independently
+  struct BlockRef {
+    std::string_view payload;
+    size_t rows;
+  };
+  std::vector<BlockRef> blockRefs;
+  blockRefs.reserve(blocks);
+  size_t rowSum = 0;
+  for (size_t block = 0; block < blocks; ++block) {
+    const auto size = reader.length();
+    const auto rows = static_cast<size_t>(reader.varint());
+    if (rows > kRowsPerBlock) [[unlikely]] {
+      reader.fail("Block too large.");
+    }
+    blockRefs.push_back({reader.bytes(size), rows});
+    rowSum += rows;
+  }
+  if (rowSum != totalRows || !reader.atEnd()) [[unlikely]] {
+    reader.fail("Row count mismatch.");
+  }
+
+  std::vector<DecodedRow> allRows;
+  allRows.reserve(totalRows);
+  auto append = [&allRows](std::vector<DecodedRow> &&rows) {
+    allRows.insert(allRows.end(), std::make_move_iterator(rows.begin()),
+                   std::make_move_iterator(rows.end()));
+  };
+
+  if (!useThreadPool(blocks)) {
+    for (const auto &ref : blockRefs) {
+      append(decodeBlock(ref.payload, ref.rows, numFields, error));
+    }
+  } else {
+    const ThreadPool &pool = ThreadPool::getInstance();
+    std::vector<std::future<std::vector<DecodedRow>>> futures;
+    futures.reserve(blocks);
+    for (const auto &ref : blockRefs) {
+      futures.push_back(pool.submit([ref, numFields, &error]() {
+        return decodeBlock(ref.payload, ref.rows, numFields, error);
+      }));
+    }
+    // Wait for every block before a failure unwinds the buffer they read
+    std::exception_ptr failure;
+    for (auto &future : futures) {
+      try {
+        auto rows = future.get();
+        if (failure == nullptr) [[likely]] {
+          append(std::move(rows));
+        }
+      } catch (const std::exception &) {
+        if (failure == nullptr) {
+          failure = std::current_exception();
+        }
+      }
+    }
+    if (failure != nullptr) [[unlikely]] {
+      std::rethrow_exception(failure);
+    }
+  }
+
+  auto table = std::make_unique<Table>(tableName, fields);
+  table->reserve(allRows.size());
+  table->insertBatch(std::move(allRows));
+  return table;
+}
+}  // namespace TableCodec
@@ -0,0 +1,73 @@
+#ifndef PROJECT_DB_TABLECODEC_H
+#define PROJECT_DB_TABLECODEC_H
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "Table.h"
+
+/**
+ * Compact binary encoding for dumped tables ("LTC" format).
+ *
+ * Layout:
+ *  - 4-byte magic "LTC1", table name, field names, total row count.
+ *  - A sequence of independent blocks of up to kRowsPerBlock rows, each
+ *    framed as [payload size][row count][payload] so blocks can be located
+ *    with a cheap scan and decoded in parallel.
+ *
+ * Rows are written in KEY order. Inside a block, keys are front coded against
+ * the previous key of the same block, and each integer column is stored
+ * column-major either as frame-of-reference + bit-packing or as bit-packed
+ * zigzag deltas, whichever needs fewer bits per value.
+ *
+ * Corrupted input is reported with LoadFromStreamException.
+ */
+namespace TableCodec {
+/** Number of rows stored in one independently decodable block. */
+constexpr size_t kRowsPerBlock = 4096;
+
+/**
+ * Check whether a stream starts with the compressed table magic.
+ * The read position of the stream is restored before returning.
+ * @param input Stream positioned at the start of a table file.
+ * @return true if the stream holds an LTC encoded table.
+ */
+[[nodiscard]] bool isCompressed(std::istream &input);
+
+/**
+ * Check whether a buffer starts with the compressed table magic.
+ * @param data Bytes holding a whole or partial table.
+ * @return true if the bytes hold an LTC encoded table.
+ */
+[[nodiscard]] bool isCompressed(std::string_view data);
+
+/**
+ * Read only the table name from an LTC encoded stream.
+ * @param input Stream positioned at the start of the file.
+ * @return The table name, or an empty string if the header is unreadable.
+ */
+[[nodiscard]] std::string readTableName(std::istream &input);
+
+/**
+ * Encode a table into the stream. Blocks are encoded on the thread pool
+ * when it is available and the table is large enough.
+ * @param table The table to encode (caller holds its read lock).
+ * @param output Binary output stream.
+ */
+void encode(const Table &table, std::ostream &output);
+
+/**
+ * Decode an LTC encoded stream into a new, unregistered table.
+ * Blocks are decoded on the thread pool when it is available.
+ * @param input Stream positioned at the start of the file.
+ * @param source Source description used in error messages.
+ * @return The decoded table.
+ */
+[[nodiscard]] Table::Ptr decode(std::istream &input,
+                                const std::string &source = "");
+}  // namespace TableCodec
+
+#endif  // PROJECT_DB_TABLECODEC_H
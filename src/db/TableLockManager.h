@@ -1,11 +1,72 @@
 #ifndef PROJECT_TABLELOCKMANAGER_H
 #define PROJECT_TABLELOCKMANAGER_H
 
+#include <algorithm>
 #include <memory>
 #include <mutex>
 #include <shared_mutex>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../utils/QueryProfile.h"
+#include "../utils/Tracer.h"
+
+/**
+ * The lock of one table: a `std::shared_mutex` that, while tracing, records
+ * how long each holder held it (see Tracer).
+ */
+class TableMutex {
+  std::shared_mutex mutex;
+  std::string table;
+  /** When the writer holding the lock took it, if it was traced */
+  Tracer::Clock::time_point writeSince;
+  /** When each read lock this thread holds was taken, if it was traced */
+  static inline thread_local std::vector<
+      std::pair<const TableMutex *, Tracer::Clock::time_point>>
+      readSince;
+
+public:
+  explicit TableMutex(std::string table) : table(std::move(table)) {}
+
+  void lock() {
+    mutex.lock();
+    if (Tracer::isEnabled()) [[unlikely]] {
+      writeSince = Tracer::Clock::now();
+    }
+  }
+
+  void unlock() {
+    if (writeSince != Tracer::Clock::time_point{}) [[unlikely]] {
+      Tracer::getInstance().record("Write lock held", table, writeSince,
+                                   Tracer::Clock::now());
+      writeSince = {};
+    }
+    mutex.unlock();
+  }
+
+  void lock_shared() {
+    mutex.lock_shared();
+    if (Tracer::isEnabled()) [[unlikely]] {
+      readSince.emplace_back(this, Tracer::Clock::now());
+    }
+  }
+
+  void unlock_shared() {
+    if (!readSince.empty()) [[unlikely]] {
+      const auto held = std::ranges::find(
+          readSince.rbegin(), readSince.rend(), this,
+          &std::pair<const TableMutex *, Tracer::Clock::time_point>::first);
+      if (held != readSince.rend()) {
+        Tracer::getInstance().record("Read lock held", table, held->second,
+                                     Tracer::Clock::now());
+        readSince.erase(std::next(held).base());
+      }
+    }
+    mutex.unlock_shared();
+  }
+};
 
 /**
  * Thread-safe per-table lock manager providing shared (read) and exclusive
@@ -33,7 +94,7 @@ private:
   /**
    * Map from table name to its associated shared mutex.
    */
-  std::unordered_map<std::string, std::unique_ptr<std::shared_mutex>> lock_map_;
+  std::unordered_map<std::string, std::unique_ptr<TableMutex>> lock_map_;
   /**
    * Mutex protecting access to the lock map (supports reader concurrency).
    */
@@ -49,7 +110,7 @@ private:
    * @param table_name Name of the table whose lock is requested.
    * @return Reference to the table's shared mutex.
    */
-  std::shared_mutex &getOrCreateLock(const std::string &table_name) {
+  TableMutex &getOrCreateLock(const std::string &table_name) {
     {
       const std::shared_lock<std::shared_mutex> read(map_mutex_);
       auto iter = lock_map_.find(table_name);
@@ -61,12 +122,15 @@ private:
     const std::unique_lock<std::shared_mutex> write(map_mutex_);
     auto &ptr = lock_map_[table_name];
     if (!ptr) [[unlikely]] {
-      ptr = std::make_unique<std::shared_mutex>();
+      ptr = std::make_unique<TableMutex>(table_name);
     }
     return *ptr;
   }
 
 public:
+  using ReadLock = std::shared_lock<TableMutex>;
+  using WriteLock = std::unique_lock<TableMutex>;
+
   TableLockManager(TableLockManager &&) = delete;
   TableLockManager &operator=(TableLockManager &&) = delete;
   TableLockManager(const TableLockManager &) = delete;
@@ -76,22 +140,24 @@ public:
    * Acquire a shared (read) lock for the specified table.
    * Multiple concurrent read locks are permitted.
    * @param table_name Table name to lock for read.
-   * @return `std::shared_lock` owning the acquired shared mutex state.
+   * @return `ReadLock` owning the acquired shared mutex state.
    */
-  [[nodiscard]] std::shared_lock<std::shared_mutex>
-  acquireRead(const std::string &table_name) {
-    return std::shared_lock<std::shared_mutex>(getOrCreateLock(table_name));
+  [[nodiscard]] ReadLock acquireRead(const std::string &table_name) {
+    const QueryProfile::StageTimer timer(QueryProfile::Stage::LockWait);
+    const Tracer::Span span("Read lock wait", table_name);
+    return ReadLock(getOrCreateLock(table_name));
   }
 
   /**
    * Acquire an exclusive (write) lock for the specified table.
    * Blocks until all readers and writers release the mutex.
    * @param table_name Table name to lock for write.
-   * @return `std::unique_lock` owning the acquired exclusive mutex state.
+   * @return `WriteLock` owning the acquired exclusive mutex state.
    */
-  [[nodiscard]] std::unique_lock<std::shared_mutex>
-  acquireWrite(const std::string &table_name) {
-    return std::unique_lock<std::shared_mutex>(getOrCreateLock(table_name));
+  [[nodiscard]] WriteLock acquireWrite(const std::string &table_name) {
+    const QueryProfile::StageTimer timer(QueryProfile::Stage::LockWait);
+    const Tracer::Span span("Write lock wait", table_name);
+    return WriteLock(getOrCreateLock(table_name));
   }
 
   /**
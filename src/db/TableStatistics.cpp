@@ -0,0 +1,261 @@
+#include "TableStatistics.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "../threading/Threadpool.h"
+#include "Datum.h"
+#include "Table.h"
+
+namespace {
+/** HyperLogLog registers of one field: 2^kRegisterBits of them */
+constexpr unsigned kRegisterBits = 10;
+constexpr size_t kRegisters = size_t{1} << kRegisterBits;
+using Registers = std::array<uint8_t, kRegisters>;
+
+/** Mix the bits of a value so every bit of the hash depends on all of them */
+constexpr uint64_t hashValue(ValueType value) {
+  // splitmix64 finalizer
+  auto hash = static_cast<uint64_t>(static_cast<uint32_t>(value));
+  hash = (hash ^ (hash >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+  hash = (hash ^ (hash >> 27U)) * 0x94d049bb133111ebULL;
+  return hash ^ (hash >> 31U);
+}
+
+void addToRegisters(Registers &registers, ValueType value) {
+  const uint64_t hash = hashValue(value);
+  const auto slot = static_cast<size_t>(hash >> (64U - kRegisterBits));
+  // The rest of the bits, with a stop bit so the rank stays in range
+  const uint64_t rest = (hash << kRegisterBits) | (uint64_t{1} << 9U);
+  const auto rank = static_cast<uint8_t>(std::countl_zero(rest) + 1);
+  registers[slot] = std::max(registers[slot], rank);
+}
+
+size_t estimateDistinct(const Registers &registers, size_t rows) {
+  constexpr auto registerCount = static_cast<double>(kRegisters);
+  constexpr double alpha = 0.7213 / (1.0 + 1.079 / registerCount);
+  double sum = 0;
+  size_t zeros = 0;
+  for (const uint8_t rank : registers) {
+    sum += std::ldexp(1.0, -rank);
+    zeros += rank == 0 ? 1 : 0;
+  }
+  double estimate = alpha * registerCount * registerCount / sum;
+  constexpr double smallRange = 2.5;
+  if (estimate <= smallRange * registerCount && zeros != 0) {
+    // Linear counting is closer for few distinct values
+    estimate = registerCount *
+               std::log(registerCount / static_cast<double>(zeros));
+  }
+  return std::clamp<size_t>(static_cast<size_t>(std::llround(estimate)),
+                            rows != 0 ? 1 : 0, rows);
+}
+
+/**
+ * Run a task for each part of the blocks, on the thread pool if it has more
+ * than one thread
+ */
+template <class Task>
+void forEachPart(size_t parts, const Task &task) {
+  if (parts <= 1) {
+    task(0);
+    return;
+  }
+  const ThreadPool &pool = ThreadPool::getInstance();
+  std::vector<std::future<void>> futures;
+  futures.reserve(parts);
+  for (size_t part = 0; part < parts; ++part) {
+    futures.push_back(pool.submit([&task, part]() { task(part); }));
+  }
+  for (auto &future : futures) {
+    future.get();
+  }
+}
+}  // namespace
+
+double ColumnStatistics::fractionAtMost(ValueType value) const {
+  if (value < min) {
+    return 0;
+  }
+  if (value >= max || bounds.empty()) {
+    return 1;
+  }
+  // Whole buckets below the value, then a share of the one it falls in,
+  // assuming its values spread evenly
+  const auto bucket = static_cast<size_t>(
+      std::upper_bound(bounds.begin(), bounds.end(), value) - bounds.begin());
+  double fraction = static_cast<double>(bucket);
+  if (bucket < bounds.size()) {
+    const double low = bucket == 0 ? min : bounds[bucket - 1];
+    const double high = bounds[bucket];
+    if (high > low) {
+      fraction += (value - low) / (high - low);
+    }
+  }
+  return std::min(1.0, fraction / static_cast<double>(bounds.size()));
+}
+
+double ColumnStatistics::fractionEqual(ValueType value) const {
+  if (value < min || value > max || distinct == 0) {
+    return 0;
+  }
+  // A frequent value is the bound of every bucket it fills
+  const auto [first, last] =
+      std::equal_range(bounds.begin(), bounds.end(), value);
+  const double repeated =
+      bounds.empty() ? 0
+                     : static_cast<double>(last - first) /
+                           static_cast<double>(bounds.size());
+  return std::max(1.0 / static_cast<double>(distinct), repeated);
+}
+
+double ColumnStatistics::selectivity(std::string_view op,
+                                     ValueType value) const {
+  const auto atMostBelow = [this](ValueType bound) {
+    return bound == Table::ValueTypeMin ? 0.0 : fractionAtMost(bound - 1);
+  };
+  if (op == "=") {
+    return fractionEqual(value);
+  }
+  if (op == "<") {
+    return atMostBelow(value);
+  }
+  if (op == "<=") {
+    return fractionAtMost(value);
+  }
+  if (op == ">") {
+    return 1 - fractionAtMost(value);
+  }
+  if (op == ">=") {
+    return 1 - atMostBelow(value);
+  }
+  return 1;
+}
+
+std::shared_ptr<TableStatistics> TableStatistics::build(const Table &table) {
+  auto stats = std::make_shared<TableStatistics>();
+  stats->rowCount = table.size();
+  stats->blockCount = table.blockCount();
+  stats->fieldCount = table.field().size();
+  const size_t fields = stats->fieldCount;
+  const size_t blocks = stats->blockCount;
+  stats->zones.assign(blocks * fields,
+                      {Table::ValueTypeMax, Table::ValueTypeMin});
+  stats->zoneValid = std::make_unique<std::atomic<bool>[]>(blocks);
+
+  size_t parts = 1;
+  if (ThreadPool::isInitialized() && blocks > 1) [[likely]] {
+    parts = std::min(blocks, ThreadPool::getInstance().getThreadCount());
+  }
+  // Each part of the blocks counts distinct values in registers of its own
+  std::vector<std::vector<Registers>> partials(
+      parts, std::vector<Registers>(fields));
+  forEachPart(parts, [&](size_t part) {
+    auto &registers = partials[part];
+    for (size_t block = blocks * part / parts;
+         block < blocks * (part + 1) / parts; ++block) {
+      auto *zone = stats->zones.data() + block * fields;
+      for (const Datum &row : table.blockRowsOf(block)) [[likely]] {
+        const auto &values = row.datumConstRef();
+        for (size_t field = 0; field < fields; ++field) [[likely]] {
+          const ValueType value = values[field];
+          zone[field].first = std::min(zone[field].first, value);
+          zone[field].second = std::max(zone[field].second, value);
+          addToRegisters(registers[field], value);
+        }
+      }
+      stats->zoneValid[block].store(true, std::memory_order_relaxed);
+    }
+  });
+
+  // Every row is sampled, or a spread of them
+  const size_t step = std::max<size_t>(1, table.size() / kSampleRows);
+  std::vector<std::vector<ValueType>> samples(fields);
+  for (size_t row = 0; row < table.size(); row += step) [[likely]] {
+    const auto &values =
+        table.blockRowsOf(row / Table::blockRows())[row % Table::blockRows()]
+            .datumConstRef();
+    for (size_t field = 0; field < fields; ++field) [[likely]] {
+      samples[field].push_back(values[field]);
+    }
+  }
+
+  stats->columns.resize(fields);
+  for (size_t field = 0; field < fields; ++field) [[likely]] {
+    auto &column = stats->columns[field];
+    Registers merged{};
+    for (const auto &partial : partials) {
+      for (size_t slot = 0; slot < kRegisters; ++slot) {
+        merged[slot] = std::max(merged[slot], partial[field][slot]);
+      }
+    }
+    column.distinct = estimateDistinct(merged, table.size());
+
+    auto &sample = samples[field];
+    if (sample.empty()) [[unlikely]] {
+      continue;
+    }
+    std::ranges::sort(sample);
+    column.min = Table::ValueTypeMax;
+    column.max = Table::ValueTypeMin;
+    for (size_t block = 0; block < blocks; ++block) [[likely]] {
+      const auto [low, high] = stats->zones[block * fields + field];
+      column.min = std::min(column.min, low);
+      column.max = std::max(column.max, high);
+    }
+    const size_t buckets = std::min(kBuckets, sample.size());
+    column.bounds.reserve(buckets);
+    for (size_t bucket = 1; bucket <= buckets; ++bucket) [[likely]] {
+      column.bounds.push_back(sample[sample.size() * bucket / buckets - 1]);
+    }
+  }
+  return stats;
+}
+
+bool TableStatistics::mayMatch(size_t block, size_t field, std::string_view op,
+                               ValueType value) const {
+  if (block >= blockCount || field >= fieldCount ||
+      !zoneValid[block].load(std::memory_order_relaxed)) [[unlikely]] {
+    return true;
+  }
+  const auto [low, high] = zones[block * fieldCount + field];
+  if (op == "=") {
+    return low <= value && value <= high;
+  }
+  if (op == "<") {
+    return low < value;
+  }
+  if (op == "<=") {
+    return low <= value;
+  }
+  if (op == ">") {
+    return high > value;
+  }
+  if (op == ">=") {
+    return high >= value;
+  }
+  return true;
+}
+
+void TableStatistics::touchAll() {
+  for (size_t block = 0; block < blockCount; ++block) {
+    touch(block);
+  }
+}
+
+bool TableStatistics::isStale(size_t currentBlocks) const {
+  const size_t added = currentBlocks > blockCount ? currentBlocks - blockCount
+                                                  : blockCount - currentBlocks;
+  const size_t changed = staleBlocks.load(std::memory_order_relaxed) + added;
+  return changed != 0 && changed * kStaleFraction >= blockCount;
+}
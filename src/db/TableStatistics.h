@@ -0,0 +1,142 @@
+#ifndef PROJECT_DB_TABLE_STATISTICS_H
+#define PROJECT_DB_TABLE_STATISTICS_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "types.h"
+
+/**
+ * ColumnStatistics: the distribution of the values of one field
+ */
+struct ColumnStatistics {
+  ValueType min = 0;
+  ValueType max = 0;
+  /** Approximate number of distinct values (HyperLogLog) */
+  size_t distinct = 0;
+  /**
+   * Equi-depth histogram of a sample of the values: bucket i holds the
+   * values in (bounds[i - 1], bounds[i]], about as many in each bucket.
+   * A value that fills several buckets repeats as their bound.
+   */
+  std::vector<ValueType> bounds;
+
+  /**
+   * Estimate the fraction of rows a condition on the field keeps
+   * @param op The condition operator
+   * @param value The constant the field is compared with
+   * @return the fraction in [0, 1]; 1 for an unknown operator
+   */
+  [[nodiscard]] double selectivity(std::string_view op, ValueType value) const;
+
+private:
+  /** Estimate the fraction of values at most value */
+  [[nodiscard]] double fractionAtMost(ValueType value) const;
+  /** Estimate the fraction of values equal to value */
+  [[nodiscard]] double fractionEqual(ValueType value) const;
+};
+
+/**
+ * TableStatistics: what ANALYZE learned about the rows of a table
+ *
+ * Besides the statistics of each field, it keeps a zone map: the minimum and
+ * maximum of each field in each block of rows, so a scan can skip blocks
+ * none of whose rows can meet a condition. The writers of the table report
+ * the blocks they are about to change (see touch); from then on the zone of
+ * such a block is not trusted, so skipping stays exact however stale the
+ * rest of the statistics get. Once enough blocks changed or were added, the
+ * table builds them again (see isStale).
+ *
+ * Everything but the zone flags is immutable once built, so readers share
+ * one object without locking; writers clear flags from several threads at
+ * once, and a snapshot of the table keeps sharing them with it (a flag
+ * cleared for a block the snapshot did not see change only costs it a
+ * skipped skip).
+ */
+class TableStatistics {
+public:
+  /** Buckets of each histogram */
+  static constexpr size_t kBuckets = 64;
+  /** Rows sampled for the histograms at most */
+  static constexpr size_t kSampleRows = size_t{1} << 14U;
+  /** Statistics are stale once this fraction of the blocks changed */
+  static constexpr size_t kStaleFraction = 8;
+
+  TableStatistics() = default;
+  TableStatistics(const TableStatistics &) = delete;
+  TableStatistics &operator=(const TableStatistics &) = delete;
+  TableStatistics(TableStatistics &&) = delete;
+  TableStatistics &operator=(TableStatistics &&) = delete;
+  ~TableStatistics() = default;
+
+  /**
+   * Gather the statistics of every field, and the zone map, in one pass
+   * over the rows (in parallel when the thread pool has several threads)
+   * @param table The table; no writer may run meanwhile
+   * @return the statistics
+   */
+  [[nodiscard]] static std::shared_ptr<TableStatistics>
+  build(const Table &table);
+
+  /** Get the number of rows when the statistics were built */
+  [[nodiscard]] size_t rows() const { return rowCount; }
+
+  /** Get the number of blocks when the statistics were built */
+  [[nodiscard]] size_t blocks() const { return blockCount; }
+
+  /** Get the statistics of a field */
+  [[nodiscard]] const ColumnStatistics &column(size_t field) const {
+    return columns[field];
+  }
+
+  /**
+   * Check whether a block may hold a row that meets a condition
+   * @param block The block index
+   * @param field The field of the condition
+   * @param op The condition operator
+   * @param value The constant the field is compared with
+   * @return false only if the block's zone is trusted and excludes every row
+   */
+  [[nodiscard]] bool mayMatch(size_t block, size_t field, std::string_view op,
+                              ValueType value) const;
+
+  /**
+   * Report that the rows of a block are about to change; writers may call
+   * this from several threads at once, for distinct blocks
+   * @param block The block index; blocks past the zone map are ignored
+   */
+  void touch(size_t block) {
+    if (block < blockCount &&
+        zoneValid[block].load(std::memory_order_relaxed)) [[unlikely]] {
+      if (zoneValid[block].exchange(false, std::memory_order_relaxed)) {
+        staleBlocks.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /** Report that rows may have moved between any blocks */
+  void touchAll();
+
+  /**
+   * Check whether the table changed enough to build the statistics again
+   * @param currentBlocks The number of blocks the table has now
+   */
+  [[nodiscard]] bool isStale(size_t currentBlocks) const;
+
+private:
+  size_t rowCount = 0;
+  size_t blockCount = 0;
+  size_t fieldCount = 0;
+  std::vector<ColumnStatistics> columns;
+  /** Minimum and maximum of each field, at block * fieldCount + field */
+  std::vector<std::pair<ValueType, ValueType>> zones;
+  /** Whether each block is unchanged since the statistics were built */
+  std::unique_ptr<std::atomic<bool>[]> zoneValid;
+  std::atomic<size_t> staleBlocks{0};
+};
+
+#endif  // PROJECT_DB_TABLE_STATISTICS_H
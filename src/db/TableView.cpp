@@ -0,0 +1,183 @@
+#include "TableView.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "Datum.h"
+#include "Table.h"
+
+namespace {
+const Datum &rowAt(const Table &table, size_t row) {
+  return table.blockRowsOf(row / Table::blockRows())[row % Table::blockRows()];
+}
+
+/** Build a view from every row of the table */
+void rebuild(const Table &table, TableView &view) {
+  view.reset();
+  for (Table::SizeType block = 0; block < table.blockCount(); ++block)
+      [[likely]] {
+    for (const Datum &row : table.blockRowsOf(block)) [[likely]] {
+      view.apply(row);
+    }
+  }
+}
+}  // namespace
+
+bool TableViewSet::read(const Table &table, std::string_view name,
+                        const std::function<void(const TableView &)> &reader) {
+  const std::scoped_lock lock(mutex);
+  const auto found = views.find(name);
+  if (found == views.end()) [[likely]] {
+    return false;
+  }
+  flush(table);
+  auto &entry = found->second;
+  if (!entry.current) [[unlikely]] {
+    rebuild(table, *entry.view);
+    entry.current = true;
+    updateFollowing();
+  }
+  reader(*entry.view);
+  return true;
+}
+
+bool TableViewSet::isHot(std::string_view name) {
+  const std::scoped_lock lock(mutex);
+  if (views.size() >= kMaxViews) [[unlikely]] {
+    return false;
+  }
+  auto found = lookups.find(name);
+  if (found == lookups.end()) {
+    if (lookups.size() >= kMaxCountedLookups) [[unlikely]] {
+      lookups.clear();
+    }
+    found = lookups.emplace(std::string(name), 0).first;
+  }
+  return ++found->second >= kPromoteAfter;
+}
+
+bool TableViewSet::contains(std::string_view name) {
+  const std::scoped_lock lock(mutex);
+  return views.contains(name);
+}
+
+bool TableViewSet::wants(std::string_view name) {
+  const std::scoped_lock lock(mutex);
+  if (views.contains(name)) {
+    return true;
+  }
+  const auto found = lookups.find(name);
+  return views.size() < kMaxViews && found != lookups.end() &&
+         found->second >= kPromoteAfter;
+}
+
+void TableViewSet::add(const Table &table, std::string name,
+                       std::unique_ptr<TableView> view) {
+  const std::scoped_lock lock(mutex);
+  if (views.size() >= kMaxViews || views.contains(name)) [[unlikely]] {
+    return;
+  }
+  flush(table);
+  rebuild(table, *view);
+  if (const auto found = lookups.find(name); found != lookups.end()) {
+    lookups.erase(found);
+  }
+  views.emplace(std::move(name), Entry{std::move(view), true});
+  updateFollowing();
+}
+
+void TableViewSet::beforeChange(const Table &table, size_t row) {
+  const std::scoped_lock lock(mutex);
+  if (!isFollowing() || changed.contains(row)) {
+    return;
+  }
+  if (changed.size() >= followLimit(table)) [[unlikely]] {
+    invalidateAll();
+    return;
+  }
+  const Datum &datum = rowAt(table, row);
+  for (auto &[name, entry] : views) [[likely]] {
+    if (entry.current && !entry.view->retract(datum)) [[unlikely]] {
+      entry.current = false;
+    }
+  }
+  changed.insert(row);
+  updateFollowing();
+}
+
+void TableViewSet::added(const Datum &row) {
+  const std::scoped_lock lock(mutex);
+  for (auto &[name, entry] : views) [[likely]] {
+    if (entry.current) [[likely]] {
+      entry.view->apply(row);
+    }
+  }
+}
+
+void TableViewSet::beforeRemove(const Table &table,
+                                std::span<const size_t> rows) {
+  const std::scoped_lock lock(mutex);
+  if (!isFollowing()) [[unlikely]] {
+    return;
+  }
+  if (rows.size() >= followLimit(table)) [[unlikely]] {
+    invalidateAll();
+    return;
+  }
+  // The changed rows are known by index, which the removal shifts
+  flush(table);
+  for (auto &[name, entry] : views) [[likely]] {
+    for (const size_t row : rows) [[likely]] {
+      if (!entry.current) [[unlikely]] {
+        break;
+      }
+      entry.current = entry.view->retract(rowAt(table, row));
+    }
+  }
+  updateFollowing();
+}
+
+void TableViewSet::invalidate() {
+  const std::scoped_lock lock(mutex);
+  invalidateAll();
+}
+
+void TableViewSet::flush(const Table &table) {
+  for (const size_t row : changed) [[likely]] {
+    const Datum &datum = rowAt(table, row);
+    for (auto &[name, entry] : views) [[likely]] {
+      if (entry.current) [[likely]] {
+        entry.view->apply(datum);
+      }
+    }
+  }
+  changed.clear();
+}
+
+void TableViewSet::invalidateAll() {
+  for (auto &[name, entry] : views) [[likely]] {
+    entry.current = false;
+  }
+  changed.clear();
+  following.store(false, std::memory_order_relaxed);
+}
+
+void TableViewSet::updateFollowing() {
+  const bool any = std::ranges::any_of(
+      views, [](const auto &named) { return named.second.current; });
+  if (!any) [[unlikely]] {
+    changed.clear();
+  }
+  following.store(any, std::memory_order_relaxed);
+}
+
+size_t TableViewSet::followLimit(const Table &table) {
+  return std::max(Table::blockRows(), table.size() / kFollowedFraction);
+}
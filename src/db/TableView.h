@@ -0,0 +1,182 @@
+#ifndef PROJECT_DB_TABLE_VIEW_H
+#define PROJECT_DB_TABLE_VIEW_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+#include "Datum.h"
+
+class Table;
+
+/**
+ * TableView: state derived from the rows of a table, such as the running
+ * aggregate of a query, that is kept up to date as the rows change instead
+ * of being computed again from all of them (see TableViewSet)
+ */
+class TableView {
+public:
+  TableView() = default;
+  TableView(const TableView &) = delete;
+  TableView &operator=(const TableView &) = delete;
+  TableView(TableView &&) = delete;
+  TableView &operator=(TableView &&) = delete;
+  virtual ~TableView() = default;
+
+  /** Empty the state, as for a table without rows */
+  virtual void reset() = 0;
+
+  /**
+   * Add a row to the state: it was inserted, or holds its new values
+   * @param row The row
+   */
+  virtual void apply(const Datum &row) = 0;
+
+  /**
+   * Take a row out of the state: it is about to change or be deleted
+   * @param row The row, with the values it was applied with
+   * @return false if the state cannot follow without seeing every row again
+   * (e.g. a minimum was taken out); the view is then rebuilt before it is
+   * next read
+   */
+  virtual bool retract(const Datum &row) = 0;
+};
+
+/**
+ * TableViewSet: the views of one table, each named by the query it answers
+ *
+ * A read query that is looked up often enough (see isHot) is given a view,
+ * which is built with one pass over the rows. From then on the table's
+ * writers report their changes: a row about to change is retracted from
+ * every view and remembered, and it is applied again with its new values
+ * when a view is next read; inserted rows are applied, and deleted ones
+ * retracted, as they go. Reading a view then costs as much as the rows
+ * written since it was last read.
+ *
+ * When more rows change at once than pay off to follow one by one (a
+ * fraction of the table), and on TRUNCATE, the views are dropped to be
+ * rebuilt when they are next read, and writers stop reporting until then.
+ *
+ * Writers call in under the table's write lock, from several threads at once
+ * if they split their work; readers under its read lock. The set has a mutex
+ * of its own, so the writer hooks cost one flag load while no view is
+ * followed.
+ */
+class TableViewSet {
+public:
+  /** Views a table keeps at most; each costs every writer some work */
+  static constexpr size_t kMaxViews = 16;
+  /** Lookups of a query after which it gets a view */
+  static constexpr unsigned kPromoteAfter = 3;
+  /** Queries whose lookups are counted at once */
+  static constexpr size_t kMaxCountedLookups = 256;
+  /** Changed rows are followed up to this fraction of the table */
+  static constexpr size_t kFollowedFraction = 8;
+
+  TableViewSet() = default;
+  TableViewSet(const TableViewSet &) = delete;
+  TableViewSet &operator=(const TableViewSet &) = delete;
+  TableViewSet(TableViewSet &&) = delete;
+  TableViewSet &operator=(TableViewSet &&) = delete;
+  ~TableViewSet() = default;
+
+  /** Check whether writers have to report their changes */
+  [[nodiscard]] bool isFollowing() const {
+    return following.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Bring a view up to date and read it
+   * @param table The table of the set
+   * @param name The query the view answers
+   * @param reader Called with the view
+   * @return false if there is no such view
+   */
+  bool read(const Table &table, std::string_view name,
+            const std::function<void(const TableView &)> &reader);
+
+  /**
+   * Count a lookup of a query that has no view
+   * @param name The query
+   * @return true if the query should get a view now
+   */
+  [[nodiscard]] bool isHot(std::string_view name);
+
+  /**
+   * Check whether a query has a view
+   * @param name The query
+   */
+  [[nodiscard]] bool contains(std::string_view name);
+
+  /**
+   * Check whether a query has a view, or is hot enough to get one
+   * @param name The query
+   */
+  [[nodiscard]] bool wants(std::string_view name);
+
+  /**
+   * Build a view and keep it up to date from now on; nothing happens if the
+   * name has a view already, or the set is full
+   * @param table The table of the set
+   * @param name The query the view answers
+   * @param view The view, in any state
+   */
+  void add(const Table &table, std::string name,
+           std::unique_ptr<TableView> view);
+
+  /**
+   * Report a row about to be changed in place
+   * @param table The table of the set
+   * @param row The row index
+   */
+  void beforeChange(const Table &table, size_t row);
+
+  /**
+   * Report a row just inserted
+   * @param row The row
+   */
+  void added(const Datum &row);
+
+  /**
+   * Report rows about to be deleted, before any row moves
+   * @param table The table of the set
+   * @param rows The row indices
+   */
+  void beforeRemove(const Table &table, std::span<const size_t> rows);
+
+  /** Report that the rows changed beyond following; the views rebuild */
+  void invalidate();
+
+private:
+  struct Entry {
+    std::unique_ptr<TableView> view;
+    /** Whether the view follows the rows, rather than awaits a rebuild */
+    bool current = false;
+  };
+
+  std::mutex mutex;
+  std::map<std::string, Entry, std::less<>> views;
+  std::map<std::string, unsigned, std::less<>> lookups;
+  /** Rows retracted from the current views, to apply again once read */
+  std::unordered_set<size_t> changed;
+  /** Some view is current */
+  std::atomic<bool> following{false};
+
+  /** Apply the changed rows to the current views; the mutex is held */
+  void flush(const Table &table);
+  /** Mark every view for a rebuild; the mutex is held */
+  void invalidateAll();
+  /** Refresh whether writers report; the mutex is held */
+  void updateFollowing();
+  /** Get the most changed rows worth following */
+  [[nodiscard]] static size_t followLimit(const Table &table);
+};
+
+#endif  // PROJECT_DB_TABLE_VIEW_H
@@ -1,45 +1,111 @@
 #include <cstddef>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "../threading/EpochManager.h"
 #include "Table.h"
 
 void Table::setName(const std::string &name) { this->tableName = name; }
 
 const std::string &Table::name() const { return this->tableName; }
 
-bool Table::empty() const { return this->data.empty(); }
+bool Table::empty() const { return this->rowCount == 0; }
 
-size_t Table::size() const { return this->data.size(); }
+size_t Table::size() const { return this->rowCount; }
 
 const std::vector<Table::FieldNameType> &Table::field() const {
   return this->fields;
 }
 
+namespace {
+// Each heap allocation carries allocator overhead
+constexpr size_t kAllocOverhead = 16;
+
+/** Estimated bytes of a row in a block, with its field values */
+constexpr size_t rowBytes(size_t fieldCount) {
+  return sizeof(Datum) + fieldCount * sizeof(Table::ValueType) +
+         kAllocOverhead;
+}
+
+/** Estimated bytes of a key index node: the key, the row index and a link */
+constexpr size_t keyNodeBytes() {
+  return sizeof(std::pair<const Table::KeyType, Table::SizeType>) +
+         sizeof(void *) * 2 + kAllocOverhead;
+}
+}  // namespace
+
+size_t Table::estimateBytes(size_t rows, size_t fieldCount) {
+  return rows * (rowBytes(fieldCount) + keyNodeBytes());
+}
+
+size_t Table::storageBytes() const {
+  size_t rows = 0;
+  for (const auto &block : blocks) {
+    if (block.use_count() == 1) [[likely]] {
+      rows += block->size();
+    }
+  }
+  size_t bytes = rows * rowBytes(fields.size());
+  if (keyMap != nullptr && keyMap.use_count() == 1) [[likely]] {
+    bytes += keyMap->size() * keyNodeBytes();
+  }
+  return bytes;
+}
+
 size_t Table::clear() {
-  auto result = keyMap.size();
-  data.clear();
-  keyMap.clear();
+  /** The storage let go of, destroyed once no thread can read it */
+  struct ReleasedStorage {
+    std::vector<std::shared_ptr<Block>> blocks;
+    std::shared_ptr<KeyMap> keyMap;
+  };
+  noteWrite();
+  viewSet.invalidate();
+  {
+    const std::scoped_lock lock(statsMutex);
+    stats = nullptr;
+  }
+  auto result = rowCount;
+  const size_t bytes = storageBytes();
+  EpochManager::getInstance().retire(
+      std::make_unique<ReleasedStorage>(
+          ReleasedStorage{std::exchange(blocks, {}), std::move(keyMap)}),
+      bytes);
+  rowCount = 0;
+  keyMap = std::make_shared<KeyMap>();
+  allDirty = true;
+  dirtyBlocks.clear();
   return result;
 }
 
 void Table::drop() {
+  noteWrite();
+  viewSet.invalidate();
+  {
+    const std::scoped_lock lock(statsMutex);
+    stats = nullptr;
+  }
   queryQueueCounter = 0;
   fields.clear();
   fieldMap.clear();
-  data.clear();
-  keyMap.clear();
+  blocks.clear();
+  rowCount = 0;
+  keyMap = std::make_shared<KeyMap>();
+  allDirty = true;
+  dirtyBlocks.clear();
   queryQueueMutex.lock();
   initialized = false;
   queryQueueMutex.unlock();
 }
 
-Table::Iterator Table::begin() { return {data.begin(), this}; }
+Table::Iterator Table::begin() { return {0, this}; }
 
-Table::Iterator Table::end() { return {data.end(), this}; }
+Table::Iterator Table::end() { return {rowCount, this}; }
 
-Table::ConstIterator Table::begin() const { return {data.cbegin(), this}; }
+Table::ConstIterator Table::begin() const { return {0, this}; }
 
-Table::ConstIterator Table::end() const { return {data.cend(), this}; }
+Table::ConstIterator Table::end() const { return {rowCount, this}; }
 
 bool Table::isInited() const { return initialized; }
@@ -0,0 +1,333 @@
+#include "WriteAheadLog.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "RecordFraming.h"
+
+namespace {
+using RecordFraming::getU32;
+using RecordFraming::getU64;
+using RecordFraming::kRecordHeaderBytes;
+using RecordFraming::putU32;
+using RecordFraming::putU64;
+
+constexpr std::string_view kMagic = "LWAL";
+constexpr uint32_t kVersion = 2;
+constexpr size_t kHeaderBytes = 16;
+constexpr size_t kReadBlockBytes = size_t{1} << 20U;
+
+std::string makeHeader(uint64_t firstSequence) {
+  std::string header(kMagic);
+  putU32(header, kVersion);
+  putU64(header, firstSequence);
+  return header;
+}
+
+void reportError(const char *what) {
+  std::cerr << "lemondb: error: write-ahead log: " << what << ": "
+            << std::system_category().message(errno) << '\n';
+}
+}  // namespace
+
+WriteAheadLog::~WriteAheadLog() { close(); }
+
+std::optional<WriteAheadLog::SyncPolicy>
+WriteAheadLog::parsePolicy(std::string_view name) {
+  if (name == "commit") {
+    return SyncPolicy::Commit;
+  }
+  if (name == "interval") {
+    return SyncPolicy::Interval;
+  }
+  if (name == "off") {
+    return SyncPolicy::Off;
+  }
+  return std::nullopt;
+}
+
+void WriteAheadLog::setSyncPolicy(SyncPolicy policy,
+                                  std::chrono::milliseconds interval) {
+  this->policy = policy;
+  syncInterval = interval;
+}
+
+std::optional<size_t> WriteAheadLog::open(const std::string &path,
+                                          const Replayer &replay,
+                                          uint64_t firstSequence) {
+  constexpr mode_t fileMode = 0644;
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+  fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, fileMode);
+  if (fd < 0) [[unlikely]] {
+    return std::nullopt;
+  }
+  size_t count = 0;
+  if (!replayRecords(replay, firstSequence, count)) [[unlikely]] {
+    ::close(fd);
+    fd = -1;
+    return std::nullopt;
+  }
+  this->path = path;
+
+  stopping = false;
+  flusher = std::thread(&WriteAheadLog::flushLoop, this);
+  enabled.store(true, std::memory_order_relaxed);
+  return count;
+}
+
+void WriteAheadLog::append(std::string_view statement, Callback onDurable) {
+  if (!isEnabled()) [[unlikely]] {
+    if (onDurable) {
+      onDurable();
+    }
+    return;
+  }
+
+  std::unique_lock lock(mutex);
+  pendingChanged.wait(lock, [this] {
+    return pending.size() < kMaxPendingBytes || stopping;
+  });
+  RecordFraming::putRecord(pending, statement);
+  ++nextSequence;
+  appendedBytes += kRecordHeaderBytes + statement.size();
+  const bool held = policy == SyncPolicy::Commit;
+  if (held) [[likely]] {
+    pendingCallbacks.push_back(std::move(onDurable));
+  }
+  const bool wake = held || pending.size() >= kWriteBatchBytes;
+  lock.unlock();
+  if (wake) {
+    pendingChanged.notify_all();
+  }
+
+  if (!held && onDurable) {
+    onDurable();
+  }
+}
+
+WriteAheadLog::Position WriteAheadLog::position() {
+  const std::scoped_lock lock(mutex);
+  return {nextSequence, appendedBytes};
+}
+
+bool WriteAheadLog::truncate(const Position &cut) {
+  if (!isEnabled()) [[unlikely]] {
+    return true;
+  }
+  {
+    // Everything before the cut has to be in the file to be dropped from it
+    std::unique_lock lock(mutex);
+    flushRequested = true;
+    pendingChanged.notify_all();
+    pendingChanged.wait(
+        lock, [this, &cut] { return writtenBytes >= cut.offset || stopping; });
+    if (writtenBytes < cut.offset) [[unlikely]] {
+      return false;
+    }
+  }
+
+  const std::scoped_lock fileLock(fileMutex);
+  uint64_t end = 0;
+  {
+    const std::scoped_lock lock(mutex);
+    end = writtenBytes;
+  }
+  std::string contents = makeHeader(cut.sequence);
+  const size_t tailBytes = static_cast<size_t>(end - cut.offset);
+  contents.resize(kHeaderBytes + tailBytes);
+  size_t copied = 0;
+  while (copied < tailBytes) {
+    const ssize_t got =
+        ::pread(fd, contents.data() + kHeaderBytes + copied,
+                tailBytes - copied, static_cast<off_t>(cut.offset + copied));
+    if (got < 0 && errno == EINTR) [[unlikely]] {
+      continue;
+    }
+    if (got <= 0) [[unlikely]] {
+      reportError("read");
+      return false;
+    }
+    copied += static_cast<size_t>(got);
+  }
+
+  // Write the new log next to the old one and swap them atomically
+  const std::string temporary = path + ".tmp";
+  constexpr mode_t fileMode = 0644;
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+  const int file = ::open(temporary.c_str(),
+                          O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, fileMode);
+  if (file < 0) [[unlikely]] {
+    reportError("open");
+    return false;
+  }
+  if (!writeAll(file, contents) || ::fdatasync(file) != 0 ||
+      ::rename(temporary.c_str(), path.c_str()) != 0) [[unlikely]] {
+    reportError("truncate");
+    ::close(file);
+    ::unlink(temporary.c_str());
+    return false;
+  }
+  ::close(fd);
+  fd = file;
+
+  const std::scoped_lock lock(mutex);
+  const uint64_t dropped = cut.offset - kHeaderBytes;
+  writtenBytes -= dropped;
+  appendedBytes -= dropped;
+  return true;
+}
+
+void WriteAheadLog::close() {
+  if (!enabled.exchange(false)) {
+    return;
+  }
+  {
+    const std::scoped_lock lock(mutex);
+    stopping = true;
+  }
+  pendingChanged.notify_all();
+  flusher.join();
+  ::close(fd);
+  fd = -1;
+}
+
+void WriteAheadLog::flushLoop() {
+  std::string writing;
+  std::vector<Callback> callbacks;
+  auto lastSync = std::chrono::steady_clock::now();
+  bool unsynced = false;
+
+  std::unique_lock lock(mutex);
+  while (true) {
+    if (policy == SyncPolicy::Commit) [[likely]] {
+      pendingChanged.wait(lock, [this] {
+        return stopping || flushRequested || !pending.empty();
+      });
+    } else {
+      pendingChanged.wait_for(lock, syncInterval, [this] {
+        return stopping || flushRequested ||
+               pending.size() >= kWriteBatchBytes;
+      });
+    }
+    writing.swap(pending);
+    callbacks.swap(pendingCallbacks);
+    flushRequested = false;
+    const bool finishing = stopping;
+    lock.unlock();
+    pendingChanged.notify_all();  // Room for appends waiting on the limit
+
+    {
+      const std::scoped_lock fileLock(fileMutex);
+      if (!writing.empty()) {
+        if (!writeAll(fd, writing)) [[unlikely]] {
+          reportError("write");
+        }
+        unsynced = true;
+      }
+      const auto now = std::chrono::steady_clock::now();
+      const bool syncDue =
+          policy == SyncPolicy::Commit || finishing ||
+          (policy == SyncPolicy::Interval && now - lastSync >= syncInterval);
+      if (unsynced && syncDue) {
+        if (::fdatasync(fd) != 0) [[unlikely]] {
+          reportError("fdatasync");
+        }
+        lastSync = now;
+        unsynced = false;
+      }
+      // Counted before fileMutex is released, so truncate() sees the file
+      // and the offset agree
+      const std::scoped_lock counterLock(mutex);
+      writtenBytes += writing.size();
+    }
+    writing.clear();
+    pendingChanged.notify_all();  // Wakes truncate() waiting for the write
+
+    for (auto &callback : callbacks) {
+      callback();
+    }
+    callbacks.clear();
+
+    lock.lock();
+    if (finishing && pending.empty()) {
+      return;
+    }
+  }
+}
+
+bool WriteAheadLog::writeAll(int file, std::string_view data) {
+  while (!data.empty()) {
+    const ssize_t written = ::write(file, data.data(), data.size());
+    if (written < 0) [[unlikely]] {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data.remove_prefix(static_cast<size_t>(written));
+  }
+  return true;
+}
+
+bool WriteAheadLog::replayRecords(const Replayer &replay,
+                                  uint64_t firstSequence, size_t &count) {
+  std::string contents;
+  std::vector<char> block(kReadBlockBytes);
+  while (true) {
+    const ssize_t got = ::read(fd, block.data(), block.size());
+    if (got < 0 && errno == EINTR) [[unlikely]] {
+      continue;
+    }
+    if (got < 0) [[unlikely]] {
+      return false;
+    }
+    if (got == 0) {
+      break;
+    }
+    contents.append(block.data(), static_cast<size_t>(got));
+  }
+
+  if (contents.empty()) {
+    nextSequence = firstSequence;
+    appendedBytes = writtenBytes = kHeaderBytes;
+    return writeAll(fd, makeHeader(firstSequence));
+  }
+  const std::string_view data = contents;
+  if (data.size() < kHeaderBytes || !data.starts_with(kMagic) ||
+      getU32(data, kMagic.size()) != kVersion) [[unlikely]] {
+    return false;
+  }
+
+  nextSequence = getU64(data, kMagic.size() + 4);
+  size_t offset = kHeaderBytes;
+  while (const auto statement = RecordFraming::getRecord(data, offset)) {
+    if (nextSequence >= firstSequence) [[likely]] {
+      replay(*statement);
+      ++count;
+    }
+    ++nextSequence;
+  }
+  appendedBytes = writtenBytes = offset;
+
+  // Cut off a torn tail so that new records follow the last good one
+  if (offset < data.size()) [[unlikely]] {
+    if (::ftruncate(fd, static_cast<off_t>(offset)) != 0) {
+      return false;
+    }
+  }
+  return ::lseek(fd, static_cast<off_t>(offset), SEEK_SET) >= 0;
+}
@@ -0,0 +1,180 @@
+#ifndef PROJECT_WRITE_AHEAD_LOG_H
+#define PROJECT_WRITE_AHEAD_LOG_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * WriteAheadLog: optional redo log of writer queries
+ *
+ * Every successful writer query (see Query::isWriter) is appended as one
+ * record holding its statement text; replaying the records in order on an
+ * empty database rebuilds the tables. Records are appended in execution
+ * order, so each table sees its own queries in order and COPYTABLE is logged
+ * after everything it copied.
+ *
+ * File layout: a 16 byte header ("LWAL", u32 version, u64 sequence number
+ * of the first record), then records of u32 payload length, u32 CRC-32 of
+ * the payload and the payload, all little endian. A torn or corrupt tail
+ * (crash during a write) ends replay and is cut off.
+ *
+ * Records are numbered consecutively across truncations. A checkpoint
+ * covers every record before some sequence number; truncate() then drops
+ * those records, and replay skips them if the process stopped in between.
+ *
+ * Appends only copy the record into a buffer. A single flusher thread writes
+ * whatever has accumulated with one write(2), then syncs according to the
+ * policy, so concurrent per-table writers share every fdatasync (group
+ * commit). With SyncPolicy::Commit a query's result is released (its
+ * completion callback runs) only once its record is durable; the table
+ * thread itself never waits and goes on with the next query. Without it
+ * nothing waits for a record, so the flusher only wakes up for a full batch
+ * or once per interval.
+ *
+ * LOAD is logged as the rows it loaded, LTC encoded (see TableCodec), rather
+ * than as its statement: the file may have been overwritten since, e.g. by
+ * a DUMP of the changed table.
+ */
+class WriteAheadLog {
+public:
+  enum class SyncPolicy {
+    /** fdatasync before releasing results (group commit) */
+    Commit,
+    /** fdatasync at most once per interval; results are not held */
+    Interval,
+    /** Leave syncing to the OS */
+    Off,
+  };
+
+  using Callback = std::function<void()>;
+  using Replayer = std::function<void(std::string_view)>;
+
+  /** The end of the log at some point: the next record and its offset */
+  struct Position {
+    uint64_t sequence = 0;
+    uint64_t offset = 0;
+  };
+
+  static constexpr std::chrono::milliseconds kDefaultSyncInterval{10};
+  /** Without SyncPolicy::Commit, pending records are written once this
+   *  much has accumulated or once per sync interval */
+  static constexpr size_t kWriteBatchBytes = size_t{64} << 10U;
+  /** Appends wait once this much is pending (the disk cannot keep up) */
+  static constexpr size_t kMaxPendingBytes = size_t{16} << 20U;
+
+  [[nodiscard]] static WriteAheadLog &getInstance() {
+    static WriteAheadLog instance;
+    return instance;
+  }
+
+  WriteAheadLog(const WriteAheadLog &) = delete;
+  WriteAheadLog &operator=(const WriteAheadLog &) = delete;
+  WriteAheadLog(WriteAheadLog &&) = delete;
+  WriteAheadLog &operator=(WriteAheadLog &&) = delete;
+  ~WriteAheadLog();
+
+  /**
+   * Parse a --wal-sync value
+   * @param name "commit", "interval" or "off"
+   * @return the policy, or nullopt for an unknown name
+   */
+  [[nodiscard]] static std::optional<SyncPolicy>
+  parsePolicy(std::string_view name);
+
+  /**
+   * Set how appended records are synced; call before open()
+   * @param policy The sync policy
+   * @param interval The longest time between syncs for SyncPolicy::Interval
+   */
+  void setSyncPolicy(SyncPolicy policy, std::chrono::milliseconds interval);
+
+  /**
+   * Open (or create) the log, replay its records and start logging
+   * @param path The log file
+   * @param replay Called with the statement of every record, in order
+   * @param firstSequence Records before this one are already checkpointed
+   *        and skipped; a new log starts numbering here
+   * @return the number of replayed records, or nullopt if the file cannot
+   *         be opened or is not a log
+   */
+  [[nodiscard]] std::optional<size_t> open(const std::string &path,
+                                           const Replayer &replay,
+                                           uint64_t firstSequence = 0);
+
+  /**
+   * Check whether writer queries are being logged
+   */
+  [[nodiscard]] bool isEnabled() const {
+    return enabled.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Log a writer query
+   * @param statement The statement text
+   * @param onDurable Called once the record is as durable as the policy
+   *        asks (possibly on the flusher thread, possibly right away)
+   */
+  void append(std::string_view statement, Callback onDurable);
+
+  /**
+   * Get the end of the log, i.e. the position after every record appended
+   * so far
+   */
+  [[nodiscard]] Position position();
+
+  /**
+   * Drop the records before a position once they are checkpointed. The
+   * records after it are copied to a new file that replaces the log, so this
+   * costs as much as what was logged since the position.
+   * @param cut A position returned by position()
+   * @return false if the new log could not be written (the old one is kept)
+   */
+  bool truncate(const Position &cut);
+
+  /**
+   * Write and sync everything pending, stop the flusher and close the file
+   */
+  void close();
+
+private:
+  WriteAheadLog() = default;
+
+  int fd = -1;
+  std::string path;
+  std::atomic<bool> enabled{false};
+  SyncPolicy policy = SyncPolicy::Commit;
+  std::chrono::milliseconds syncInterval = kDefaultSyncInterval;
+
+  std::mutex mutex;
+  std::condition_variable pendingChanged;
+  std::string pending;
+  std::vector<Callback> pendingCallbacks;
+  uint64_t nextSequence = 0;
+  /** Offset of the end of the log, including pending records */
+  uint64_t appendedBytes = 0;
+  /** Offset up to which the file has been written */
+  uint64_t writtenBytes = 0;
+  bool flushRequested = false;
+  bool stopping = false;
+  std::thread flusher;
+  /** Held while fd is written, synced or replaced; taken before mutex */
+  std::mutex fileMutex;
+
+  void flushLoop();
+  static bool writeAll(int file, std::string_view data);
+  /** Replay the records of fd, cutting off a bad tail; false if not a log */
+  bool replayRecords(const Replayer &replay, uint64_t firstSequence,
+                     size_t &count);
+};
+
+#endif  // PROJECT_WRITE_AHEAD_LOG_H
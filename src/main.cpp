@@ -10,8 +10,12 @@
 #include <optional>
 #include <thread>
 
+#include "db/Checkpointer.h"
 #include "db/Database.h"
+#include "db/LoadPrefetcher.h"
+#include "db/WriteAheadLog.h"
 #include "query/QueryParser.h"
+#include "query/ResultCache.h"
 #include "query/utils/ListenQuery.h"
 #include "threading/OutputPool.h"
 #include "threading/QueryManager.h"
@@ -20,13 +24,16 @@
 #include "utils/MainQueryHelpers.h"
 #include "utils/MainUtils.h"
 #include "utils/OutputConfig.h"
+#include "utils/ReadAhead.h"
 
 int main(int argc, char *argv[]) {
   try {
-    std::ios_base::sync_with_stdio(true);
+    // Results are written by the OutputSink, not through iostreams
+    std::ios_base::sync_with_stdio(false);
 
     Args parsedArgs{};
     MainUtils::parseArgs(argc, argv, parsedArgs);
+    MainIOHelpers::initializeTrace(parsedArgs);
 
     const bool is_small_workload =
         MainUtils::checkSmallWorkload(parsedArgs.listen);
@@ -41,15 +48,23 @@ int main(int argc, char *argv[]) {
     }
 
     MainIOHelpers::validateProductionMode(parsedArgs);
+    ReadAhead::getInstance().setUseMmap(parsedArgs.listenMmap);
+    if (parsedArgs.resultCache >= 0) {
+      ResultCache::getInstance().setCapacity(
+          static_cast<size_t>(parsedArgs.resultCache));
+    }
 
-    QueryParser parser;
-    MainUtils::setupParser(parser);
+    const QueryParser parser;
+    const auto checkpointed =
+        MainQueryHelpers::initializeCheckpoint(parsedArgs);
+    MainQueryHelpers::initializeWriteAheadLog(parsedArgs, parser, checkpointed);
 
     // Main loop: ASYNC query submission with table-level parallelism
     Database &database = Database::getInstance();
 
     // Create OutputPool (not a global singleton - passed by reference)
-    OutputPool output_pool;
+    const auto output_sink = MainIOHelpers::initializeOutputSink(parsedArgs);
+    OutputPool output_pool(*output_sink);
 
     // Create QueryManager with reference to OutputPool
     QueryManager query_manager(output_pool);
@@ -84,7 +99,12 @@ int main(int argc, char *argv[]) {
     }
 
     query_manager.waitForCompletion();
+    WriteAheadLog::getInstance().close();
+    Checkpointer::getInstance().close();
+    LoadPrefetcher::getInstance().shutdown();
+    ReadAhead::getInstance().shutdown();
     output_pool.outputAllResults();
+    MainIOHelpers::writeTrace(parsedArgs);
   } catch (...) {
     // TODO: NOTHING SHOULD BE HANDLED
     return -1;
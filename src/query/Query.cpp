@@ -5,25 +5,71 @@
 #include "Query.h"
 
 #include <algorithm>
-#include <cassert>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <exception>
 #include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <span>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <typeinfo>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "../db/Database.h"
 #include "../db/Table.h"
+#include "../db/TableLockManager.h"
+#include "../threading/Threadpool.h"
+#include "../utils/QueryProfile.h"
+#include "../utils/ResultBuffer.h"
 #include "../utils/formatter.h"
 #include "../utils/uexception.h"
+#include "QueryPlan.h"
+#include "QueryResult.h"
+#include "ResultCache.h"
+
+const QueryPlan::Resolution *
+ComplexQuery::resolvePlan(const Table &table) const {
+  if (plan == nullptr) [[unlikely]] {
+    return nullptr;
+  }
+  if (resolution == nullptr ||
+      resolution->generation != table.schemaGeneration()) [[unlikely]] {
+    resolution = plan->resolve(table);
+  }
+  return resolution.get();
+}
+
+Table::FieldIndex ComplexQuery::operandFieldIndex(const Table &table,
+                                                  size_t index) const {
+  const auto *resolved = resolvePlan(table);
+  if (resolved != nullptr && index < resolved->operands.size() &&
+      resolved->operands[index] != QueryPlan::kUnresolved) [[likely]] {
+    return resolved->operands[index];
+  }
+  return table.getFieldIndex(operands[index]);
+}
+
+bool ComplexQuery::isPointWriter() const {
+  return isWriter() && std::ranges::any_of(condition, [](const auto &cond) {
+           return cond.field == "KEY";
+         });
+}
 
 std::pair<std::string, bool> ComplexQuery::initCondition(const Table &table) {
-  static const std::unordered_map<std::string, int> opmap{
-      {">", '>'}, {"<", '<'}, {"=", '='}, {">=", 'g'}, {"<=", 'l'},
-  };
+  const QueryProfile::StageTimer timer(QueryProfile::Stage::ConditionInit);
+  const auto *resolved = resolvePlan(table);
   std::pair<std::string, bool> result = {"", true};
-  for (auto &cond : condition) [[likely]]
-  {
+  path = AccessPath::FullScan;
+  candidateBlocks.clear();
+  for (auto &cond : condition) [[likely]] {
+    const size_t index = cond.position;
     if (cond.field == "KEY") [[unlikely]] {
       if (cond.op != "=") [[unlikely]] {
         throw IllFormedQueryCondition("Can only compare equivalence on KEY");
@@ -37,72 +83,137 @@ std::pair<std::string, bool> ComplexQuery::initCondition(const Table &table) {
       cond.fieldId = static_cast<size_t>(-1);
     } else [[likely]] {
       constexpr int decimal_base = 10;
-      cond.fieldId = table.getFieldIndex(cond.field);
+      if (resolved != nullptr &&
+          resolved->conditions[index] != QueryPlan::kUnresolved) [[likely]] {
+        cond.fieldId = resolved->conditions[index];
+      } else {
+        cond.fieldId = table.getFieldIndex(cond.field);
+      }
       cond.valueParsed = static_cast<Table::ValueType>(
           std::strtol(cond.value.c_str(), nullptr, decimal_base));
 
-      const auto index = opmap.find(cond.op);
-      if (index == opmap.end()) {
+      cond.comp = resolved != nullptr ? plan->comparator(index)
+                                      : QueryPlan::comparatorFor(cond.op);
+      if (!cond.comp) [[unlikely]] {
         throw IllFormedQueryCondition(
             R"("?" is not a valid condition operator.)"_f % cond.op);
       }
+    }
+  }
+  if (!result.first.empty()) [[unlikely]] {
+    path = looksUpKeys() ? AccessPath::Index : AccessPath::FullScan;
+  } else if (!condition.empty()) {
+    choosePath(table);
+  }
+  return result;
+}
 
-      const int operator_index = index->second;
-      switch (operator_index) {
-      case '>':
-        cond.comp = std::greater<>();
-        break;
-      case '<':
-        cond.comp = std::less<>();
-        break;
-      case '=':
-        cond.comp = std::equal_to<>();
-        break;
-      case 'g':
-        cond.comp = std::greater_equal<>();
-        break;
-      case 'l':
-        cond.comp = std::less_equal<>();
+void ComplexQuery::choosePath(const Table &table) {
+  const auto stats = table.statistics();
+  if (stats == nullptr) [[likely]] {
+    return;
+  }
+  const auto selectivity = [&stats](const QueryCondition &cond) {
+    return stats->column(cond.fieldId).selectivity(cond.op, cond.valueParsed);
+  };
+  // Test first what rules out the most rows; the statement order breaks ties
+  std::ranges::stable_sort(condition, {}, selectivity);
+
+  double kept = 1;
+  for (const auto &cond : condition) [[likely]] {
+    kept *= selectivity(cond);  // As if the fields were independent
+  }
+  if (!skipsBlocks() || kept > kZoneMapSelectivity) [[likely]] {
+    return;
+  }
+  candidateBlocks.assign(table.blockCount(), 1);
+  size_t skipped = 0;
+  for (Table::SizeType block = 0; block < table.blockCount(); ++block) {
+    for (const auto &cond : condition) [[likely]] {
+      if (!stats->mayMatch(block, cond.fieldId, cond.op, cond.valueParsed)) {
+        candidateBlocks[block] = 0;
+        ++skipped;
         break;
-      default:
-        assert(0);  // should never be here
       }
     }
   }
-  return result;
+  if (skipped == 0) [[unlikely]] {
+    candidateBlocks.clear();
+    return;
+  }
+  path = AccessPath::ZoneMap;
+}
+
+const Table &
+ComplexQuery::readTable(TableLockManager::ReadLock &lock) {
+  if (snapshot != nullptr) {
+    return *snapshot;
+  }
+  lock = TableLockManager::getInstance().acquireRead(targetTableRef());
+  return Database::getInstance()[targetTableRef()];
 }
 
 bool ComplexQuery::evalCondition(const Table::Object &object) {
-  return std::all_of(condition.begin(), condition.end(),
-                     [&object](const auto &cond) {
-                       if (cond.fieldId == static_cast<size_t>(-1)) {
-                         return object.key() == cond.value;
-                       }
-                       return cond.comp(object[cond.fieldId], cond.valueParsed);
-                     });
+  const bool met = std::all_of(
+      condition.begin(), condition.end(), [&object](const auto &cond) {
+        if (cond.fieldId == static_cast<size_t>(-1)) {
+          return object.key() == cond.value;
+        }
+        return cond.comp(object[cond.fieldId], cond.valueParsed);
+      });
+  if (profile != nullptr) [[unlikely]] {
+    profile->countRow(met);
+  }
+  return met;
 }
 
 bool ComplexQuery::evalCondition(const Table::ConstObject &object) {
+  const bool met = std::all_of(
+      condition.begin(), condition.end(), [&object](const auto &cond) {
+        if (cond.fieldId == static_cast<size_t>(-1)) {
+          return object.key() == cond.value;
+        }
+        return cond.comp(object[cond.fieldId], cond.valueParsed);
+      });
+  if (profile != nullptr) [[unlikely]] {
+    profile->countRow(met);
+  }
+  return met;
+}
+
+namespace {
+bool meetsConditions(const std::vector<QueryCondition> &condition,
+                     const Datum &datum) {
+  const auto &fields = datum.datumConstRef();
   return std::all_of(condition.begin(), condition.end(),
-                     [&object](const auto &cond) {
+                     [&datum, &fields](const auto &cond) {
                        if (cond.fieldId == static_cast<size_t>(-1)) {
-                         return object.key() == cond.value;
+                         return datum.keyConstRef() == cond.value;
                        }
-                       return cond.comp(object[cond.fieldId], cond.valueParsed);
+                       return cond.comp(fields[cond.fieldId], cond.valueParsed);
                      });
 }
+}  // namespace
 
-bool ComplexQuery::testKeyCondition(
-    Table &table,  // cppcheck-suppress constParameter
-    const std::function<void(bool, Table::Object::Ptr &&)> &function) {
-  auto condResult = initCondition(table);
+bool ComplexQuery::evalCondition(const Datum &datum) {
+  const bool met = meetsConditions(condition, datum);
+  if (profile != nullptr) [[unlikely]] {
+    profile->countRow(met);
+  }
+  return met;
+}
+
+namespace {
+template <class TableType, class Function>
+bool testKey(ComplexQuery &query, TableType &table, const Function &function) {
+  auto condResult = query.initCondition(table);
   if (!condResult.second) [[unlikely]] {
     function(false, nullptr);
     return true;
   }
   if (!condResult.first.empty()) [[unlikely]] {
     auto object = table[condResult.first];
-    if (object != nullptr && evalCondition(*object)) [[likely]] {
+    if (object != nullptr && query.evalCondition(*object)) [[likely]] {
       function(true, std::move(object));
     } else [[unlikely]] {
       function(false, nullptr);
@@ -111,3 +222,335 @@ bool ComplexQuery::testKeyCondition(
   }
   return false;
 }
+}  // namespace
+
+bool ComplexQuery::testKeyCondition(
+    Table &table,  // cppcheck-suppress constParameter
+    const std::function<void(bool, Table::Object::Ptr &&)> &function) {
+  return testKey(*this, table, function);
+}
+
+bool ComplexQuery::testKeyCondition(
+    const Table &table,
+    const std::function<void(bool, Table::ConstObject::Ptr &&)> &function) {
+  return testKey(*this, table, function);
+}
+
+bool ScanQuery::View::matches(const Datum &row) const {
+  return meetsConditions(conditions, row);
+}
+
+bool ScanQuery::readsSnapshot() const {
+  try {
+    return !Database::getInstance()[targetTableRef()].views().wants(
+        cacheKey());
+  } catch (const TableNameNotFound &) {
+    return true;
+  }
+}
+
+bool ScanQuery::batchesWith(const Query &other) const {
+  return dynamic_cast<const ScanQuery *>(&other) != nullptr;
+}
+
+QueryResult::Ptr ScanQuery::execute() {
+  const auto version = cacheVersion();
+  if (!version) [[unlikely]] {
+    return executeUncached();
+  }
+  if (auto cached = findCached(*version)) {
+    return cached;
+  }
+  return cacheResult(*version, executeUncached());
+}
+
+bool ScanQuery::isCached() const {
+  const auto version = cacheVersion();
+  return version && ResultCache::getInstance().contains(cacheKey(), *version);
+}
+
+bool ScanQuery::hasView() const {
+  try {
+    return pinnedSnapshot() == nullptr &&
+           Database::getInstance()[targetTableRef()].views().contains(
+               cacheKey());
+  } catch (const TableNameNotFound &) {
+    return false;
+  }
+}
+
+std::vector<QueryResult::Ptr>
+ScanQuery::executeBatch(std::span<Query *> batch) {
+  std::vector<QueryResult::Ptr> results(batch.size());
+  std::vector<std::optional<uint64_t>> versions(batch.size());
+  std::vector<Query *> misses;
+  std::vector<size_t> missIndices;
+  // A repeat of a query missed earlier in the batch takes its cached result
+  std::unordered_set<std::string_view> missKeys;
+  std::vector<size_t> repeats;
+  for (size_t index = 0; index < batch.size(); ++index) [[likely]] {
+    auto *query = static_cast<ScanQuery *>(batch[index]);
+    versions[index] = query->cacheVersion();
+    if (versions[index]) [[likely]] {
+      if (missKeys.contains(query->cacheKey())) {
+        repeats.push_back(index);
+        continue;
+      }
+      results[index] = query->findCached(*versions[index]);
+    }
+    if (results[index] != nullptr) [[unlikely]] {
+      continue;
+    }
+    if (versions[index]) [[likely]] {
+      missKeys.insert(query->cacheKey());
+    }
+    if (auto viewed = query->readView()) [[unlikely]] {
+      results[index] = versions[index]
+                           ? query->cacheResult(*versions[index],
+                                                std::move(viewed))
+                           : std::move(viewed);
+      continue;
+    }
+    misses.push_back(query);
+    missIndices.push_back(index);
+  }
+
+  std::vector<QueryResult::Ptr> scanned(misses.size());
+  if (misses.size() > 1) [[likely]] {
+    try {
+      scanShared(misses, scanned);
+    } catch (const std::exception &) {
+      // Each query runs and reports the error alone
+      std::ranges::fill(scanned, nullptr);
+    }
+  }
+  for (size_t miss = 0; miss < misses.size(); ++miss) [[likely]] {
+    auto *query = static_cast<ScanQuery *>(misses[miss]);
+    const size_t index = missIndices[miss];
+    auto result = scanned[miss] != nullptr ? std::move(scanned[miss])
+                                           : query->executeScan();
+    results[index] = versions[index]
+                         ? query->cacheResult(*versions[index],
+                                              std::move(result))
+                         : std::move(result);
+  }
+  for (const size_t index : repeats) [[likely]] {
+    // Misses again if the first copy failed or was not cached
+    results[index] = batch[index]->execute();
+  }
+  return results;
+}
+
+std::unique_ptr<ScanQuery::View>
+ScanQuery::openView(const Table & /*table*/) {
+  return nullptr;
+}
+
+QueryResult::Ptr ScanQuery::readView() {
+  if (pinnedSnapshot() != nullptr) [[unlikely]] {
+    // A snapshot keeps no views; once hot, the query reads the live table
+    try {
+      (void)Database::getInstance()[targetTableRef()].views().isHot(
+          cacheKey());
+    } catch (const TableNameNotFound &) {
+    }
+    return nullptr;
+  }
+  try {
+    TableLockManager::ReadLock lock;
+    const Table &table = readTable(lock);
+    auto &views = table.views();
+    QueryResult::Ptr result;
+    const auto readResult = [&result](const TableView &view) {
+      result = static_cast<const View &>(view).result();
+    };
+    if (views.read(table, cacheKey(), readResult)) {
+      return result;
+    }
+    if (!views.isHot(cacheKey())) [[likely]] {
+      return nullptr;
+    }
+    auto view = openView(table);
+    if (view == nullptr) [[unlikely]] {
+      return nullptr;
+    }
+    views.add(table, cacheKey(), std::move(view));
+    views.read(table, cacheKey(), readResult);
+    return result;
+  } catch (const std::exception &) {
+    return nullptr;  // The scan reports the error
+  }
+}
+
+QueryResult::Ptr ScanQuery::executeUncached() {
+  if (auto viewed = readView()) [[unlikely]] {
+    return viewed;
+  }
+  if (auto pruned = scanZones()) [[unlikely]] {
+    return pruned;
+  }
+  return executeScan();
+}
+
+QueryResult::Ptr ScanQuery::scanZones() {
+  try {
+    TableLockManager::ReadLock lock;
+    const Table &table = readTable(lock);
+    if (table.statistics() == nullptr) [[likely]] {
+      return nullptr;
+    }
+    auto scan = openScan(table);
+    if (scan == nullptr || accessPath() != AccessPath::ZoneMap) {
+      return nullptr;
+    }
+    std::array<Scan *, 1> open = {scan.get()};
+    scanBlocks(table, open, this);
+    const QueryProfile::StageTimer timer(QueryProfile::Stage::Merge);
+    return scan->finish();
+  } catch (const std::exception &) {
+    return nullptr;  // The scan reports the error
+  }
+}
+
+const std::string &ScanQuery::cacheKey() const {
+  if (cacheKeyText.empty()) [[likely]] {
+    // Fields are separated by characters no token contains
+    cacheKeyText.append(typeid(*this).name()).append(1, '\n');
+    cacheKeyText.append(targetTableRef()).append(1, '\n');
+    for (const auto &operand : getOperands()) [[likely]] {
+      cacheKeyText.append(operand).append(1, ' ');
+    }
+    cacheKeyText.append(1, '\n');
+    // In statement order, whatever order initCondition tests them in
+    std::vector<const QueryCondition *> conditions;
+    for (const auto &cond : getCondition()) [[likely]] {
+      conditions.push_back(&cond);
+    }
+    std::ranges::sort(conditions, {}, &QueryCondition::position);
+    for (const auto *cond : conditions) [[likely]] {
+      cacheKeyText.append(cond->field).append(1, ' ');
+      cacheKeyText.append(cond->op).append(1, ' ');
+      cacheKeyText.append(cond->value).append(1, '\n');
+    }
+  }
+  return cacheKeyText;
+}
+
+std::optional<uint64_t> ScanQuery::cacheVersion() const {
+  if (!ResultCache::getInstance().isEnabled()) [[unlikely]] {
+    return std::nullopt;
+  }
+  if (const Table *pinned = pinnedSnapshot()) {
+    return pinned->dataVersion();
+  }
+  try {
+    return Database::getInstance()[targetTableRef()].dataVersion();
+  } catch (const TableNameNotFound &) {
+    return std::nullopt;  // Reports the error when it runs
+  }
+}
+
+QueryResult::Ptr ScanQuery::findCached(uint64_t version) {
+  auto found = ResultCache::getInstance().find(cacheKey(), version);
+  if (!found) [[likely]] {
+    return nullptr;
+  }
+  if (*found == nullptr) [[unlikely]] {
+    return std::make_unique<NullQueryResult>();
+  }
+  return std::make_unique<TextRowsResult>(std::move(*found));
+}
+
+QueryResult::Ptr ScanQuery::cacheResult(uint64_t version,
+                                        QueryResult::Ptr result) {
+  // A writer that ran alongside may be reflected in the result
+  if (result == nullptr || !result->success() || cacheVersion() != version)
+      [[unlikely]] {
+    return result;
+  }
+  const QueryProfile::StageTimer timer(QueryProfile::Stage::Output);
+  ResultBuffer::Ptr printed =
+      result->display() ? result->takeBuffer() : nullptr;
+  ResultCache::getInstance().insert(cacheKey(), version, printed);
+  if (printed == nullptr) [[unlikely]] {
+    return std::make_unique<NullQueryResult>();
+  }
+  return std::make_unique<TextRowsResult>(std::move(printed));
+}
+
+void ScanQuery::scanShared(std::span<Query *> batch,
+                           std::vector<QueryResult::Ptr> &results) {
+  TableLockManager::ReadLock lock;
+  const Table &table = readTable(lock);
+
+  std::vector<std::unique_ptr<Scan>> scans(batch.size());
+  std::vector<Scan *> open;
+  open.reserve(batch.size());
+  for (size_t index = 0; index < batch.size(); ++index) [[likely]] {
+    try {
+      scans[index] = static_cast<ScanQuery *>(batch[index])->openScan(table);
+    } catch (const std::exception &) {
+      continue;  // Runs and reports the error alone
+    }
+    if (scans[index] != nullptr) [[likely]] {
+      open.push_back(scans[index].get());
+    }
+  }
+  if (open.empty()) [[unlikely]] {
+    return;
+  }
+
+  scanBlocks(table, open);
+
+  const QueryProfile::StageTimer timer(QueryProfile::Stage::Merge);
+  for (size_t index = 0; index < batch.size(); ++index) [[likely]] {
+    if (scans[index] != nullptr) [[likely]] {
+      results[index] = scans[index]->finish();
+    }
+  }
+}
+
+void ScanQuery::scanBlocks(const Table &table, std::span<Scan *const> open,
+                           const ComplexQuery *pruning) {
+  std::vector<Table::SizeType> wanted;
+  wanted.reserve(table.blockCount());
+  for (Table::SizeType block = 0; block < table.blockCount(); ++block)
+      [[likely]] {
+    if (pruning == nullptr || pruning->mayMatchBlock(block)) [[likely]] {
+      wanted.push_back(block);
+    }
+  }
+  // Block by block, so each block is still in cache for the next query
+  const auto scanBlock = [&table, &open](Table::SizeType block) {
+    for (auto *scan : open) [[likely]] {
+      scan->scanBlock(table, block);
+    }
+  };
+  if (!ThreadPool::isInitialized() ||
+      ThreadPool::getInstance().getThreadCount() <= 1 || wanted.size() <= 1)
+      [[unlikely]] {
+    for (const Table::SizeType block : wanted) [[likely]] {
+      scanBlock(block);
+    }
+  } else {
+    const ThreadPool &pool = ThreadPool::getInstance();
+    std::vector<std::future<void>> futures;
+    futures.reserve(wanted.size());
+    for (const Table::SizeType block : wanted) [[likely]] {
+      futures.push_back(
+          pool.submit([&scanBlock, block]() { scanBlock(block); }));
+    }
+    // Wait for every block before a failure unwinds what they use
+    std::exception_ptr failure;
+    for (auto &future : futures) [[likely]] {
+      try {
+        future.get();
+      } catch (const std::exception &) {
+        failure = std::current_exception();
+      }
+    }
+    if (failure != nullptr) [[unlikely]] {
+      std::rethrow_exception(failure);
+    }
+  }
+}
@@ -7,14 +7,22 @@
 
 #include <cstddef>
 #include <functional>
+#include <cstdint>
 #include <memory>
+#include <optional>
+#include <span>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "../db/Datum.h"
 #include "../db/QueryBase.h"
 #include "../db/Table.h"
+#include "../db/TableLockManager.h"
+#include "../db/TableView.h"
 #include "../db/types.h"
+#include "../utils/QueryProfile.h"
+#include "QueryPlan.h"
 #include "QueryResult.h"
 
 struct QueryCondition {
@@ -24,6 +32,8 @@ struct QueryCondition {
   std::function<bool(const ValueType &, const ValueType &)> comp;
   std::string value;
   ValueType valueParsed = 0;
+  /** Position in the statement; conditions are evaluated in another order */
+  size_t position = 0;
 };
 
 class NopQuery : public Query {
@@ -36,11 +46,53 @@ public:
 };
 
 class ComplexQuery : public Query {
+public:
+  /** How a query finds the rows that meet its condition */
+  enum class AccessPath {
+    /** Every row is tested */
+    FullScan,
+    /** Blocks whose zone (see TableStatistics) rules the condition out are
+       skipped, the rows of the others tested */
+    ZoneMap,
+    /** The row is looked up by its KEY */
+    Index,
+  };
+
+  /**
+   * Estimated selectivity below which a scan looks for blocks to skip; a
+   * condition that keeps more rows seldom leaves a block without one
+   */
+  static constexpr double kZoneMapSelectivity = 0.25;
+
 private:
   /** The field names in the first () */
   std::vector<std::string> operands;
   /** The function used in where clause */
   std::vector<QueryCondition> condition;
+  /** The shared plan of the statement shape, if the parser assigned one */
+  QueryPlan::Ptr plan;
+  /** Field indices of the plan for the table currently executed on */
+  mutable std::shared_ptr<const QueryPlan::Resolution> resolution;
+  /** Snapshot of the target table to read, if one was pinned */
+  std::shared_ptr<const Table> snapshot;
+  /** The path initCondition chose for the table */
+  AccessPath path = AccessPath::FullScan;
+  /** On the ZoneMap path: whether each block may hold a matching row */
+  std::vector<uint8_t> candidateBlocks;
+  /** Counts the rows tested while PROFILE runs the query */
+  QueryProfile *profile = nullptr;
+
+  /**
+   * Get the plan resolution for the table
+   * @return the resolution, or nullptr if the query has no plan
+   */
+  const QueryPlan::Resolution *resolvePlan(const Table &table) const;
+
+  /**
+   * Order the resolved conditions by selectivity and choose between the
+   * ZoneMap and FullScan paths, from the statistics of the table
+   */
+  void choosePath(const Table &table);
 
 public:
   using Ptr = std::unique_ptr<ComplexQuery>;
@@ -49,6 +101,11 @@ public:
    * init a fast condition according to the table
    * note that the condition is only effective if the table fields are not
    * changed
+   *
+   * Once the table was analyzed, the conditions are reordered so the one
+   * that keeps the fewest rows is tested first, and the access path is
+   * chosen: the KEY index if a KEY is compared, else the zone map if the
+   * conditions keep few rows and it rules some blocks out, else a full scan.
    * @param table The table to initialize conditions for
    * @return a pair of the key and a flag
    * if flag is false, the condition is always false
@@ -64,6 +121,33 @@ public:
    */
   bool evalCondition(const Table::Object &object);
   bool evalCondition(const Table::ConstObject &object);
+  /** The same, on a row read straight from its block */
+  bool evalCondition(const Datum &datum);
+
+  /**
+   * Count the rows evalCondition tests, and how many meet the condition
+   * @param rowProfile The profile to count in, or nullptr to stop
+   */
+  void attachProfile(QueryProfile *rowProfile) { profile = rowProfile; }
+
+  /** Get the access path chosen by initCondition */
+  [[nodiscard]] AccessPath accessPath() const { return path; }
+
+  /** Whether the query looks up the row of a KEY instead of testing each */
+  [[nodiscard]] virtual bool looksUpKeys() const { return false; }
+
+  /** Whether the query skips the blocks the zone map rules out */
+  [[nodiscard]] virtual bool skipsBlocks() const { return false; }
+
+  /**
+   * Check whether a block may hold a row that meets the condition; only
+   * the ZoneMap path rules blocks out
+   * @param block The block index
+   */
+  [[nodiscard]] bool mayMatchBlock(Table::SizeType block) const {
+    return path != AccessPath::ZoneMap || block >= candidateBlocks.size() ||
+           candidateBlocks[block] != 0;
+  }
 
   /**
    * This function seems have small effect and causes somme bugs
@@ -75,6 +159,9 @@ public:
   bool testKeyCondition(
       Table &table,
       const std::function<void(bool, Table::Object::Ptr &&)> &function);
+  bool testKeyCondition(
+      const Table &table,
+      const std::function<void(bool, Table::ConstObject::Ptr &&)> &function);
 
   /**
    * Construct a ComplexQuery with target table, operands, and conditions
@@ -85,15 +172,248 @@ public:
   ComplexQuery(std::string targetTable, std::vector<std::string> operands,
                std::vector<QueryCondition> condition)
       : Query(std::move(targetTable)), operands(std::move(operands)),
-        condition(std::move(condition)) {}
+        condition(std::move(condition)) {
+    for (size_t index = 0; index < this->condition.size(); ++index) {
+      this->condition[index].position = index;
+    }
+  }
+
+  [[nodiscard]] bool isPointWriter() const override;
+
+  void pinSnapshot(std::shared_ptr<const Table> pinned) override {
+    snapshot = std::move(pinned);
+  }
+
+  /** Get the pinned snapshot of the target table, or nullptr */
+  [[nodiscard]] const Table *pinnedSnapshot() const { return snapshot.get(); }
+
+  /**
+   * Get the target table to read: the pinned snapshot if there is one,
+   * otherwise the table itself, read-locked
+   * @param lock Receives the read lock of the table, if one is taken
+   * @return the table
+   * @throw TableNameNotFound if the table does not exist
+   */
+  const Table &readTable(TableLockManager::ReadLock &lock);
+
+  /**
+   * Attach the plan of the statement shape
+   * @param shapePlan The plan shared by statements of the same shape
+   */
+  void bindPlan(QueryPlan::Ptr shapePlan) { plan = std::move(shapePlan); }
+
+  /**
+   * Get the index of the field named by an operand, reusing the plan's
+   * resolution when there is one
+   * @param table The table to look the field up in
+   * @param index Position of the operand
+   * @return the field index
+   * @throw TableFieldNotFound if the operand is not a field of the table
+   */
+  [[nodiscard]] Table::FieldIndex operandFieldIndex(const Table &table,
+                                                    size_t index) const;
 
   /** Get operands in the query */
   [[nodiscard]] const std::vector<std::string> &getOperands() const {
     return operands;
   }
 
-  /** Get condition in the query, seems no use now */
-  const std::vector<QueryCondition> &getCondition() { return condition; }
+  /**
+   * Get condition in the query, resolved once initCondition ran, which may
+   * also have reordered it (see QueryCondition::position)
+   */
+  [[nodiscard]] const std::vector<QueryCondition> &getCondition() const {
+    return condition;
+  }
+};
+
+/**
+ * A read that scans its table row by row (SUM, COUNT, MIN, MAX, SELECT)
+ *
+ * A run of scans queued on the same table shares one scan: each block of
+ * rows is read once, while every query of the run folds it into its own
+ * partial result for the block (see executeBatch).
+ *
+ * Results are looked up in the ResultCache under the table's data version
+ * before anything is locked or scanned, and successful results are added to
+ * it. An aggregate run often enough on a table is then answered from a view
+ * the table's writers keep up to date (see TableViewSet); anything else is
+ * run by executeScan().
+ */
+class ScanQuery : public ComplexQuery {
+public:
+  /** A query's part in a shared scan of its table */
+  class Scan {
+  public:
+    Scan() = default;
+    Scan(const Scan &) = delete;
+    Scan &operator=(const Scan &) = delete;
+    Scan(Scan &&) = delete;
+    Scan &operator=(Scan &&) = delete;
+    virtual ~Scan() = default;
+
+    /**
+     * Fold a block's rows into the block's partial result; different blocks
+     * are scanned concurrently
+     * @param table The table scanned
+     * @param block The block index
+     */
+    virtual void scanBlock(const Table &table, Table::SizeType block) = 0;
+
+    /** Combine the partial results of the blocks into the query's result */
+    virtual QueryResult::Ptr finish() = 0;
+
+  protected:
+    /**
+     * Call a function with each row of a block that meets a query's condition
+     * @param query The query
+     * @param table The table scanned
+     * @param block The block index
+     * @param function Called with the fields of each matching row
+     */
+    template <class Function>
+    static void forEachMatch(ComplexQuery &query, const Table &table,
+                             Table::SizeType block, const Function &function) {
+      if (!query.mayMatchBlock(block)) [[unlikely]] {
+        return;
+      }
+      for (const Datum &row : table.blockRowsOf(block)) [[likely]] {
+        if (query.evalCondition(row)) [[likely]] {
+          function(row);
+        }
+      }
+    }
+  };
+
+  /** A query's aggregate kept up to date as its table changes */
+  class View : public TableView {
+    /** The query's conditions, resolved for the table */
+    std::vector<QueryCondition> conditions;
+
+  public:
+    /**
+     * @param conditions The query's conditions, resolved for the table; a
+     * KEY condition is not supported
+     */
+    explicit View(std::vector<QueryCondition> conditions)
+        : conditions(std::move(conditions)) {}
+
+    /** Get the result the query gives on the table */
+    [[nodiscard]] virtual QueryResult::Ptr result() const = 0;
+
+  protected:
+    /** Check whether a row meets the query's conditions */
+    [[nodiscard]] bool matches(const Datum &row) const;
+  };
+
+  using ComplexQuery::ComplexQuery;
+
+  /** Reads a snapshot unless a view of the live table answers it */
+  [[nodiscard]] bool readsSnapshot() const override;
+  [[nodiscard]] bool isBatchable() const override { return true; }
+  [[nodiscard]] bool batchesWith(const Query &other) const override;
+  [[nodiscard]] bool skipsBlocks() const override { return true; }
+
+  QueryResult::Ptr execute() final;
+
+  /** Check whether execute() would find the result in the result cache */
+  [[nodiscard]] bool isCached() const;
+
+  /** Check whether execute() would read a view of the live table */
+  [[nodiscard]] bool hasView() const;
+
+  /**
+   * Execute a run of scans of this query's table in one shared scan; a query
+   * whose result is cached, or that has a view, does not scan, and a query
+   * that does not open a scan, or every query if the scan fails, runs
+   * executeScan()
+   * @param batch The scans, this one first
+   * @return one result per query, the same as execute() would give
+   */
+  std::vector<QueryResult::Ptr> executeBatch(std::span<Query *> batch) override;
+
+protected:
+  /** Run the query on its table, bypassing the result cache */
+  virtual QueryResult::Ptr executeScan() = 0;
+
+  /**
+   * Prepare the query's part in a shared scan of the table, as execute()
+   * prepares its own scan
+   * @param table The table to scan
+   * @return the scan, or nullptr if the query does not scan the table (it
+   * fails, its condition is never true, or it looks a KEY up)
+   */
+  virtual std::unique_ptr<Scan> openScan(const Table &table) = 0;
+
+  /**
+   * Prepare a view of the query's aggregate over the table
+   * @param table The table
+   * @return the view, or nullptr if the query keeps none (SELECT), fails,
+   * never matches, or looks a KEY up
+   */
+  virtual std::unique_ptr<View> openView(const Table &table);
+
+private:
+  /** The normalized query the result is cached under, built on first use */
+  mutable std::string cacheKeyText;
+
+  /** Get the normalized query: its type, table, operands and conditions */
+  [[nodiscard]] const std::string &cacheKey() const;
+
+  /**
+   * Get the data version of the table the query reads, without locking it
+   * @return the version, or nullopt if results are not cached
+   */
+  [[nodiscard]] std::optional<uint64_t> cacheVersion() const;
+
+  /**
+   * Look the result up in the result cache
+   * @param version The data version of the table
+   * @return the cached result, or nullptr on a miss
+   */
+  QueryResult::Ptr findCached(uint64_t version);
+
+  /**
+   * Add a result to the result cache, unless it failed or the table was
+   * written since the version was read
+   * @param version The data version read before the query ran
+   * @param result The result of executeScan()
+   * @return a result printing the same
+   */
+  QueryResult::Ptr cacheResult(uint64_t version, QueryResult::Ptr result);
+
+  /**
+   * Read the query's view of its table, giving it one once it is hot
+   * @return the result, or nullptr if there is no view to read
+   */
+  QueryResult::Ptr readView();
+
+  /** Run the query: read its view, or else scan */
+  QueryResult::Ptr executeUncached();
+
+  /**
+   * Scan only the blocks the zone map leaves, if the query takes the ZoneMap
+   * path (see ComplexQuery::initCondition)
+   * @return the result, or nullptr if the query takes another path
+   */
+  QueryResult::Ptr scanZones();
+
+  /**
+   * Run the scans of the batch that open in one pass over the table
+   * @param results Receives the result of each query that scanned
+   */
+  void scanShared(std::span<Query *> batch,
+                  std::vector<QueryResult::Ptr> &results);
+
+  /**
+   * Run scans of a table over all of its blocks, in parallel when the thread
+   * pool has several threads
+   * @param table The table, locked or a snapshot
+   * @param open The scans
+   * @param pruning If given, the blocks it rules out are not scanned
+   */
+  static void scanBlocks(const Table &table, std::span<Scan *const> open,
+                         const ComplexQuery *pruning = nullptr);
 };
 
 #endif  // PROJECT_QUERY_H
@@ -1,75 +1,438 @@
 #include "QueryParser.h"
 
-#include <cctype>
+#include <algorithm>
+#include <array>
 #include <cstddef>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
+#include "../db/Database.h"
+#include "../db/LoadPrefetcher.h"
 #include "../db/QueryBase.h"
-#include "../utils/uexception.h"
-#include "QueryBuilders.h"
+#include "../db/WriteAheadLog.h"
+#include "../utils/Tracer.h"
+#include "Query.h"
+#include "QueryPlan.h"
+#include "data/AddQuery.h"
+#include "data/CountQuery.h"
+#include "data/DeleteQuery.h"
+#include "data/DuplicateQuery.h"
+#include "data/InsertQuery.h"
+#include "data/MaxQuery.h"
+#include "data/MinQuery.h"
+#include "data/SelectQuery.h"
+#include "data/SubQuery.h"
+#include "data/SumQuery.h"
+#include "data/SwapQuery.h"
+#include "data/UpdateQuery.h"
+#include "management/AnalyzeTableQuery.h"
+#include "management/CheckpointQuery.h"
+#include "management/CopyTableQuery.h"
+#include "management/DropTableQuery.h"
+#include "management/DumpTableQuery.h"
+#include "management/ListTableQuery.h"
+#include "management/LoadTableQuery.h"
+#include "management/PrintTableQuery.h"
+#include "management/QuitQuery.h"
+#include "management/StatsQuery.h"
+#include "management/TruncateTableQuery.h"
+#include "utils/ExplainQuery.h"
+#include "utils/ListenQuery.h"
+#include "utils/ProfileQuery.h"
 
 namespace {
-constexpr size_t kDefaultTokenReserve = 16;
+/**
+ * Splits a statement on whitespace lazily; tokens are views into the input.
+ */
+class Lexer {
+  std::string_view input;
+  size_t pos = 0;
+
+  static constexpr bool isSpace(char character) {
+    // Same set as std::isspace in the "C" locale
+    return character == ' ' || (character >= '\t' && character <= '\r');
+  }
+
+public:
+  explicit Lexer(std::string_view input) : input(input) {}
+
+  /**
+   * Consume the next token
+   * @return the token, or an empty view at the end of the statement
+   */
+  std::string_view next() {
+    while (pos < input.size() && isSpace(input[pos])) {
+      ++pos;
+    }
+    const size_t start = pos;
+    while (pos < input.size() && !isSpace(input[pos])) {
+      ++pos;
+    }
+    return input.substr(start, pos - start);
+  }
+
+  /** Check that no token is left */
+  bool atEnd() {
+    while (pos < input.size() && isSpace(input[pos])) {
+      ++pos;
+    }
+    return pos == input.size();
+  }
+};
+
+ParseResult fail(std::string_view error) { return {nullptr, error}; }
+
+template <class QueryType, class... Args> ParseResult make(Args &&...args) {
+  return {std::make_unique<QueryType>(std::forward<Args>(args)...), {}};
+}
+
+constexpr size_t kAllOperands = static_cast<size_t>(-1);
+
+/**
+ * Find or create the plan shared by the statements of one shape. The shape
+ * is made of the table, the operands that name fields, and the field and
+ * operator of each condition; constants are left out.
+ * @param fieldOperands Number of leading operands that name fields
+ * @return the plan, or nullptr if there is nothing to resolve
+ */
+QueryPlan::Ptr planFor(std::string_view table,
+                       const std::vector<std::string> &operands,
+                       size_t fieldOperands,
+                       const std::vector<QueryCondition> &conditions) {
+  fieldOperands = std::min(fieldOperands, operands.size());
+  if (fieldOperands == 0 && conditions.empty()) {
+    return nullptr;
+  }
+
+  thread_local std::string shape;
+  shape.assign(table);
+  shape.push_back('\0');
+  for (size_t index = 0; index < fieldOperands; ++index) {
+    shape.append(operands[index]).push_back(' ');
+  }
+  shape.push_back('\0');
+  for (const auto &cond : conditions) {
+    shape.append(cond.field).append(" ").append(cond.op).push_back(' ');
+  }
+
+  auto &cache = PlanCache::getInstance();
+  if (auto plan = cache.find(shape)) [[likely]] {
+    return plan;
+  }
+  return cache.insert(
+      shape, std::make_shared<QueryPlan>(
+                 std::vector<std::string>(
+                     operands.begin(),
+                     operands.begin() + static_cast<std::ptrdiff_t>(
+                                            fieldOperands)),
+                 conditions));
 }
 
-Query::Ptr QueryParser::parseQuery(const std::string &queryString) {
-  if (first == nullptr) [[unlikely]] {
-    throw QueryBuilderMatchFailed(queryString);
+// $OPER$ ( arg1 arg2 ... ) FROM table WHERE ( field op value ) ...
+//
+// The "WHERE" clause can be ommitted
+// The args of OPER clause can be ommitted
+// FieldOperands is the number of leading operands that name fields; the
+// remaining ones are constants and are not part of the plan's shape.
+template <class QueryType, size_t FieldOperands = kAllOperands>
+ParseResult parseComplex(Lexer &lexer) {
+  std::vector<std::string> operands;
+  auto token = lexer.next();
+  if (token.empty()) [[unlikely]] {
+    return fail("Missing operands or FROM clause.");
+  }
+  if (token != "FROM") [[likely]] {
+    if (token != "(") [[unlikely]] {
+      return fail("Ill-formed operand.");
+    }
+    while ((token = lexer.next()) != ")") [[likely]] {
+      if (token.empty()) [[unlikely]] {
+        return fail("Ill-formed operand.");
+      }
+      operands.emplace_back(token);
+    }
+    if (lexer.next() != "FROM") [[unlikely]] {
+      return fail("Missing FROM clause");
+    }
+  }
+
+  const auto table = lexer.next();
+  if (table.empty()) [[unlikely]] {
+    return fail("Missing target table");
   }
-  auto tokenized = tokenizeQueryString(queryString);
-  if (tokenized.token.empty()) [[unlikely]] {
-    throw QueryBuilderMatchFailed("");
+
+  std::vector<QueryCondition> conditions;
+  token = lexer.next();
+  if (!token.empty()) {
+    if (token != "WHERE") [[unlikely]] {
+      return fail(R"(Expecting "WHERE".)");
+    }
+    while (!(token = lexer.next()).empty()) [[likely]] {
+      if (token != "(") [[unlikely]] {
+        return fail("Ill-formed query condition");
+      }
+      QueryCondition cond;
+      cond.field = lexer.next();
+      if (cond.field.empty()) [[unlikely]] {
+        return fail("Missing field in condition");
+      }
+      cond.op = lexer.next();
+      if (cond.op.empty()) [[unlikely]] {
+        return fail("Missing operator in condition");
+      }
+      cond.value = lexer.next();
+      if (cond.value.empty()) [[unlikely]] {
+        return fail("Missing value in condition");
+      }
+      if (lexer.next() != ")") [[unlikely]] {
+        return fail("Ill-formed query condition");
+      }
+      conditions.push_back(std::move(cond));
+    }
   }
-  first->clear();
-  return first->tryExtractQuery(tokenized);
+
+  auto plan = planFor(table, operands, FieldOperands, conditions);
+  auto query = std::make_unique<QueryType>(
+      std::string(table), std::move(operands), std::move(conditions));
+  query->bindPlan(std::move(plan));
+  return {std::move(query), {}};
 }
 
-void QueryParser::registerQueryBuilder(QueryBuilder::Ptr &&qBuilder) {
-  if (first == nullptr) [[unlikely]] {
-    first = std::move(qBuilder);
-    last = first.get();
-    last->setNext(FailedQueryBuilder::getDefault());
-  } else [[likely]] {
-    QueryBuilder *temp = last;
-    last = qBuilder.get();
-    temp->setNext(std::move(qBuilder));
-    last->setNext(FailedQueryBuilder::getDefault());
+ParseResult parseList(Lexer &lexer) {
+  if (!lexer.atEnd()) [[unlikely]] {
+    return fail("Unexpected token after LIST");
   }
+  return make<ListTableQuery>();
 }
 
-TokenizedQueryString
-QueryParser::tokenizeQueryString(const std::string &queryString) {
-  TokenizedQueryString result;
-  result.rawQeuryString = queryString;
-  result.token.reserve(kDefaultTokenReserve);
+ParseResult parseQuit(Lexer &lexer) {
+  if (!lexer.atEnd()) [[unlikely]] {
+    return fail("Unexpected token after QUIT");
+  }
+  return make<QuitQuery>();
+}
 
-  const std::string_view view{queryString};
-  auto is_space = [](char character) {
-    return std::isspace(static_cast<unsigned char>(character)) != 0;
-  };
+ParseResult parseCheckpoint(Lexer &lexer) {
+  if (!lexer.atEnd()) [[unlikely]] {
+    return fail("Unexpected token after CHECKPOINT");
+  }
+  return make<CheckpointQuery>();
+}
 
-  size_t start = 0;
-  const size_t len = view.size();
+// STATS or STATS RESET
+ParseResult parseStats(Lexer &lexer) {
+  const auto mode = lexer.next();
+  const bool reset = mode == "RESET";
+  if ((!mode.empty() && !reset) || !lexer.atEnd()) [[unlikely]] {
+    return fail("Unexpected token after STATS");
+  }
+  return make<StatsQuery>(reset);
+}
 
-  while (start < len) {
-    while (start < len && is_space(view[start])) {
-      ++start;
-    }
+ParseResult parseShowTable(Lexer &lexer) {
+  const auto table = lexer.next();
+  if (table.empty() || !lexer.atEnd()) [[unlikely]] {
+    return fail("SHOWTABLE expects exactly one table");
+  }
+  return make<PrintTableQuery>(std::string(table));
+}
 
-    if (start >= len) {
-      break;
+// LISTEN ( filename ) or LISTEN filename
+ParseResult parseListen(Lexer &lexer) {
+  auto filename = lexer.next();
+  if (filename.empty()) [[unlikely]] {
+    return fail("Missing file name");
+  }
+  if (filename == "(") {
+    const auto inner = lexer.next();
+    if (!inner.empty()) {
+      filename = inner;
     }
+  }
+  if (filename.back() == ')') {
+    filename.remove_suffix(1);
+  }
+  return make<ListenQuery>(std::string(filename));
+}
+
+ParseResult parseLoad(Lexer &lexer) {
+  const auto file = lexer.next();
+  if (file.empty()) [[unlikely]] {
+    return fail("Missing file name");
+  }
+  std::string fileName(file);
+  auto tableName = Database::getInstance().getFileTableName(fileName);
+  LoadPrefetcher::getInstance().prefetch(fileName);
+  return make<LoadTableQuery>(std::move(tableName), std::move(fileName));
+}
+
+template <class QueryType> ParseResult parseSingleTable(Lexer &lexer) {
+  const auto table = lexer.next();
+  if (table.empty()) [[unlikely]] {
+    return fail("Missing table name");
+  }
+  return make<QueryType>(std::string(table));
+}
+
+// DUMP table file [COMPRESSED]
+ParseResult parseDump(Lexer &lexer) {
+  const auto table = lexer.next();
+  const auto file = lexer.next();
+  if (file.empty()) [[unlikely]] {
+    return fail("DUMP expects a table and a file");
+  }
+  const auto mode = lexer.next();
+  const bool compressed = mode == "COMPRESSED";
+  if ((!mode.empty() && !compressed) || !lexer.atEnd()) [[unlikely]] {
+    return fail("Unexpected token after DUMP file");
+  }
+  std::string tableName(table);
+  std::string fileName(file);
+  Database::getInstance().updateFileTableName(fileName, tableName);
+  LoadPrefetcher::getInstance().exclude(fileName);
+  return make<DumpTableQuery>(std::move(tableName), std::move(fileName),
+                              compressed);
+}
+
+ParseResult parseCopyTable(Lexer &lexer) {
+  const auto source = lexer.next();
+  const auto target = lexer.next();
+  if (target.empty() || !lexer.atEnd()) [[unlikely]] {
+    return fail("COPYTABLE expects exactly two tables");
+  }
+  return make<CopyTableQuery>(std::string(source), std::string(target));
+}
+
+using Rule = ParseResult (*)(Lexer &);
+
+struct Keyword {
+  std::string_view name;
+  Rule rule = nullptr;
+  /** Whether the rule builds a data query (a ComplexQuery) */
+  bool data = false;
+};
+
+const Keyword *findKeyword(std::string_view word);
 
-    size_t end = start;
-    while (end < len && !is_space(view[end])) {
-      ++end;
+// EXPLAIN query or PROFILE query, where the query is a data query. The
+// keyword is checked first: the rules of other queries (LOAD, DUMP) update
+// the file -> table mapping while parsing, which a rejected query must not.
+template <class WrapperType> ParseResult parseWrapped(Lexer &lexer) {
+  const auto *entry = findKeyword(lexer.next());
+  if (entry == nullptr) [[unlikely]] {
+    return fail("Unknown query keyword");
+  }
+  if (!entry->data) [[unlikely]] {
+    return fail("EXPLAIN and PROFILE take a data query");
+  }
+  auto inner = entry->rule(lexer);
+  if (!inner.ok()) [[unlikely]] {
+    return inner;
+  }
+  auto *query = dynamic_cast<ComplexQuery *>(inner.query.get());
+  if (query == nullptr) [[unlikely]] {
+    return fail("EXPLAIN and PROFILE take a data query");
+  }
+  static_cast<void>(inner.query.release());
+  return make<WrapperType>(std::unique_ptr<ComplexQuery>(query));
+}
+
+constexpr std::array<Keyword, 26> kKeywords = {{
+    {"LIST", &parseList},
+    {"QUIT", &parseQuit},
+    {"SHOWTABLE", &parseShowTable},
+    {"LISTEN", &parseListen},
+    {"LOAD", &parseLoad},
+    {"DROP", &parseSingleTable<DropTableQuery>},
+    {"TRUNCATE", &parseSingleTable<TruncateTableQuery>},
+    {"ANALYZE", &parseSingleTable<AnalyzeTableQuery>},
+    {"DUMP", &parseDump},
+    {"COPYTABLE", &parseCopyTable},
+    {"CHECKPOINT", &parseCheckpoint},
+    {"STATS", &parseStats},
+    {"INSERT", &parseComplex<InsertQuery, 0>, true},
+    {"UPDATE", &parseComplex<UpdateQuery, 1>, true},
+    {"SELECT", &parseComplex<SelectQuery>, true},
+    {"DELETE", &parseComplex<DeleteQuery>, true},
+    {"DUPLICATE", &parseComplex<DuplicateQuery>, true},
+    {"COUNT", &parseComplex<CountQuery>, true},
+    {"SUM", &parseComplex<SumQuery>, true},
+    {"MIN", &parseComplex<MinQuery>, true},
+    {"MAX", &parseComplex<MaxQuery>, true},
+    {"ADD", &parseComplex<AddQuery>, true},
+    {"SUB", &parseComplex<SubQuery>, true},
+    {"SWAP", &parseComplex<SwapQuery>, true},
+    {"EXPLAIN", &parseWrapped<ExplainQuery>},
+    {"PROFILE", &parseWrapped<ProfileQuery>},
+}};
+
+constexpr size_t kKeywordTableSize = 64;
+
+// The multipliers were picked so that every keyword above gets its own slot;
+// the static_assert below fails the build if a new keyword collides.
+constexpr size_t keywordHash(std::string_view word) {
+  constexpr size_t firstWeight = 4;
+  constexpr size_t edgeWeight = 24;
+  return (static_cast<unsigned char>(word.front()) * firstWeight +
+          (static_cast<unsigned char>(word[1]) +
+           static_cast<unsigned char>(word.back())) *
+              edgeWeight +
+          word.size()) %
+         kKeywordTableSize;
+}
+
+constexpr auto kKeywordTable = [] {
+  std::array<Keyword, kKeywordTableSize> table{};
+  for (const auto &keyword : kKeywords) {
+    table[keywordHash(keyword.name)] = keyword;
+  }
+  return table;
+}();
+
+constexpr bool keywordTableIsPerfect() {
+  for (const auto &keyword : kKeywords) {
+    if (kKeywordTable[keywordHash(keyword.name)].name != keyword.name) {
+      return false;
     }
+  }
+  return true;
+}
+static_assert(keywordTableIsPerfect(), "Keyword hash has collisions");
 
-    result.token.emplace_back(view.substr(start, end - start));
-    start = end;
+const Keyword *findKeyword(std::string_view word) {
+  if (word.size() < 2) [[unlikely]] {
+    return nullptr;
   }
+  const auto &entry = kKeywordTable[keywordHash(word)];
+  return entry.name == word ? &entry : nullptr;
+}
+}  // namespace
 
+ParseResult QueryParser::parse(std::string_view queryString) const {
+  const Tracer::Span span("Parse");
+  Lexer lexer(queryString);
+  const auto keyword = lexer.next();
+  if (keyword.empty()) [[unlikely]] {
+    return fail("Empty query");
+  }
+  const auto *entry = findKeyword(keyword);
+  if (entry == nullptr) [[unlikely]] {
+    return fail("Unknown query keyword");
+  }
+  auto result = entry->rule(lexer);
+  if (!result.ok()) [[unlikely]] {
+    return result;
+  }
+  result.query->setKeyword(entry->name);
+  if (result.query->isWriter() &&
+      WriteAheadLog::getInstance().isEnabled()) [[unlikely]] {
+    const auto first = queryString.find_first_not_of(" \t\n\r");
+    const auto last = queryString.find_last_not_of(" \t\n\r");
+    result.query->setStatement(
+        std::string(queryString.substr(first, last - first + 1)));
+  }
   return result;
 }
@@ -1,65 +1,48 @@
 #ifndef SRC_QUERY_PARSER_H
 #define SRC_QUERY_PARSER_H
 
-#include <memory>
-#include <string>
-#include <vector>
+#include <string_view>
 
 #include "../db/QueryBase.h"
 
-struct TokenizedQueryString {
-  std::vector<std::string> token;
-  std::string rawQeuryString;
-};
-
-class QueryBuilder {
-public:
-  QueryBuilder() = default;
-  QueryBuilder(const QueryBuilder &) = delete;
-  QueryBuilder &operator=(const QueryBuilder &) = delete;
-  QueryBuilder(QueryBuilder &&) = default;
-  QueryBuilder &operator=(QueryBuilder &&) = default;
-
-  using Ptr = std::unique_ptr<QueryBuilder>;
+/**
+ * Outcome of parsing one statement. Exactly one of query / error is set.
+ */
+struct ParseResult {
+  Query::Ptr query;
+  /** Static description of the first problem found, empty on success */
+  std::string_view error;
 
-  virtual Query::Ptr tryExtractQuery(TokenizedQueryString &queryString) = 0;
-  virtual void setNext(Ptr &&builder) = 0;
-  virtual void clear() = 0;
-
-  virtual ~QueryBuilder() = default;
+  [[nodiscard]] bool ok() const { return query != nullptr; }
 };
 
+/**
+ * Single-pass recursive-descent parser for the query language.
+ *
+ * The first word of a statement is looked up in a constexpr perfect-hash
+ * keyword table, which selects the grammar rule; the rest of the statement
+ * is consumed token by token straight from the input, and the matching Query
+ * is constructed directly. Malformed input is reported through ParseResult,
+ * never by throwing.
+ *
+ * The parser holds no state, so one instance may be shared by any number of
+ * threads.
+ */
 class QueryParser {
-  QueryBuilder::Ptr first;       // An owning pointer
-  QueryBuilder *last = nullptr;  // None owning reference
-
-  static TokenizedQueryString
-  tokenizeQueryString(const std::string &queryString);
-
 public:
   QueryParser() = default;
   QueryParser(const QueryParser &) = delete;
   QueryParser &operator=(const QueryParser &) = delete;
   QueryParser(QueryParser &&) = default;
   QueryParser &operator=(QueryParser &&) = default;
+  ~QueryParser() = default;
 
   /**
-   * Parse a query string into a Query object
-   * @param queryString The query string to parse
-   * @return Unique pointer to the parsed Query
-   */
-  Query::Ptr parseQuery(const std::string &queryString);
-
-  /**
-   * Register a query builder for parsing
-   * @param qBuilder The query builder to register
-   */
-  void registerQueryBuilder(QueryBuilder::Ptr &&qBuilder);
-
-  /**
-   * Destruct a QueryParser
+   * Parse a statement (without its terminating ';') into a Query object
+   * @param queryString The statement text
+   * @return The parsed query, or the reason the statement was rejected
    */
-  ~QueryParser() = default;
+  [[nodiscard]] ParseResult parse(std::string_view queryString) const;
 };
 
 #endif  // SRC_QUERY_PARSER_H
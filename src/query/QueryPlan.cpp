@@ -0,0 +1,85 @@
+#include "QueryPlan.h"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "../db/Table.h"
+#include "Query.h"
+
+QueryPlan::QueryPlan(std::vector<std::string> fieldOperands,
+                     const std::vector<QueryCondition> &conditions)
+    : fieldOperands(std::move(fieldOperands)) {
+  conditionFields.reserve(conditions.size());
+  comparators.reserve(conditions.size());
+  for (const auto &cond : conditions) {
+    conditionFields.push_back(cond.field);
+    comparators.push_back(comparatorFor(cond.op));
+  }
+}
+
+QueryPlan::Comparator QueryPlan::comparatorFor(std::string_view op) {
+  if (op == ">") {
+    return std::greater<>();
+  }
+  if (op == "<") {
+    return std::less<>();
+  }
+  if (op == "=") {
+    return std::equal_to<>();
+  }
+  if (op == ">=") {
+    return std::greater_equal<>();
+  }
+  if (op == "<=") {
+    return std::less_equal<>();
+  }
+  return {};
+}
+
+std::shared_ptr<const QueryPlan::Resolution>
+QueryPlan::resolve(const Table &table) {
+  auto current = resolution.load(std::memory_order_acquire);
+  if (current != nullptr && current->generation == table.schemaGeneration())
+      [[likely]] {
+    return current;
+  }
+
+  auto resolved = std::make_shared<Resolution>();
+  resolved->generation = table.schemaGeneration();
+  const auto lookup = [&table](const std::string &field) {
+    return table.findFieldIndex(field).value_or(kUnresolved);
+  };
+  resolved->operands.reserve(fieldOperands.size());
+  for (const auto &field : fieldOperands) {
+    resolved->operands.push_back(lookup(field));
+  }
+  resolved->conditions.reserve(conditionFields.size());
+  for (const auto &field : conditionFields) {
+    resolved->conditions.push_back(lookup(field));
+  }
+
+  std::shared_ptr<const Resolution> result = std::move(resolved);
+  resolution.store(result, std::memory_order_release);
+  return result;
+}
+
+QueryPlan::Ptr PlanCache::find(std::string_view shape) const {
+  const std::shared_lock lock(mutex);
+  const auto iter = plans.find(shape);
+  return iter == plans.end() ? nullptr : iter->second;
+}
+
+QueryPlan::Ptr PlanCache::insert(std::string_view shape, QueryPlan::Ptr plan) {
+  const std::unique_lock lock(mutex);
+  if (plans.size() >= kMaxPlans) [[unlikely]] {
+    plans.clear();
+  }
+  return plans.try_emplace(std::string(shape), std::move(plan)).first->second;
+}
@@ -0,0 +1,146 @@
+#ifndef PROJECT_QUERY_PLAN_H
+#define PROJECT_QUERY_PLAN_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "../db/Table.h"
+
+struct QueryCondition;
+
+/**
+ * QueryPlan: the constant-free part of a ComplexQuery
+ *
+ * Statements that differ only in their constants (condition values and value
+ * operands) share one plan. The plan holds the comparison functions for the
+ * condition operators, resolved once when the plan is created, and the field
+ * indices of the named fields, resolved lazily against the target table and
+ * reused for as long as that table's schema generation stays the same.
+ *
+ * A plan is shared by every query of its shape and may be resolved by
+ * several executing queries at once.
+ */
+class QueryPlan {
+public:
+  using Ptr = std::shared_ptr<QueryPlan>;
+  using Comparator = std::function<bool(const Table::ValueType &,
+                                        const Table::ValueType &)>;
+
+  /** Field index given to a name that is not a field of the table */
+  static constexpr Table::FieldIndex kUnresolved =
+      static_cast<Table::FieldIndex>(-2);
+
+  /** Field indices of a plan for one schema generation */
+  struct Resolution {
+    uint64_t generation = 0;
+    /** One entry per field operand */
+    std::vector<Table::FieldIndex> operands;
+    /** One entry per condition; KEY conditions are left unresolved */
+    std::vector<Table::FieldIndex> conditions;
+  };
+
+  /**
+   * Build a plan
+   * @param fieldOperands The leading operands that name fields
+   * @param conditions The conditions of the statement (values are ignored)
+   */
+  QueryPlan(std::vector<std::string> fieldOperands,
+            const std::vector<QueryCondition> &conditions);
+
+  /**
+   * Map a condition operator to its comparison
+   * @param op The operator token
+   * @return The comparison, or an empty function if op is not an operator
+   */
+  [[nodiscard]] static Comparator comparatorFor(std::string_view op);
+
+  /**
+   * Get the comparison of a condition
+   * @param index Position of the condition in the statement
+   */
+  [[nodiscard]] const Comparator &comparator(size_t index) const {
+    return comparators[index];
+  }
+
+  /** Get the number of leading operands that name fields */
+  [[nodiscard]] size_t fieldOperandCount() const {
+    return fieldOperands.size();
+  }
+
+  /**
+   * Get the field indices for a table, resolving them on the first use of a
+   * schema generation
+   * @param table The target table
+   */
+  [[nodiscard]] std::shared_ptr<const Resolution> resolve(const Table &table);
+
+private:
+  std::vector<std::string> fieldOperands;
+  std::vector<std::string> conditionFields;
+  std::vector<Comparator> comparators;
+  std::atomic<std::shared_ptr<const Resolution>> resolution;
+};
+
+/**
+ * PlanCache: process-wide map of statement shape -> QueryPlan
+ *
+ * Lookups come from the parser, possibly on several pipeline workers at
+ * once. The cache is bounded: once it holds kMaxPlans shapes it is emptied
+ * and refilled by the statements that follow. Plans already handed out stay
+ * valid.
+ */
+class PlanCache {
+public:
+  static constexpr size_t kMaxPlans = 4096;
+
+  [[nodiscard]] static PlanCache &getInstance() {
+    static PlanCache instance;
+    return instance;
+  }
+
+  PlanCache(const PlanCache &) = delete;
+  PlanCache &operator=(const PlanCache &) = delete;
+  PlanCache(PlanCache &&) = delete;
+  PlanCache &operator=(PlanCache &&) = delete;
+  ~PlanCache() = default;
+
+  /**
+   * Find the plan of a shape
+   * @param shape The normalized statement shape
+   * @return The plan, or nullptr if the shape has not been seen
+   */
+  [[nodiscard]] QueryPlan::Ptr find(std::string_view shape) const;
+
+  /**
+   * Add the plan of a shape
+   * @param shape The normalized statement shape
+   * @param plan The plan built for it
+   * @return The cached plan, which is an earlier one if another thread added
+   * the same shape first
+   */
+  QueryPlan::Ptr insert(std::string_view shape, QueryPlan::Ptr plan);
+
+private:
+  PlanCache() = default;
+
+  struct ShapeHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view shape) const {
+      return std::hash<std::string_view>{}(shape);
+    }
+  };
+
+  mutable std::shared_mutex mutex;
+  std::unordered_map<std::string, QueryPlan::Ptr, ShapeHash, std::equal_to<>>
+      plans;
+};
+
+#endif  // PROJECT_QUERY_PLAN_H
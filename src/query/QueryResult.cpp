@@ -5,25 +5,44 @@
 #include "QueryResult.h"
 
 #include <ostream>
-#include <sstream>
 #include <string>
 #include <utility>
-#include <vector>
+
+#include "../utils/ResultBuffer.h"
 
 std::ostream &operator<<(std::ostream &out, const QueryResult &table) {
-  return table.output(out);
+  const auto buffer = ResultBuffer::acquire();
+  table.render(*buffer);
+  return out << buffer->view();
+}
+
+ResultBuffer::Ptr QueryResult::takeBuffer() {
+  auto buffer = ResultBuffer::acquire();
+  render(*buffer);
+  return buffer;
 }
 
 std::string QueryResult::buildMessage(std::string &&msg) {
   return std::move(msg);
 }
 
-std::string QueryResult::buildMessage(const std::vector<int> &results) {
-  std::stringstream stream;
-  stream << "ANSWER = ( ";
-  for (auto result : results) {
-    stream << result << " ";
+void SuccessMsgResult::render(ResultBuffer &out) const {
+  if (!msg.empty()) {
+    out << msg << '\n';
+  } else if (single) {
+    out << "ANSWER = \"" << answers.front() << "\".\n";
+  } else {
+    out << "ANSWER = ( ";
+    for (const auto answer : answers) {
+      out << answer << ' ';
+    }
+    out << ")\n";
   }
-  stream << ")";
-  return stream.str();
-}
\ No newline at end of file
+}
+
+ResultBuffer::Ptr TextRowsResult::takeBuffer() {
+  if (payload == nullptr) [[unlikely]] {
+    return ResultBuffer::acquire();
+  }
+  return std::move(payload);
+}
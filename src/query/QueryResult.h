@@ -8,9 +8,11 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#include "../utils/ResultBuffer.h"
 #include "../utils/formatter.h"
 
 class QueryResult {
@@ -31,10 +33,20 @@ public:
 
   friend std::ostream &operator<<(std::ostream &out, const QueryResult &table);
 
+  /**
+   * Hand over the printed text of the result. The result may give away its
+   * own buffer, so this is called at most once.
+   * @return a buffer holding the text
+   */
+  [[nodiscard]] virtual ResultBuffer::Ptr takeBuffer();
+
 protected:
-  virtual std::ostream &output(std::ostream &out) const = 0;
+  /**
+   * Append the printed text of the result
+   * @param out The buffer to write to
+   */
+  virtual void render(ResultBuffer &out) const = 0;
   static std::string buildMessage(std::string &&msg);
-  static std::string buildMessage(const std::vector<int> &results);
 };
 
 class FailedQueryResult : public QueryResult {
@@ -56,7 +68,7 @@ public:
   bool display() override { return false; }
 
 protected:
-  std::ostream &output(std::ostream &out) const override { return out << "\n"; }
+  void render(ResultBuffer &out) const override { out << '\n'; }
 };
 
 class ErrorMsgResult : public FailedQueryResult {
@@ -83,14 +95,17 @@ public:
                          table % msg)) {}
 
 protected:
-  std::ostream &output(std::ostream &out) const override {
-    return out << msg << "\n";
-  }
+  void render(ResultBuffer &out) const override { out << msg << '\n'; }
 };
 
 class SuccessMsgResult : public SucceededQueryResult {
   bool debug_ = true;
+  /** Text of a message result, empty for an answer */
   std::string msg;
+  /** Values of an answer, formatted only when printed */
+  std::vector<int> answers;
+  /** Whether the answer is a single number rather than a list */
+  bool single = false;
 
 public:
   bool display() override { return debug_; }
@@ -99,13 +114,13 @@ public:
    * Construct a success result with a number
    */
   explicit SuccessMsgResult(const int number, bool debug = true)
-      : debug_(debug), msg(buildMessage(R"(ANSWER = "?".)"_f % number)) {}
+      : debug_(debug), answers{number}, single(true) {}
 
   /**
    * Construct a success result with a vector of results
    */
-  explicit SuccessMsgResult(const std::vector<int> &results, bool debug = true)
-      : debug_(debug), msg(buildMessage(results)) {}
+  explicit SuccessMsgResult(std::vector<int> results, bool debug = true)
+      : debug_(debug), answers(std::move(results)) {}
 
   /**
    * Construct a success result with query name
@@ -131,9 +146,7 @@ public:
                          table % msg)) {}
 
 protected:
-  std::ostream &output(std::ostream &out) const override {
-    return out << msg << "\n";
-  }
+  void render(ResultBuffer &out) const override;
 };
 
 class RecordCountResult : public SucceededQueryResult {
@@ -148,13 +161,13 @@ public:
   explicit RecordCountResult(int count) : affectedRows(count) {}
 
 protected:
-  std::ostream &output(std::ostream &out) const override {
-    return out << "Affected ? rows."_f % affectedRows << "\n";
+  void render(ResultBuffer &out) const override {
+    out << "Affected " << affectedRows << " rows.\n";
   }
 };
 
 class TextRowsResult : public SucceededQueryResult {
-  std::string payload;
+  ResultBuffer::Ptr payload;
 
 public:
   bool display() override { return true; }
@@ -162,12 +175,22 @@ public:
   /**
    * Construct a result with text payload
    */
-  explicit TextRowsResult(std::string payload_str)
-      : payload(std::move(payload_str)) {}
+  explicit TextRowsResult(std::string_view payload_str)
+      : payload(ResultBuffer::acquire(payload_str)) {}
+
+  /**
+   * Construct a result from rows already formatted into a buffer
+   */
+  explicit TextRowsResult(ResultBuffer::Ptr rows) : payload(std::move(rows)) {}
+
+  /** Give away the payload buffer without copying it */
+  [[nodiscard]] ResultBuffer::Ptr takeBuffer() override;
 
 protected:
-  std::ostream &output(std::ostream &out) const override {
-    return out << payload;
+  void render(ResultBuffer &out) const override {
+    if (payload != nullptr) [[likely]] {
+      out << payload->view();
+    }
   }
 };
 
@@ -183,9 +206,8 @@ public:
   explicit ListenResult(std::string name) : listen_name(std::move(name)) {}
 
 protected:
-  std::ostream &output(std::ostream &ostring) const override {
-    ostring << "ANSWER = ( listening from " << listen_name << " )\n";
-    return ostring;
+  void render(ResultBuffer &out) const override {
+    out << "ANSWER = ( listening from " << listen_name << " )\n";
   }
 };
 
@@ -0,0 +1,86 @@
+#include "ResultCache.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "../utils/ResultBuffer.h"
+
+ResultCache::ResultCache() {
+  // Cached buffers return to the buffer pool when released, so the pool is
+  // constructed first to be destroyed after them
+  (void)ResultBuffer::acquire();
+}
+
+void ResultCache::setCapacity(size_t bytes) {
+  const std::scoped_lock lock(mutex);
+  maxBytes.store(bytes, std::memory_order_relaxed);
+  evictTo(bytes);
+}
+
+std::optional<ResultBuffer::Ptr> ResultCache::find(std::string_view query,
+                                                   uint64_t version) {
+  const std::scoped_lock lock(mutex);
+  const auto found = index.find(query);
+  if (found == index.end()) [[likely]] {
+    missCount.fetch_add(1, std::memory_order_relaxed);
+    return std::nullopt;
+  }
+  const auto entry = found->second;
+  if (entry->version != version) [[unlikely]] {
+    // The table was written since; the result can never be used again
+    erase(entry);
+    missCount.fetch_add(1, std::memory_order_relaxed);
+    return std::nullopt;
+  }
+  entries.splice(entries.begin(), entries, entry);
+  hitCount.fetch_add(1, std::memory_order_relaxed);
+  return entry->result;
+}
+
+bool ResultCache::contains(std::string_view query, uint64_t version) const {
+  const std::scoped_lock lock(mutex);
+  const auto found = index.find(query);
+  return found != index.end() && found->second->version == version;
+}
+
+void ResultCache::insert(std::string_view query, uint64_t version,
+                         ResultBuffer::Ptr result) {
+  const size_t bytes = query.size() +
+                       (result != nullptr ? result->size() : 0) +
+                       kEntryOverhead;
+  const std::scoped_lock lock(mutex);
+  const size_t cap = maxBytes.load(std::memory_order_relaxed);
+  if (bytes > cap) [[unlikely]] {
+    return;
+  }
+  if (const auto found = index.find(query); found != index.end()) {
+    erase(found->second);
+  }
+  evictTo(cap - bytes);
+  entries.push_front({std::string(query), version, std::move(result), bytes});
+  index.emplace(entries.front().query, entries.begin());
+  used += bytes;
+}
+
+size_t ResultCache::usedBytes() const {
+  const std::scoped_lock lock(mutex);
+  return used;
+}
+
+void ResultCache::erase(Lru::iterator entry) {
+  index.erase(entry->query);
+  used -= entry->bytes;
+  entries.erase(entry);
+}
+
+void ResultCache::evictTo(size_t bytes) {
+  while (used > bytes) {
+    erase(std::prev(entries.end()));
+  }
+}
@@ -0,0 +1,126 @@
+#ifndef PROJECT_RESULT_CACHE_H
+#define PROJECT_RESULT_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "../utils/ResultBuffer.h"
+
+/**
+ * ResultCache: process-wide LRU cache of read query results
+ *
+ * Entries are keyed by the normalized query (type, table, operands and
+ * conditions) and tagged with the data version of the table the result was
+ * computed from (see Table::dataVersion). A lookup with another version finds
+ * a stale entry and drops it, so writers never have to reach the cache.
+ *
+ * Results are kept as their printed bytes, shared with the output rather than
+ * copied (see ResultBuffer). The cache holds at most capacity() bytes of keys
+ * and results, evicting the least recently used entries; a capacity of 0
+ * disables it.
+ */
+class ResultCache {
+public:
+  static constexpr size_t kDefaultCapacity = size_t{64} << 20U;
+  /** Bookkeeping bytes charged to each entry besides its key and result */
+  static constexpr size_t kEntryOverhead = 128;
+
+  [[nodiscard]] static ResultCache &getInstance() {
+    static ResultCache instance;
+    return instance;
+  }
+
+  ResultCache(const ResultCache &) = delete;
+  ResultCache &operator=(const ResultCache &) = delete;
+  ResultCache(ResultCache &&) = delete;
+  ResultCache &operator=(ResultCache &&) = delete;
+  ~ResultCache() = default;
+
+  /**
+   * Set the memory cap, evicting entries beyond it
+   * @param bytes The cap; 0 disables the cache
+   */
+  void setCapacity(size_t bytes);
+
+  [[nodiscard]] size_t capacity() const {
+    return maxBytes.load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] bool isEnabled() const { return capacity() != 0; }
+
+  /**
+   * Find the result of a query computed under a data version
+   * @param query The normalized query
+   * @param version The current data version of the query's table
+   * @return the printed result (nullptr if it prints nothing), or nullopt on
+   * a miss
+   */
+  [[nodiscard]] std::optional<ResultBuffer::Ptr> find(std::string_view query,
+                                                      uint64_t version);
+
+  /**
+   * Check whether a query has a result computed under a data version,
+   * without counting a lookup or refreshing the entry
+   * @param query The normalized query
+   * @param version The current data version of the query's table
+   */
+  [[nodiscard]] bool contains(std::string_view query, uint64_t version) const;
+
+  /**
+   * Add the result of a query, replacing an earlier one
+   * @param query The normalized query
+   * @param version The data version the result was computed under
+   * @param result The printed result, or nullptr if it prints nothing; it
+   * must not be changed afterwards
+   */
+  void insert(std::string_view query, uint64_t version,
+              ResultBuffer::Ptr result);
+
+  /** Get the number of lookups that found a result */
+  [[nodiscard]] uint64_t hits() const {
+    return hitCount.load(std::memory_order_relaxed);
+  }
+
+  /** Get the number of lookups that found none */
+  [[nodiscard]] uint64_t misses() const {
+    return missCount.load(std::memory_order_relaxed);
+  }
+
+  /** Get the bytes currently charged to the entries */
+  [[nodiscard]] size_t usedBytes() const;
+
+private:
+  ResultCache();
+
+  struct Entry {
+    std::string query;
+    uint64_t version;
+    ResultBuffer::Ptr result;
+    size_t bytes;
+  };
+  using Lru = std::list<Entry>;
+
+  /** Protects entries, index and used */
+  mutable std::mutex mutex;
+  /** Most recently used first */
+  Lru entries;
+  /** Keys view the query of their entry */
+  std::unordered_map<std::string_view, Lru::iterator> index;
+  size_t used = 0;
+
+  std::atomic<size_t> maxBytes{kDefaultCapacity};
+  std::atomic<uint64_t> hitCount{0};
+  std::atomic<uint64_t> missCount{0};
+
+  void erase(Lru::iterator entry);
+  void evictTo(size_t bytes);
+};
+
+#endif  // PROJECT_RESULT_CACHE_H
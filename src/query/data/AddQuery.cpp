@@ -89,9 +89,9 @@ AddQuery::getFieldIndices(const Table &table) const {
   std::vector<Table::FieldIndex> indices;
   indices.reserve(this->getOperands().size());
   const auto &operands = this->getOperands();
-  std::transform(
-      operands.begin(), operands.end(), std::back_inserter(indices),
-      [&table](const auto &operand) { return table.getFieldIndex(operand); });
+  for (size_t index = 0; index < operands.size(); ++index) [[likely]] {
+    indices.push_back(operandFieldIndex(table, index));
+  }
   return indices;
 }
 
@@ -111,6 +111,7 @@ AddQuery::getFieldIndices(const Table &table) const {
     {
       sum += row[fids[idx]];
     }
+    table.markDirty(row);
     row[fids.back()] = sum;
     count++;
   }
@@ -137,7 +138,7 @@ AddQuery::executeMultiThreaded(Table &table,
     auto chunk_end = iterator;
     futures.push_back(
         // NOLINTNEXTLINE(bugprone-exception-escape)
-        pool.submit([this, chunk_start, chunk_end, fids]() {
+        pool.submit([this, &table, chunk_start, chunk_end, fids]() {
           int local_count = 0;
           for (auto it = chunk_start; it != chunk_end; ++it) [[likely]]
           {
@@ -151,6 +152,7 @@ AddQuery::executeMultiThreaded(Table &table,
             {
               sum += (*it)[fids[i]];
             }
+            table.markDirty(*it);
             (*it)[fids.back()] = sum;
             local_count++;
           }
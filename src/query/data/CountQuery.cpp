@@ -5,17 +5,77 @@
 #include <future>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
-#include "../../db/Database.h"
 #include "../../db/Table.h"
 #include "../../db/TableLockManager.h"
 #include "../../threading/Threadpool.h"
+#include "../../utils/ResultBuffer.h"
 #include "../../utils/uexception.h"
 #include "../QueryResult.h"
 
+namespace {
+/** COUNT's part in a shared scan: the number of matching rows of each block */
+class CountScan : public ScanQuery::Scan {
+  ComplexQuery &query;
+  std::vector<int> counts;
+
+public:
+  CountScan(ComplexQuery &query, Table::SizeType blockCount)
+      : query(query), counts(blockCount, 0) {}
+
+  void scanBlock(const Table &table, Table::SizeType block) override {
+    int local_count = 0;
+    forEachMatch(query, table, block,
+                 [&local_count](const Datum &) { local_count++; });
+    counts[block] = local_count;
+  }
+
+  QueryResult::Ptr finish() override {
+    int total_count = 0;
+    for (const int local_count : counts) [[likely]]
+    {
+      total_count += local_count;
+    }
+    auto answer = ResultBuffer::acquire();
+    *answer << "ANSWER = " << total_count << '\n';
+    return std::make_unique<TextRowsResult>(std::move(answer));
+  }
+};
+
+/** COUNT kept up to date: the number of matching rows */
+class CountView : public ScanQuery::View {
+  Table::SizeType count = 0;
+
+public:
+  using View::View;
+
+  void reset() override { count = 0; }
+
+  void apply(const Datum &row) override {
+    if (matches(row)) [[likely]] {
+      ++count;
+    }
+  }
+
+  bool retract(const Datum &row) override {
+    if (matches(row)) [[likely]] {
+      --count;
+    }
+    return true;
+  }
+
+  [[nodiscard]] QueryResult::Ptr result() const override {
+    auto answer = ResultBuffer::acquire();
+    *answer << "ANSWER = " << count << '\n';
+    return std::make_unique<TextRowsResult>(std::move(answer));
+  }
+};
+}  // namespace
+
 // Implementation of the execute method for CountQuery
-QueryResult::Ptr CountQuery::execute() {
+QueryResult::Ptr CountQuery::executeScan() {
   // Use a try-catch block to handle potential exceptions gracefully
   try {
     // Validate operands
@@ -24,12 +84,8 @@ QueryResult::Ptr CountQuery::execute() {
       return validation_result;
     }
 
-    // Get a reference to the database singleton instance
-    Database &database = Database::getInstance();
-    auto lock =
-        TableLockManager::getInstance().acquireRead(this->targetTableRef());
-    // Access the target table using the table name
-    const Table &table = database[this->targetTableRef()];
+    TableLockManager::ReadLock lock;
+    const Table &table = readTable(lock);
 
     // Initialize the WHERE clause condition. The 'second' member of the
     // returned pair is a flag indicating if the condition can ever be true.
@@ -69,6 +125,25 @@ QueryResult::Ptr CountQuery::execute() {
   }
 }
 
+std::unique_ptr<ScanQuery::Scan> CountQuery::openScan(const Table &table) {
+  if (validateOperands() != nullptr || !initCondition(table).second)
+      [[unlikely]] {
+    return nullptr;
+  }
+  return std::make_unique<CountScan>(*this, table.blockCount());
+}
+
+std::unique_ptr<ScanQuery::View> CountQuery::openView(const Table &table) {
+  if (validateOperands() != nullptr) [[unlikely]] {
+    return nullptr;
+  }
+  const auto resolved = initCondition(table);
+  if (!resolved.second || !resolved.first.empty()) [[unlikely]] {
+    return nullptr;
+  }
+  return std::make_unique<CountView>(getCondition());
+}
+
 // Implementation of the toString method
 std::string CountQuery::toString() {
   // Returns a string representation of the query, useful for debugging.
@@ -95,8 +170,9 @@ CountQuery::executeSingleThreaded(const Table &table) {
     }
   }
 
-  return std::make_unique<TextRowsResult>(
-      "ANSWER = " + std::to_string(record_count) + "\n");
+  auto answer = ResultBuffer::acquire();
+  *answer << "ANSWER = " << record_count << '\n';
+  return std::make_unique<TextRowsResult>(std::move(answer));
 }
 
 [[nodiscard]] QueryResult::Ptr
@@ -137,6 +213,7 @@ CountQuery::executeMultiThreaded(const Table &table) {
     total_count += future.get();
   }
 
-  return std::make_unique<TextRowsResult>(
-      "ANSWER = " + std::to_string(total_count) + "\n");
+  auto answer = ResultBuffer::acquire();
+  *answer << "ANSWER = " << total_count << '\n';
+  return std::make_unique<TextRowsResult>(std::move(answer));
 }
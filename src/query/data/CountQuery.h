@@ -1,13 +1,14 @@
 #ifndef PROJECT_COUNTQUERY_H
 #define PROJECT_COUNTQUERY_H
 
+#include <memory>
 #include <string>
 
 #include "../../db/Table.h"
 #include "../Query.h"
 #include "../QueryResult.h"
 
-class CountQuery : public ComplexQuery {
+class CountQuery : public ScanQuery {
   // Define the query name as a constant
   static constexpr const char *qname = "COUNT";
 
@@ -33,20 +34,24 @@ private:
   [[nodiscard]] QueryResult::Ptr executeMultiThreaded(const Table &table);
 
 public:
-  // Inherit constructors from the ComplexQuery base class
-  using ComplexQuery::ComplexQuery;
-
-  /**
-   * Execute the COUNT query
-   * @return QueryResult with count of matching records
-   */
-  QueryResult::Ptr execute() override;
+  // Inherit constructors from the ScanQuery base class
+  using ScanQuery::ScanQuery;
 
   /**
    * Convert query to string representation
    * @return String representation of the COUNT query
    */
   std::string toString() override;
+
+protected:
+  /**
+   * Execute the COUNT query
+   * @return QueryResult with count of matching records
+   */
+  QueryResult::Ptr executeScan() override;
+
+  std::unique_ptr<Scan> openScan(const Table &table) override;
+  std::unique_ptr<View> openView(const Table &table) override;
 };
 
 #endif  // PROJECT_COUNTQUERY_H
@@ -1,21 +1,39 @@
 
 #include <cstddef>
 #include <exception>
-#include <future>
 #include <memory>
 #include <stdexcept>
 #include <string>
-#include <vector>
+#include <utility>
 
 #include "../../db/Database.h"
 #include "../../db/Table.h"
 #include "../../db/TableLockManager.h"
-#include "../../threading/Threadpool.h"
+#include "../../threading/Reclaimer.h"
 #include "../../utils/formatter.h"
 #include "../../utils/uexception.h"
 #include "../QueryResult.h"
 #include "DeleteQuery.h"
 
+namespace {
+/**
+ * Free what a DELETE took out of the table on the Reclaimer's thread if it
+ * deleted many rows
+ * @param deleted What the table let go of
+ * @param rows Number of rows deleted
+ * @param fieldCount Number of fields of each row
+ */
+void disposeDeleted(Table::DeletedRows &&deleted, size_t rows,
+                    size_t fieldCount) {
+  if (rows < Table::splitsize()) [[likely]] {
+    return;  // Cheap enough to free in place
+  }
+  Reclaimer::getInstance().dispose(
+      std::make_unique<Table::DeletedRows>(std::move(deleted)),
+      Table::estimateBytes(rows, fieldCount));
+}
+}  // namespace
+
 [[nodiscard]] QueryResult::Ptr DeleteQuery::execute() {
   if (!this->getOperands().empty()) [[unlikely]] {
     return std::make_unique<ErrorMsgResult>(
@@ -33,16 +51,24 @@
       throw IllFormedQueryCondition("Error conditions in WHERE clause.");
     }
 
-    if (!ThreadPool::isInitialized()) [[unlikely]] {
-      return executeSingleThreaded(table);
+    Table::SizeType counter = 0;
+    const bool handled = this->testKeyCondition(
+        table, [&table, &counter](bool success, Table::Object::Ptr &&obj) {
+          if (success && obj) [[likely]] {
+            table.deleteByIndex(Table::KeyType(obj->key()));
+            counter = 1;
+          }
+        });
+    if (handled) [[unlikely]] {
+      return std::make_unique<RecordCountResult>(counter);
     }
 
-    const ThreadPool &pool = ThreadPool::getInstance();
-    if (pool.getThreadCount() <= 1 || table.size() < Table::splitsize()) {
-      return executeSingleThreaded(table);
-    }
-
-    return executeMultiThreaded(table);
+    Table::DeletedRows deleted;
+    counter = table.deleteWhere(
+        [this](const Table::ConstObject &row) { return evalCondition(row); },
+        &deleted);
+    disposeDeleted(std::move(deleted), counter, table.field().size());
+    return std::make_unique<RecordCountResult>(counter);
   } catch (const NotFoundKey &e) {
     return std::make_unique<ErrorMsgResult>(qname, this->targetTableRef(),
                                             "Key not found.");
@@ -62,70 +88,6 @@
   }
 }
 
-[[nodiscard]] QueryResult::Ptr
-DeleteQuery::executeSingleThreaded(Table &table) {
-  Table::SizeType counter = 0;
-  std::vector<Table::KeyType> keysToDelete;
-
-  // Single-threaded collection of keys to delete
-  for (auto it = table.begin(); it != table.end(); ++it) {
-    if (this->evalCondition(*it)) {
-      keysToDelete.push_back(it->key());
-      ++counter;
-    }
-  }
-
-  // Single-threaded deletion of collected keys
-  for (const auto &key : keysToDelete) {
-    table.deleteByIndex(key);
-  }
-
-  return std::make_unique<RecordCountResult>(counter);
-}
-
-[[nodiscard]] QueryResult::Ptr DeleteQuery::executeMultiThreaded(Table &table) {
-  constexpr size_t CHUNK_SIZE = Table::splitsize();
-  const ThreadPool &pool = ThreadPool::getInstance();
-  std::vector<std::future<std::vector<Table::KeyType>>> futures;
-  futures.reserve((table.size() + CHUNK_SIZE - 1) / CHUNK_SIZE);
-
-  auto iterator = table.begin();
-  while (iterator != table.end()) {
-    auto chunk_start = iterator;
-    size_t count = 0;
-    while (iterator != table.end() && count < CHUNK_SIZE) {
-      ++iterator;
-      ++count;
-    }
-    auto chunk_end = iterator;
-    futures.push_back(pool.submit([this, chunk_start, chunk_end]() {
-      std::vector<Table::KeyType> local_keys;
-      for (auto it = chunk_start; it != chunk_end; ++it) {
-        if (this->evalCondition(*it)) {
-          local_keys.push_back(it->key());
-        }
-      }
-      return local_keys;
-    }));
-  }
-
-  // Collect all keys from parallel tasks
-  std::vector<Table::KeyType> allKeysToDelete;
-  for (auto &future : futures) {
-    auto keys = future.get();
-    allKeysToDelete.insert(allKeysToDelete.end(), keys.begin(), keys.end());
-  }
-
-  // Single-threaded deletion of all collected keys
-  Table::SizeType counter = 0;
-  for (const auto &key : allKeysToDelete) {
-    table.deleteByIndex(key);
-    ++counter;
-  }
-
-  return std::make_unique<RecordCountResult>(counter);
-}
-
 std::string DeleteQuery::toString() {
   return "QUERY = DELETE " + this->targetTableRef() + "\"";
 }
@@ -10,20 +10,6 @@
 class DeleteQuery : public ComplexQuery {
   static constexpr const char *qname = "DELETE";
 
-  /**
-   * Execute DELETE operation using single-threaded approach
-   * @param table The table to delete records from
-   * @return QueryResult with deletion results
-   */
-  [[nodiscard]] QueryResult::Ptr executeSingleThreaded(Table &table);
-
-  /**
-   * Execute DELETE operation using multi-threaded approach
-   * @param table The table to delete records from
-   * @return QueryResult with deletion results
-   */
-  [[nodiscard]] QueryResult::Ptr executeMultiThreaded(Table &table);
-
 public:
   using ComplexQuery::ComplexQuery;
 
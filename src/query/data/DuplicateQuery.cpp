@@ -36,8 +36,6 @@ QueryResult::Ptr DuplicateQuery::execute() {
     }
 
     // Decide between single-threaded and multi-threaded execution
-    std::vector<RecordPair> recordsToDuplicate;
-
     bool useMultiThreading = ThreadPool::isInitialized();
     if (useMultiThreading) {
       const ThreadPool &pool = ThreadPool::getInstance();
@@ -49,20 +47,9 @@ QueryResult::Ptr DuplicateQuery::execute() {
     const auto execFn = useMultiThreading
                             ? &DuplicateQuery::executeMultiThreaded
                             : &DuplicateQuery::executeSingleThreaded;
-    recordsToDuplicate = (this->*execFn)(table);
-
-    // Insert all duplicated records (in order preserved by helpers)
-    Table::SizeType counter = 0;
-    for (auto &record : recordsToDuplicate) [[likely]]
-    {
-      try {
-        table.insertByIndex(record.first, std::move(record.second));
-        ++counter;
-      } catch (const ConflictingKey &e) {
-        // Intentionally ignore: if key conflict exists, skip this record
-        (void)e;
-      }
-    }
+    // Rows whose "_copy" already exists are skipped by appendUnique
+    const Table::SizeType counter =
+        table.appendUnique((this->*execFn)(table));
 
     return std::make_unique<RecordCountResult>(counter);
   } catch (const NotFoundKey &e) {
@@ -97,49 +84,26 @@ std::string DuplicateQuery::toString() {
   return nullptr;
 }
 
-[[nodiscard]] std::vector<DuplicateQuery::RecordPair>
+[[nodiscard]] std::vector<Datum>
 DuplicateQuery::executeSingleThreaded(Table &table) {
-  std::vector<RecordPair> recordsToDuplicate;
-  auto row_size = table.field().size();
-
+  std::vector<Datum> copies;
   for (auto it = table.begin(); it != table.end(); ++it) [[likely]]
   {
-    if (!this->evalCondition(*it)) [[unlikely]] {
-      continue;
-    }
-
-    auto originalKey = it->key();
-    auto newKey = originalKey + "_copy";
-
-    // if a "_copy" already exists, skip this key
-    if (table[newKey] != nullptr) [[unlikely]] {
-      continue;
+    if (this->evalCondition(*it)) [[unlikely]] {
+      copies.emplace_back(it->key() + "_copy", it->datumAccess());
     }
-
-    // Copy the values from the original record
-    std::vector<Table::ValueType> values(row_size);
-    for (size_t i = 0; i < row_size; ++i) [[likely]]
-    {
-      values[i] = (*it)[i];
-    }
-
-    recordsToDuplicate.emplace_back(newKey, std::move(values));
   }
-
-  return recordsToDuplicate;
+  return copies;
 }
 
-[[nodiscard]] std::vector<DuplicateQuery::RecordPair>
+[[nodiscard]] std::vector<Datum>
 DuplicateQuery::executeMultiThreaded(Table &table) {
   constexpr size_t CHUNK_SIZE = Table::splitsize();
   const ThreadPool &pool = ThreadPool::getInstance();
-  auto row_size = table.field().size();
 
-  // Collect tasks with their positions to preserve order
-  std::vector<std::pair<size_t, std::future<std::vector<RecordPair>>>> tasks;
+  std::vector<std::future<std::vector<Datum>>> tasks;
   tasks.reserve((table.size() + CHUNK_SIZE - 1) / CHUNK_SIZE);
 
-  size_t chunk_index = 0;
   auto iterator = table.begin();
   while (iterator != table.end()) [[likely]] {
     auto chunk_begin = iterator;
@@ -150,47 +114,24 @@ DuplicateQuery::executeMultiThreaded(Table &table) {
     }
     auto chunk_end = iterator;
 
-    const size_t current_chunk_index = chunk_index;
-    tasks.emplace_back(
-        current_chunk_index,
-        pool.submit([this, &table, chunk_begin, chunk_end, row_size]() {
-          std::vector<RecordPair> local_records;
-          for (auto it = chunk_begin; it != chunk_end; ++it) [[likely]]
-          {
-            if (!this->evalCondition(*it)) [[unlikely]] {
-              continue;
-            }
-
-            auto originalKey = it->key();
-            auto newKey = originalKey + "_copy";
-
-            // Check if _copy already exists
-            if (table[newKey] != nullptr) [[unlikely]] {
-              continue;
-            }
-
-            // Copy the values
-            std::vector<Table::ValueType> values(row_size);
-            for (size_t i = 0; i < row_size; ++i) [[likely]]
-            {
-              values[i] = (*it)[i];
-            }
-
-            local_records.emplace_back(newKey, std::move(values));
-          }
-          return local_records;
-        }));
-    ++chunk_index;
+    tasks.push_back(pool.submit([this, chunk_begin, chunk_end]() {
+      std::vector<Datum> local_copies;
+      for (auto it = chunk_begin; it != chunk_end; ++it) [[likely]]
+      {
+        if (this->evalCondition(*it)) [[unlikely]] {
+          local_copies.emplace_back(it->key() + "_copy", it->datumAccess());
+        }
+      }
+      return local_copies;
+    }));
   }
 
-  // Merge results in order (preserve chunk order)
-  std::vector<RecordPair> allRecords;
-  for (auto &[idx, future] : tasks) [[likely]] {
-    auto local_records = future.get();
-    allRecords.insert(allRecords.end(),
-                      make_move_iterator(local_records.begin()),
-                      make_move_iterator(local_records.end()));
+  // Merge results in chunk order
+  std::vector<Datum> copies;
+  for (auto &future : tasks) [[likely]] {
+    auto local_copies = future.get();
+    copies.insert(copies.end(), make_move_iterator(local_copies.begin()),
+                  make_move_iterator(local_copies.end()));
   }
-
-  return allRecords;
+  return copies;
 }
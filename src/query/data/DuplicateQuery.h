@@ -2,9 +2,9 @@
 #define PROJECT_DUPLICATEQUERY_H
 
 #include <string>
-#include <utility>
 #include <vector>
 
+#include "../../db/Datum.h"
 #include "../../db/Table.h"
 #include "../Query.h"
 #include "../QueryResult.h"
@@ -12,9 +12,6 @@
 class DuplicateQuery : public ComplexQuery {
   static constexpr const char *qname = "DUPLICATE";
 
-  // Type alias for records to duplicate
-  using RecordPair = std::pair<Table::KeyType, std::vector<Table::ValueType>>;
-
 private:
   /**
    * Validate operands for DUPLICATE query
@@ -25,16 +22,16 @@ private:
   /**
    * Execute DUPLICATE operation using single-threaded approach
    * @param table The table to duplicate records from
-   * @return Vector of record pairs to duplicate
+   * @return the copies of the matching rows, in table order
    */
-  [[nodiscard]] std::vector<RecordPair> executeSingleThreaded(Table &table);
+  [[nodiscard]] std::vector<Datum> executeSingleThreaded(Table &table);
 
   /**
    * Execute DUPLICATE operation using multi-threaded approach
    * @param table The table to duplicate records from
-   * @return Vector of record pairs to duplicate
+   * @return the copies of the matching rows, in table order
    */
-  [[nodiscard]] std::vector<RecordPair> executeMultiThreaded(Table &table);
+  [[nodiscard]] std::vector<Datum> executeMultiThreaded(Table &table);
 
 public:
   using ComplexQuery::ComplexQuery;
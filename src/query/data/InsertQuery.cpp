@@ -4,10 +4,12 @@
 
 #include "InsertQuery.h"
 
+#include <cstddef>
 #include <cstdlib>
 #include <exception>
 #include <memory>
 #include <stdexcept>
+#include <span>
 #include <string>
 #include <utility>
 #include <vector>
@@ -19,8 +21,19 @@
 #include "../../utils/uexception.h"
 #include "../QueryResult.h"
 
-QueryResult::Ptr InsertQuery::execute() {
+std::vector<Table::ValueType> InsertQuery::parseFields() const {
   const int DECIMAL_BASE = 10;
+  std::vector<Table::ValueType> data;
+  data.reserve(this->getOperands().size() - 1);
+  for (auto it = ++this->getOperands().begin();
+       it != this->getOperands().end(); ++it) [[likely]]
+  {
+    data.emplace_back(strtol(it->c_str(), nullptr, DECIMAL_BASE));
+  }
+  return data;
+}
+
+QueryResult::Ptr InsertQuery::execute() {
   if (this->getOperands().empty()) [[unlikely]] {
     return std::make_unique<ErrorMsgResult>(
         qname, this->targetTableRef().c_str(),
@@ -32,15 +45,7 @@ QueryResult::Ptr InsertQuery::execute() {
     auto lock =
         TableLockManager::getInstance().acquireWrite(this->targetTableRef());
     auto &table = database[this->targetTableRef()];
-    const auto &key = this->getOperands().front();
-    std::vector<Table::ValueType> data;
-    data.reserve(this->getOperands().size() - 1);
-    for (auto it = ++this->getOperands().begin();
-         it != this->getOperands().end(); ++it) [[likely]]
-    {
-      data.emplace_back(strtol(it->c_str(), nullptr, DECIMAL_BASE));
-    }
-    table.insertByIndex(key, std::move(data));
+    table.insertByIndex(this->getOperands().front(), parseFields());
     return std::make_unique<SuccessMsgResult>(qname, this->targetTableRef());
   } catch (const TableNameNotFound &e) {
     return std::make_unique<ErrorMsgResult>(qname, this->targetTableRef(),
@@ -58,6 +63,60 @@ QueryResult::Ptr InsertQuery::execute() {
   }
 }
 
+std::vector<QueryResult::Ptr>
+InsertQuery::executeBatch(std::span<Query *> batch) {
+  const auto &tableName = this->targetTableRef();
+  std::vector<QueryResult::Ptr> results(batch.size());
+  try {
+    auto lock = TableLockManager::getInstance().acquireWrite(tableName);
+    auto &table = Database::getInstance()[tableName];
+
+    std::vector<std::pair<Table::KeyType, std::vector<Table::ValueType>>> rows;
+    std::vector<size_t> rowQuery;
+    rows.reserve(batch.size());
+    rowQuery.reserve(batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) [[likely]] {
+      const auto &insert = static_cast<const InsertQuery &>(*batch[i]);
+      const auto &operands = insert.getOperands();
+      if (operands.empty()) [[unlikely]] {
+        results[i] = std::make_unique<ErrorMsgResult>(
+            qname, tableName.c_str(),
+            "No operand (? operands)."_f % operands.size());
+        continue;
+      }
+      rows.emplace_back(operands.front(), insert.parseFields());
+      rowQuery.push_back(i);
+    }
+
+    const auto inserted = table.tryInsertBatch(std::move(rows));
+    for (size_t row = 0; row < rowQuery.size(); ++row) [[likely]] {
+      const size_t i = rowQuery[row];
+      if (inserted[row]) [[likely]] {
+        results[i] = std::make_unique<SuccessMsgResult>(qname, tableName);
+        continue;
+      }
+      // The message insertByIndex's ConflictingKey gives in execute()
+      const auto &key =
+          static_cast<const InsertQuery &>(*batch[i]).getOperands().front();
+      results[i] = std::make_unique<ErrorMsgResult>(
+          qname, tableName,
+          "Unknown error '?'"_f % table.keyExistsMessage(key));
+    }
+    return results;
+  } catch (const TableNameNotFound &e) {
+    for (auto &result : results) {
+      result = std::make_unique<ErrorMsgResult>(qname, tableName,
+                                                std::string("No such table."));
+    }
+  } catch (const std::exception &e) {
+    for (auto &result : results) {
+      result = std::make_unique<ErrorMsgResult>(
+          qname, tableName, "Unknown error '?'."_f % e.what());
+    }
+  }
+  return results;
+}
+
 std::string InsertQuery::toString() {
   return "QUERY = INSERT " + this->targetTableRef();
 }
@@ -5,7 +5,9 @@
 #ifndef PROJECT_INSERTQUERY_H
 #define PROJECT_INSERTQUERY_H
 
+#include <span>
 #include <string>
+#include <vector>
 
 #include "../Query.h"
 #include "../QueryResult.h"
@@ -13,6 +15,9 @@
 class InsertQuery : public ComplexQuery {
   static constexpr const char *qname = "INSERT";
 
+  /** Convert the value operands to the row's fields */
+  [[nodiscard]] std::vector<Table::ValueType> parseFields() const;
+
 public:
   using ComplexQuery::ComplexQuery;
 
@@ -22,6 +27,15 @@ public:
    */
   QueryResult::Ptr execute() override;
 
+  /**
+   * Execute a run of INSERT queries on this query's table as one batch under
+   * one table lock; a key that is already in the table, or earlier in the
+   * run, fails its own query only
+   * @param batch The INSERT queries, this one first
+   * @return one result per query, the same as execute() would give
+   */
+  std::vector<QueryResult::Ptr> executeBatch(std::span<Query *> batch) override;
+
   /**
    * Convert query to string representation
    * @return String representation of the INSERT query
@@ -33,6 +47,8 @@ public:
    * @return Always returns true for INSERT queries
    */
   [[nodiscard]] bool isWriter() const override { return true; }
+  [[nodiscard]] bool isPointWriter() const override { return true; }
+  [[nodiscard]] bool isBatchable() const override { return true; }
 };
 
 #endif  // PROJECT_INSERTQUERY_H
@@ -1,6 +1,7 @@
 #ifndef PROJECT_MAXQUERY_H
 #define PROJECT_MAXQUERY_H
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -8,11 +9,11 @@
 #include "../Query.h"
 #include "../QueryResult.h"
 
-class MaxQuery : public ComplexQuery {
+class MaxQuery : public ScanQuery {
   static constexpr const char *qname = "MAX";
 
 public:
-  using ComplexQuery::ComplexQuery;
+  using ScanQuery::ScanQuery;
 
   /**
    * Validate operands for MAX query
@@ -48,9 +49,12 @@ public:
   executeMultiThreaded(const Table &table,
                        const std::vector<Table::FieldIndex> &fids);
 
-  QueryResult::Ptr execute() override;
-
   std::string toString() override;
+
+protected:
+  QueryResult::Ptr executeScan() override;
+  std::unique_ptr<Scan> openScan(const Table &table) override;
+  std::unique_ptr<View> openView(const Table &table) override;
 };
 
 #endif  // PROJECT_MAXQUERY_H
@@ -7,9 +7,9 @@
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
-#include "../../db/Database.h"
 #include "../../db/Table.h"
 #include "../../db/TableLockManager.h"
 #include "../../threading/Threadpool.h"
@@ -17,16 +17,123 @@
 #include "../../utils/uexception.h"
 #include "../QueryResult.h"
 
-QueryResult::Ptr MinQuery::execute() {
+namespace {
+/** MIN's part in a shared scan: the minima of each block */
+class MinScan : public ScanQuery::Scan {
+  ComplexQuery &query;
+  std::vector<Table::FieldIndex> fids;
+  std::vector<std::vector<Table::ValueType>> minValues;
+  std::vector<char> found;
+
+public:
+  MinScan(ComplexQuery &query, std::vector<Table::FieldIndex> fids,
+          Table::SizeType blockCount)
+      : query(query), fids(std::move(fids)), minValues(blockCount),
+        found(blockCount, 0) {}
+
+  void scanBlock(const Table &table, Table::SizeType block) override {
+    auto &local_min = minValues[block];
+    local_min.assign(fids.size(), Table::ValueTypeMax);
+    forEachMatch(query, table, block, [&](const Datum &row) {
+      found[block] = 1;
+      for (size_t i = 0; i < fids.size(); ++i) [[likely]]
+      {
+        local_min[i] = std::min(local_min[i], row.datumConstRef()[fids[i]]);
+      }
+    });
+  }
+
+  QueryResult::Ptr finish() override {
+    bool any_found = false;
+    std::vector<Table::ValueType> minValue(fids.size(), Table::ValueTypeMax);
+    for (size_t block = 0; block < minValues.size(); ++block) [[likely]]
+    {
+      if (found[block] == 0) [[unlikely]] {
+        continue;
+      }
+      any_found = true;
+      for (size_t i = 0; i < fids.size(); ++i) [[likely]]
+      {
+        minValue[i] = std::min(minValue[i], minValues[block][i]);
+      }
+    }
+    if (!any_found) [[unlikely]] {
+      return std::make_unique<NullQueryResult>();
+    }
+    return std::make_unique<SuccessMsgResult>(minValue);
+  }
+};
+/**
+ * MIN kept up to date: the minima of the matching rows, with the number of
+ * rows holding each. Taking out the last row holding one needs a rebuild.
+ */
+class MinView : public ScanQuery::View {
+  std::vector<Table::FieldIndex> fids;
+  std::vector<Table::ValueType> extremes;
+  std::vector<Table::SizeType> holders;
+  Table::SizeType matched = 0;
+
+public:
+  MinView(std::vector<QueryCondition> conditions,
+          std::vector<Table::FieldIndex> fids)
+      : View(std::move(conditions)), fids(std::move(fids)),
+        extremes(this->fids.size(), Table::ValueTypeMax),
+        holders(this->fids.size(), 0) {}
+
+  void reset() override {
+    std::ranges::fill(extremes, Table::ValueTypeMax);
+    std::ranges::fill(holders, 0);
+    matched = 0;
+  }
+
+  void apply(const Datum &row) override {
+    if (!matches(row)) [[likely]] {
+      return;
+    }
+    ++matched;
+    for (size_t i = 0; i < fids.size(); ++i) [[likely]] {
+      const Table::ValueType value = row.datumConstRef()[fids[i]];
+      if (value < extremes[i] || holders[i] == 0) [[unlikely]] {
+        extremes[i] = value;
+        holders[i] = 1;
+      } else if (value == extremes[i]) [[unlikely]] {
+        ++holders[i];
+      }
+    }
+  }
+
+  bool retract(const Datum &row) override {
+    if (!matches(row)) [[likely]] {
+      return true;
+    }
+    --matched;
+    bool current = true;
+    for (size_t i = 0; i < fids.size(); ++i) [[likely]] {
+      if (row.datumConstRef()[fids[i]] == extremes[i] && --holders[i] == 0)
+          [[unlikely]] {
+        current = false;
+      }
+    }
+    return current;
+  }
+
+  [[nodiscard]] QueryResult::Ptr result() const override {
+    if (matched == 0) [[unlikely]] {
+      return std::make_unique<NullQueryResult>();
+    }
+    return std::make_unique<SuccessMsgResult>(extremes);
+  }
+};
+}  // namespace
+
+QueryResult::Ptr MinQuery::executeScan() {
   try {
     if (validateOperands() != nullptr) [[unlikely]] {
       return validateOperands();
     }
 
-    Database &database = Database::getInstance();
-    auto lock =
-        TableLockManager::getInstance().acquireRead(this->targetTableRef());
-    auto &table = database[this->targetTableRef()];
+    TableLockManager::ReadLock lock;
+    const Table &table = readTable(lock);
 
     auto result = initCondition(table);
 
@@ -68,6 +175,26 @@ QueryResult::Ptr MinQuery::execute() {
   }
 }
 
+std::unique_ptr<ScanQuery::Scan> MinQuery::openScan(const Table &table) {
+  if (validateOperands() != nullptr || !initCondition(table).second)
+      [[unlikely]] {
+    return nullptr;
+  }
+  return std::make_unique<MinScan>(*this, getFieldIndices(table),
+                                   table.blockCount());
+}
+
+std::unique_ptr<ScanQuery::View> MinQuery::openView(const Table &table) {
+  if (validateOperands() != nullptr) [[unlikely]] {
+    return nullptr;
+  }
+  const auto resolved = initCondition(table);
+  if (!resolved.second || !resolved.first.empty()) [[unlikely]] {
+    return nullptr;
+  }
+  return std::make_unique<MinView>(getCondition(), getFieldIndices(table));
+}
+
 std::string MinQuery::toString() {
   return "QUERY = MIN " + this->targetTableRef();
 }
@@ -84,13 +211,13 @@ std::string MinQuery::toString() {
 [[nodiscard]] std::vector<Table::FieldIndex>
 MinQuery::getFieldIndices(const Table &table) const {
   std::vector<Table::FieldIndex> fieldId;
-  for (const auto &operand : this->getOperands()) [[likely]]
-  {
-    if (operand == "KEY") [[unlikely]] {
+  const auto &operands = this->getOperands();
+  for (size_t index = 0; index < operands.size(); ++index) [[likely]] {
+    if (operands[index] == "KEY") [[unlikely]] {
       throw IllFormedQueryCondition(
           "MIN operation not supported on KEY field.");
     }
-    fieldId.push_back(table.getFieldIndex(operand));
+    fieldId.push_back(operandFieldIndex(table, index));
   }
   return fieldId;
 }
@@ -1,6 +1,7 @@
 #ifndef PROJECT_MINQUERY_H
 #define PROJECT_MINQUERY_H
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -8,7 +9,7 @@
 #include "../Query.h"
 #include "../QueryResult.h"
 
-class MinQuery : public ComplexQuery {
+class MinQuery : public ScanQuery {
   static constexpr const char *qname = "MIN";
 
 private:
@@ -47,11 +48,14 @@ private:
                        const std::vector<Table::FieldIndex> &fids);
 
 public:
-  using ComplexQuery::ComplexQuery;
-
-  QueryResult::Ptr execute() override;
+  using ScanQuery::ScanQuery;
 
   std::string toString() override;
+
+protected:
+  QueryResult::Ptr executeScan() override;
+  std::unique_ptr<Scan> openScan(const Table &table) override;
+  std::unique_ptr<View> openView(const Table &table) override;
 };
 
 #endif  // PROJECT_MINQUERY_H
@@ -7,30 +7,83 @@
 #include <iterator>
 #include <map>
 #include <memory>
-#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
 
-#include "../../db/Database.h"
 #include "../../db/Table.h"
 #include "../../db/TableLockManager.h"
 #include "../../threading/Threadpool.h"
+#include "../../utils/QueryProfile.h"
+#include "../../utils/ResultBuffer.h"
 #include "../../utils/formatter.h"
 #include "../../utils/uexception.h"
 #include "../QueryResult.h"
 
-QueryResult::Ptr SelectQuery::execute() {
+namespace {
+/** SELECT's part in a shared scan: the matching rows of each block */
+class SelectScan : public ScanQuery::Scan {
+  using Row = std::pair<std::string, std::vector<Table::ValueType>>;
+
+  ComplexQuery &query;
+  std::vector<Table::FieldIndex> fieldIds;
+  std::vector<std::vector<Row>> rows;
+
+public:
+  SelectScan(ComplexQuery &query, std::vector<Table::FieldIndex> fieldIds,
+             Table::SizeType blockCount)
+      : query(query), fieldIds(std::move(fieldIds)), rows(blockCount) {}
+
+  void scanBlock(const Table &table, Table::SizeType block) override {
+    auto &local_rows = rows[block];
+    forEachMatch(query, table, block, [&](const Datum &row) {
+      std::vector<Table::ValueType> values;
+      values.reserve(fieldIds.size());
+      std::transform(fieldIds.begin(), fieldIds.end(),
+                     std::back_inserter(values),
+                     [&row](const auto &field_id) {
+                       return row.datumConstRef()[field_id];
+                     });
+      local_rows.emplace_back(row.keyConstRef(), std::move(values));
+    });
+  }
+
+  QueryResult::Ptr finish() override {
+    // Keys are unique, so sorting by key alone orders the rows
+    std::vector<Row> sorted_rows;
+    for (auto &local_rows : rows) [[likely]] {
+      std::move(local_rows.begin(), local_rows.end(),
+                std::back_inserter(sorted_rows));
+    }
+    std::sort(sorted_rows.begin(), sorted_rows.end(),
+              [](const Row &lhs, const Row &rhs) {
+                return lhs.first < rhs.first;
+              });
+
+    const QueryProfile::StageTimer timer(QueryProfile::Stage::Format);
+    auto buffer = ResultBuffer::acquire();
+    for (const auto &[key, values] : sorted_rows) [[likely]] {
+      *buffer << "( " << key;
+      for (const auto &value : values) [[likely]]
+      {
+        *buffer << " " << value;
+      }
+      *buffer << " )\n";
+    }
+    return std::make_unique<TextRowsResult>(std::move(buffer));
+  }
+};
+}  // namespace
+
+QueryResult::Ptr SelectQuery::executeScan() {
   try {
     auto validation_result = validateOperands();
     if (validation_result != nullptr) [[unlikely]] {
       return validation_result;
     }
 
-    auto &database = Database::getInstance();
-    auto lock =
-        TableLockManager::getInstance().acquireRead(this->targetTableRef());
-    auto &table = database[this->targetTableRef()];
+    TableLockManager::ReadLock lock;
+    const Table &table = readTable(lock);
 
     auto fieldIds = getFieldIndices(table);
     auto result = initCondition(table);
@@ -40,23 +93,23 @@ QueryResult::Ptr SelectQuery::execute() {
     }
 
     // Try KEY condition optimization first
-    std::ostringstream key_buffer;
+    auto key_buffer = ResultBuffer::acquire();
     const bool handled = this->testKeyCondition(
-        table, [&](bool success, Table::Object::Ptr obj) {
+        table, [&](bool success, Table::ConstObject::Ptr obj) {
           if (!success) [[unlikely]] {
             return;
           }
           if (obj) [[likely]] {
-            key_buffer << "( " << obj->key();
+            *key_buffer << "( " << obj->key();
             for (const auto &field_id : fieldIds) {
-              key_buffer << " " << (*obj)[field_id];
+              *key_buffer << " " << (*obj)[field_id];
             }
-            key_buffer << " )\n";
+            *key_buffer << " )\n";
           }
         });
 
     if (handled) [[unlikely]] {
-      return std::make_unique<TextRowsResult>(key_buffer.str());
+      return std::make_unique<TextRowsResult>(std::move(key_buffer));
     }
 
     // Use ThreadPool if available
@@ -83,6 +136,21 @@ QueryResult::Ptr SelectQuery::execute() {
   }
 }
 
+std::unique_ptr<ScanQuery::Scan>
+SelectQuery::openScan(const Table &table) {
+  if (validateOperands() != nullptr) [[unlikely]] {
+    return nullptr;
+  }
+  auto fieldIds = getFieldIndices(table);
+  // A KEY condition is looked up, not scanned
+  const auto result = initCondition(table);
+  if (!result.second || !result.first.empty()) [[unlikely]] {
+    return nullptr;
+  }
+  return std::make_unique<SelectScan>(*this, std::move(fieldIds),
+                                      table.blockCount());
+}
+
 std::string SelectQuery::toString() {
   return "QUERY = SELECT \"" + this->targetTableRef() + "\"";
 }
@@ -97,19 +165,15 @@ std::string SelectQuery::toString() {
 
 [[nodiscard]] std::vector<Table::FieldIndex>
 SelectQuery::getFieldIndices(const Table &table) const {
-  std::vector<std::string> fieldsOrder;
-  fieldsOrder.reserve(this->getOperands().size() + 1);
-  fieldsOrder.emplace_back("KEY");
+  // KEY is always printed first, so it is skipped among the operands
   const auto &operands = this->getOperands();
-  std::copy_if(operands.begin(), operands.end(),
-               std::back_inserter(fieldsOrder),
-               [](const auto &field) { return field != "KEY"; });
-
   std::vector<Table::FieldIndex> fieldIds;
-  fieldIds.reserve(fieldsOrder.size() - 1);
-  std::transform(
-      fieldsOrder.begin() + 1, fieldsOrder.end(), std::back_inserter(fieldIds),
-      [&table](const auto &field) { return table.getFieldIndex(field); });
+  fieldIds.reserve(operands.size());
+  for (size_t index = 0; index < operands.size(); ++index) [[likely]] {
+    if (operands[index] != "KEY") [[likely]] {
+      fieldIds.push_back(operandFieldIndex(table, index));
+    }
+  }
   return fieldIds;
 }
 
@@ -131,19 +195,20 @@ SelectQuery::getFieldIndices(const Table &table) const {
   }
 
   // Output in KEY order (already sorted by map)
-  std::ostringstream buffer;
+  const QueryProfile::StageTimer timer(QueryProfile::Stage::Format);
+  auto buffer = ResultBuffer::acquire();
 
   // cppcheck-suppress unassignedVariable
   for (const auto &[key, values] : sorted_rows) [[likely]] {
-    buffer << "( " << key;
+    *buffer << "( " << key;
     for (const auto &value : values) [[likely]]
     {
-      buffer << " " << value;
+      *buffer << " " << value;
     }
-    buffer << " )\n";
+    *buffer << " )\n";
   }
 
-  return std::make_unique<TextRowsResult>(buffer.str());
+  return std::make_unique<TextRowsResult>(std::move(buffer));
 }
 
 [[nodiscard]] QueryResult::Ptr SelectQuery::executeMultiThreaded(
@@ -190,15 +255,16 @@ SelectQuery::getFieldIndices(const Table &table) const {
   }
 
   // Output in KEY order (already sorted by map)
-  std::ostringstream buffer;
+  const QueryProfile::StageTimer timer(QueryProfile::Stage::Format);
+  auto buffer = ResultBuffer::acquire();
   for (const auto &[key, values] : sorted_rows) [[likely]] {
-    buffer << "( " << key;
+    *buffer << "( " << key;
     for (const auto &value : values) [[likely]]
     {
-      buffer << " " << value;
+      *buffer << " " << value;
     }
-    buffer << " )\n";
+    *buffer << " )\n";
   }
 
-  return std::make_unique<TextRowsResult>(buffer.str());
+  return std::make_unique<TextRowsResult>(std::move(buffer));
 }
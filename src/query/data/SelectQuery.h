@@ -1,6 +1,7 @@
 #ifndef PROJECT_SELECT_QUERY_H
 #define PROJECT_SELECT_QUERY_H
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -8,7 +9,7 @@
 #include "../Query.h"
 #include "../QueryResult.h"
 
-class SelectQuery : public ComplexQuery {
+class SelectQuery : public ScanQuery {
   static constexpr const char *qname = "SELECT";
 
 private:
@@ -47,9 +48,13 @@ private:
                        const std::vector<Table::FieldIndex> &fieldIds);
 
 public:
-  using ComplexQuery::ComplexQuery;
-  QueryResult::Ptr execute() override;
+  using ScanQuery::ScanQuery;
   std::string toString() override;
+  [[nodiscard]] bool looksUpKeys() const override { return true; }
+
+protected:
+  QueryResult::Ptr executeScan() override;
+  std::unique_ptr<Scan> openScan(const Table &table) override;
 };
 
 #endif  // PROJECT_SELECT_QUERY_H
@@ -83,9 +83,9 @@ SubQuery::getFieldIndices(const Table &table) const {
   std::vector<Table::FieldIndex> indices;
   indices.reserve(this->getOperands().size());
   const auto &operands = this->getOperands();
-  std::transform(
-      operands.begin(), operands.end(), std::back_inserter(indices),
-      [&table](const auto &operand) { return table.getFieldIndex(operand); });
+  for (size_t index = 0; index < operands.size(); ++index) [[likely]] {
+    indices.push_back(operandFieldIndex(table, index));
+  }
   return indices;
 }
 
@@ -105,6 +105,7 @@ SubQuery::getFieldIndices(const Table &table) const {
     {
       diff -= row[fids[idx]];
     }
+    table.markDirty(row);
     row[fids.back()] = diff;
     count++;
   }
@@ -130,7 +131,7 @@ SubQuery::getFieldIndices(const Table &table) const {
     auto chunk_end = iterator;
     futures.push_back(
         // NOLINTNEXTLINE(bugprone-exception-escape)
-        pool.submit([this, chunk_start, chunk_end, fids]() {
+        pool.submit([this, &table, chunk_start, chunk_end, fids]() {
           int local_count = 0;
           for (auto it = chunk_start; it != chunk_end; ++it) [[likely]]
           {
@@ -144,6 +145,7 @@ SubQuery::getFieldIndices(const Table &table) const {
             {
               diff -= (*it)[fids[i]];
             }
+            table.markDirty(*it);
             (*it)[fids.back()] = diff;
             local_count++;
           }
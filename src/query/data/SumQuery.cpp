@@ -2,14 +2,15 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <future>
 #include <iterator>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
-#include "../../db/Database.h"
 #include "../../db/Table.h"
 #include "../../db/TableLockManager.h"
 #include "../../threading/Threadpool.h"
@@ -17,9 +18,85 @@
 #include "../../utils/uexception.h"
 #include "../QueryResult.h"
 
-[[nodiscard]] QueryResult::Ptr SumQuery::execute() {
-  Database &database = Database::getInstance();
+namespace {
+/** SUM's part in a shared scan: the sums of each block */
+class SumScan : public ScanQuery::Scan {
+  ComplexQuery &query;
+  std::vector<Table::FieldIndex> fids;
+  std::vector<std::vector<Table::ValueType>> sums;
+
+public:
+  SumScan(ComplexQuery &query, std::vector<Table::FieldIndex> fids,
+          Table::SizeType blockCount)
+      : query(query), fids(std::move(fids)), sums(blockCount) {}
+
+  void scanBlock(const Table &table, Table::SizeType block) override {
+    auto &local_sums = sums[block];
+    local_sums.assign(fids.size(), 0);
+    forEachMatch(query, table, block, [&](const Datum &row) {
+      for (size_t i = 0; i < fids.size(); ++i) [[likely]]
+      {
+        local_sums[i] += row.datumConstRef()[fids[i]];
+      }
+    });
+  }
+
+  QueryResult::Ptr finish() override {
+    std::vector<Table::ValueType> total(fids.size(), 0);
+    for (const auto &local_sums : sums) [[likely]]
+    {
+      for (size_t i = 0; i < local_sums.size(); ++i) [[likely]]
+      {
+        total[i] += local_sums[i];
+      }
+    }
+    return std::make_unique<SuccessMsgResult>(total);
+  }
+};
+
+/** SUM kept up to date: the sums of the matching rows */
+class SumView : public ScanQuery::View {
+  std::vector<Table::FieldIndex> fids;
+  /** Wider than the values, so taking a row out undoes adding it */
+  std::vector<int64_t> sums;
+
+public:
+  SumView(std::vector<QueryCondition> conditions,
+          std::vector<Table::FieldIndex> fids)
+      : View(std::move(conditions)), fids(std::move(fids)),
+        sums(this->fids.size(), 0) {}
+
+  void reset() override { std::ranges::fill(sums, 0); }
+
+  void apply(const Datum &row) override {
+    if (matches(row)) [[likely]] {
+      for (size_t i = 0; i < fids.size(); ++i) [[likely]] {
+        sums[i] += row.datumConstRef()[fids[i]];
+      }
+    }
+  }
+
+  bool retract(const Datum &row) override {
+    if (matches(row)) [[likely]] {
+      for (size_t i = 0; i < fids.size(); ++i) [[likely]] {
+        sums[i] -= row.datumConstRef()[fids[i]];
+      }
+    }
+    return true;
+  }
+
+  [[nodiscard]] QueryResult::Ptr result() const override {
+    // Wraps around as the sums of a scan do
+    std::vector<Table::ValueType> total(sums.size());
+    std::ranges::transform(sums, total.begin(), [](int64_t sum) {
+      return static_cast<Table::ValueType>(sum);
+    });
+    return std::make_unique<SuccessMsgResult>(total);
+  }
+};
+}  // namespace
 
+[[nodiscard]] QueryResult::Ptr SumQuery::executeScan() {
   try {
     // Validate operands
     auto validation_result = validateOperands();
@@ -27,9 +104,8 @@
       return validation_result;
     }
 
-    auto lock =
-        TableLockManager::getInstance().acquireRead(this->targetTableRef());
-    auto &table = database[this->targetTableRef()];
+    TableLockManager::ReadLock lock;
+    const Table &table = readTable(lock);
 
     auto result = initCondition(table);
     if (!result.second) [[unlikely]] {
@@ -69,6 +145,26 @@
   }
 }
 
+std::unique_ptr<ScanQuery::Scan> SumQuery::openScan(const Table &table) {
+  if (validateOperands() != nullptr || !initCondition(table).second)
+      [[unlikely]] {
+    return nullptr;
+  }
+  return std::make_unique<SumScan>(*this, getFieldIndices(table),
+                                   table.blockCount());
+}
+
+std::unique_ptr<ScanQuery::View> SumQuery::openView(const Table &table) {
+  if (validateOperands() != nullptr) [[unlikely]] {
+    return nullptr;
+  }
+  const auto resolved = initCondition(table);
+  if (!resolved.second || !resolved.first.empty()) [[unlikely]] {
+    return nullptr;
+  }
+  return std::make_unique<SumView>(getCondition(), getFieldIndices(table));
+}
+
 [[nodiscard]] std::string SumQuery::toString() {
   return "QUERY = SUM \"" + this->targetTableRef() + "\"";
 }
@@ -93,15 +189,14 @@ SumQuery::getFieldIndices(const Table &table) const {
   std::vector<Table::FieldIndex> fids;
   fids.reserve(this->getOperands().size());
   const auto &operands = this->getOperands();
-  std::transform(
-      operands.begin(), operands.end(), std::back_inserter(fids),
-      [&table](const auto &field) { return table.getFieldIndex(field); });
+  for (size_t index = 0; index < operands.size(); ++index) [[likely]] {
+    fids.push_back(operandFieldIndex(table, index));
+  }
   return fids;
 }
 
 [[nodiscard]] QueryResult::Ptr SumQuery::executeSingleThreaded(
-    Table &table,  // cppcheck-suppress constParameter
-    const std::vector<Table::FieldIndex> &fids) {
+    const Table &table, const std::vector<Table::FieldIndex> &fids) {
   const size_t num_fields = fids.size();
   std::vector<Table::ValueType> sums(num_fields, 0);
 
@@ -118,8 +213,7 @@ SumQuery::getFieldIndices(const Table &table) const {
 }
 
 [[nodiscard]] QueryResult::Ptr SumQuery::executeMultiThreaded(
-    Table &table,  // cppcheck-suppress constParameter
-    const std::vector<Table::FieldIndex> &fids) {
+    const Table &table, const std::vector<Table::FieldIndex> &fids) {
   constexpr size_t CHUNK_SIZE = Table::splitsize();
   const ThreadPool &pool = ThreadPool::getInstance();
   const size_t num_fields = fids.size();
@@ -1,6 +1,7 @@
 #ifndef PROJECT_SUMQUERY_H
 #define PROJECT_SUMQUERY_H
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -8,7 +9,7 @@
 #include "../Query.h"
 #include "../QueryResult.h"
 
-class SumQuery : public ComplexQuery {
+class SumQuery : public ScanQuery {
   static constexpr const char *qname = "SUM";
 
 private:
@@ -34,7 +35,7 @@ private:
    * @return QueryResult with sum results
    */
   [[nodiscard]] QueryResult::Ptr
-  executeSingleThreaded(Table &table,
+  executeSingleThreaded(const Table &table,
                         const std::vector<Table::FieldIndex> &fids);
 
   /**
@@ -44,12 +45,16 @@ private:
    * @return QueryResult with sum results
    */
   [[nodiscard]] QueryResult::Ptr
-  executeMultiThreaded(Table &table,
+  executeMultiThreaded(const Table &table,
                        const std::vector<Table::FieldIndex> &fids);
 
 public:
-  using ComplexQuery::ComplexQuery;
-  QueryResult::Ptr execute() override;
+  using ScanQuery::ScanQuery;
   std::string toString() override;
+
+protected:
+  QueryResult::Ptr executeScan() override;
+  std::unique_ptr<Scan> openScan(const Table &table) override;
+  std::unique_ptr<View> openView(const Table &table) override;
 };
 #endif  // PROJECT_SUMQUERY_H
@@ -46,6 +46,7 @@ QueryResult::Ptr SwapQuery::execute() {
             return;
           }
           if (obj) [[likely]] {
+            table.markDirty(*obj);
             auto tmp = (*obj)[field_index_1];
             (*obj)[field_index_1] = (*obj)[field_index_2];
             (*obj)[field_index_2] = tmp;
@@ -103,8 +104,7 @@ SwapQuery::getFieldIndices(const Table &table) const {
         qname, this->targetTableRef(),
         "Ill-formed query: KEY cannot be swapped.");
   }
-  return {table.getFieldIndex(getOperands()[0]),
-          table.getFieldIndex(getOperands()[1])};
+  return {operandFieldIndex(table, 0), operandFieldIndex(table, 1)};
 }
 
 // cppcheck-suppress constParameter
@@ -117,6 +117,7 @@ SwapQuery::executeSingleThreaded(Table &table,
   for (auto row : table) [[likely]]
   {
     if (this->evalCondition(row)) [[likely]] {
+      table.markDirty(row);
       auto tmp = row[field_index_1];
       row[field_index_1] = row[field_index_2];
       row[field_index_2] = tmp;
@@ -147,11 +148,12 @@ SwapQuery::executeMultiThreaded(Table &table,
     auto chunk_end = iterator;
 
     futures.push_back(pool.submit(
-        [this, chunk_begin, chunk_end, field_index_1, field_index_2]() {
+        [this, &table, chunk_begin, chunk_end, field_index_1, field_index_2]() {
           Table::SizeType local_counter = 0;
           for (auto it = chunk_begin; it != chunk_end; ++it) [[likely]]
           {
             if (this->evalCondition(*it)) [[likely]] {
+              table.markDirty(*it);
               auto tmp = (*it)[field_index_1];
               (*it)[field_index_1] = (*it)[field_index_2];
               (*it)[field_index_2] = tmp;
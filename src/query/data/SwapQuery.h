@@ -52,6 +52,7 @@ public:
   QueryResult::Ptr execute() override;
   std::string toString() override;
   [[nodiscard]] bool isWriter() const override { return true; }
+  [[nodiscard]] bool looksUpKeys() const override { return true; }
 };
 
 #endif  // PROJECT_SWAPQUERY_H
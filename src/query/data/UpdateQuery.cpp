@@ -35,7 +35,7 @@ QueryResult::Ptr UpdateQuery::execute() {
       this->keyValue = this->getOperands()[1];
     } else [[likely]] {
       constexpr int decimal_base = 10;
-      this->fieldId = table.getFieldIndex(this->getOperands()[0]);
+      this->fieldId = operandFieldIndex(table, 0);
       this->fieldValue = static_cast<Table::ValueType>(
           strtol(this->getOperands()[1].c_str(), nullptr, decimal_base));
     }
@@ -92,6 +92,7 @@ UpdateQuery::executeSingleThreaded(Table &table) {
   {
     if (this->evalCondition(*it)) [[likely]] {
       if (this->keyValue.empty()) [[likely]] {
+        table.markDirty(*it);
         (*it)[this->fieldId] = this->fieldValue;
       } else [[unlikely]] {
         it->setKey(this->keyValue);
@@ -118,12 +119,13 @@ UpdateQuery::executeSingleThreaded(Table &table) {
     }
     auto chunk_end = iterator;
 
-    futures.push_back(pool.submit([this, chunk_start, chunk_end]() {
+    futures.push_back(pool.submit([this, &table, chunk_start, chunk_end]() {
       Table::SizeType local_count = 0;
       for (auto it = chunk_start; it != chunk_end; ++it) [[likely]]
       {
         if (this->evalCondition(*it)) [[likely]] {
           if (this->keyValue.empty()) [[likely]] {
+            table.markDirty(*it);
             (*it)[this->fieldId] = this->fieldValue;
           } else [[unlikely]] {
             it->setKey(this->keyValue);
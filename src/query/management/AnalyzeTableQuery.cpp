@@ -0,0 +1,33 @@
+#include "AnalyzeTableQuery.h"
+
+#include <exception>
+#include <memory>
+#include <string>
+
+#include "../../db/Database.h"
+#include "../../db/TableLockManager.h"
+#include "../../utils/uexception.h"
+#include "../QueryResult.h"
+
+constexpr const char *qname_an = "ANALYZE";
+
+QueryResult::Ptr AnalyzeTableQuery::execute() {
+  try {
+    // Only reads the rows; the statistics have a lock of their own
+    const auto lock =
+        TableLockManager::getInstance().acquireRead(this->targetTableRef());
+    Database::getInstance()[this->targetTableRef()].analyze();
+
+    return std::make_unique<NullQueryResult>();  // silent success
+  } catch (const TableNameNotFound &) {
+    return std::make_unique<ErrorMsgResult>(qname_an, this->targetTableRef(),
+                                            "No such table.");
+  } catch (const std::exception &exc) {
+    return std::make_unique<ErrorMsgResult>(qname_an, this->targetTableRef(),
+                                            "Unknown error");
+  }
+}
+
+std::string AnalyzeTableQuery::toString() {
+  return "QUERY = ANALYZE \"" + this->targetTableRef() + "\"";
+}
@@ -0,0 +1,27 @@
+#ifndef PROJECT_ANALYZETABLEQUERY_H
+#define PROJECT_ANALYZETABLEQUERY_H
+
+#include <string>
+
+#include "../../db/QueryBase.h"
+#include "../QueryResult.h"
+
+class AnalyzeTableQuery : public Query {
+public:
+  using Query::Query;
+
+  /**
+   * Execute the ANALYZE query to gather the statistics of the table, which
+   * later queries plan their scans with (see TableStatistics)
+   * @return QueryResult with analyze operation results
+   */
+  QueryResult::Ptr execute() override;
+
+  /**
+   * Convert query to string representation
+   * @return String representation of the ANALYZE query
+   */
+  std::string toString() override;
+};
+
+#endif  // PROJECT_ANALYZETABLEQUERY_H
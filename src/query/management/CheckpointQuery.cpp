@@ -0,0 +1,22 @@
+#include "CheckpointQuery.h"
+
+#include <memory>
+#include <string>
+
+#include "../../db/Checkpointer.h"
+#include "../QueryResult.h"
+
+QueryResult::Ptr CheckpointQuery::execute() {
+  auto &checkpointer = Checkpointer::getInstance();
+  if (!checkpointer.isEnabled()) [[unlikely]] {
+    return std::make_unique<ErrorMsgResult>(
+        qname, "Checkpoints are disabled (see --checkpoint).");
+  }
+  if (!checkpointer.checkpoint().has_value()) [[unlikely]] {
+    return std::make_unique<ErrorMsgResult>(qname,
+                                            "Cannot write the checkpoint.");
+  }
+  return std::make_unique<SuccessMsgResult>(qname);
+}
+
+std::string CheckpointQuery::toString() { return "QUERY = CHECKPOINT"; }
@@ -0,0 +1,33 @@
+#ifndef PROJECT_CHECKPOINTQUERY_H
+#define PROJECT_CHECKPOINTQUERY_H
+
+#include <string>
+
+#include "../../db/QueryBase.h"
+#include "../QueryResult.h"
+
+/**
+ * CHECKPOINT: write the rows changed since the last checkpoint to the
+ * checkpoint file and truncate the write-ahead log (see Checkpointer). It is
+ * a barrier, so it covers exactly the queries before it.
+ */
+class CheckpointQuery : public Query {
+  static constexpr const char *qname = "CHECKPOINT";
+
+public:
+  /**
+   * Execute the CHECKPOINT query
+   * @return QueryResult with the checkpoint status
+   */
+  QueryResult::Ptr execute() override;
+
+  /**
+   * Convert query to string representation
+   * @return String representation of the CHECKPOINT query
+   */
+  std::string toString() override;
+
+  [[nodiscard]] bool isBarrier() const override { return true; }
+};
+
+#endif  // PROJECT_CHECKPOINTQUERY_H
@@ -5,7 +5,6 @@
 #include <semaphore>
 #include <string>
 #include <utility>
-#include <vector>
 
 #include "../../db/QueryBase.h"
 #include "../../db/Table.h"
@@ -14,13 +13,10 @@
 class CopyTableQuery : public Query {
   static constexpr const char *qname = "COPYTABLE";
   std::string newTableName;
-  constexpr static bool is_multithreaded = true;
   std::shared_ptr<std::counting_semaphore<>> wait_sem;
+  bool release_on_destroy = false;
 
 private:
-  // Helper methods to reduce complexity
-  using RowData = std::pair<std::string, std::vector<Table::ValueType>>;
-
   /**
    * Validate that the source table exists and is accessible
    * @param src The source table to validate
@@ -28,24 +24,6 @@ private:
    */
   [[nodiscard]] QueryResult::Ptr validateSourceTable(const Table &src) const;
 
-  /**
-   * Collect row data from source table using single-threaded approach
-   * @param src The source table to collect from
-   * @param fields The fields to collect
-   * @return Vector of row data pairs
-   */
-  [[nodiscard]] std::vector<RowData> static collectSingleThreaded(
-      const Table &src, const std::vector<std::string> &fields);
-
-  /**
-   * Collect row data from source table using multi-threaded approach
-   * @param src The source table to collect from
-   * @param fields The fields to collect
-   * @return Vector of row data pairs
-   */
-  [[nodiscard]] std::vector<RowData> static collectMultiThreaded(
-      const Table &src, const std::vector<std::string> &fields);
-
 public:
   /**
    * Constructor for COPYTABLE query
@@ -56,6 +34,17 @@ public:
       : Query(std::move(sourceTable)), newTableName(std::move(newTable)),
         wait_sem(std::make_shared<std::counting_semaphore<>>(0)) {}
 
+  CopyTableQuery(const CopyTableQuery &) = delete;
+  CopyTableQuery &operator=(const CopyTableQuery &) = delete;
+  CopyTableQuery(CopyTableQuery &&) = delete;
+  CopyTableQuery &operator=(CopyTableQuery &&) = delete;
+
+  ~CopyTableQuery() override {
+    if (release_on_destroy) {
+      wait_sem->release();
+    }
+  }
+
   /**
    * Execute the COPYTABLE query to duplicate a table
    * @return QueryResult with copy operation results
@@ -68,6 +57,12 @@ public:
    */
   std::string toString() override;
 
+  /**
+   * COPYTABLE creates a table
+   * @return Always true
+   */
+  [[nodiscard]] bool isWriter() const override { return true; }
+
   /**
    * Get the wait semaphore for synchronization with dependent queries
    * @return Shared pointer to the counting semaphore
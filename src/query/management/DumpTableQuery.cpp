@@ -10,7 +10,9 @@
 #include <string>
 
 #include "../../db/Database.h"
+#include "../../db/TableCodec.h"
 #include "../../db/TableLockManager.h"
+#include "../../utils/Tracer.h"
 #include "../../utils/formatter.h"
 #include "../QueryResult.h"
 
@@ -19,12 +21,19 @@ QueryResult::Ptr DumpTableQuery::execute() {
   try {
     const auto lock =
         TableLockManager::getInstance().acquireRead(this->targetTableRef());
-    std::ofstream outfile(this->fileName);
+    const Tracer::Span span("Write file", this->fileName);
+    std::ofstream outfile(this->fileName, this->compressed
+                                              ? std::ios::out | std::ios::binary
+                                              : std::ios::out);
     if (!outfile.is_open()) [[unlikely]] {
       return std::make_unique<ErrorMsgResult>(qname, "Cannot open file '?'"_f %
                                                          this->fileName);
     }
-    outfile << database[this->targetTableRef()];
+    if (this->compressed) {
+      TableCodec::encode(database[this->targetTableRef()], outfile);
+    } else {
+      outfile << database[this->targetTableRef()];
+    }
     outfile.close();
     return std::make_unique<SuccessMsgResult>(qname, this->targetTableRef());
   } catch (const std::exception &exc) {
@@ -33,5 +42,6 @@ QueryResult::Ptr DumpTableQuery::execute() {
 }
 
 std::string DumpTableQuery::toString() {
-  return "QUERY = Dump TABLE, FILE = \"" + this->fileName + "\"";
+  return "QUERY = Dump TABLE, FILE = \"" + this->fileName + "\"" +
+         (this->compressed ? ", COMPRESSED" : "");
 }
@@ -14,15 +14,19 @@
 class DumpTableQuery : public Query {
   static constexpr const char *qname = "DUMP";
   std::string fileName;
+  bool compressed;
 
 public:
   /**
    * Constructor for DUMP table query
    * @param table Name of the table to dump
    * @param filename File path to save data to
+   * @param compressed Write the binary LTC format instead of plain text
    */
-  DumpTableQuery(std::string table, std::string filename)
-      : Query(std::move(table)), fileName(std::move(filename)) {}
+  DumpTableQuery(std::string table, std::string filename,
+                 bool compressed = false)
+      : Query(std::move(table)), fileName(std::move(filename)),
+        compressed(compressed) {}
 
   /**
    * Execute the DUMP query to save table data to file
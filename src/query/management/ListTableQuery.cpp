@@ -5,14 +5,16 @@
 #include "ListTableQuery.h"
 
 #include <memory>
+#include <sstream>
 #include <string>
 
 #include "../../db/Database.h"
 #include "../QueryResult.h"
 
 QueryResult::Ptr ListTableQuery::execute() {
-  Database::getInstance().printAllTable();
-  return std::make_unique<SuccessMsgResult>(qname);
+  std::ostringstream out;
+  Database::getInstance().printAllTable(out);
+  return std::make_unique<TextRowsResult>(out.view());
 }
 
 std::string ListTableQuery::toString() { return "QUERY = LIST"; }
@@ -7,25 +7,58 @@
 #include <exception>
 #include <fstream>
 #include <memory>
+#include <sstream>
 #include <string>
+#include <utility>
 
 #include "../../db/Database.h"
+#include "../../db/LoadPrefetcher.h"
+#include "../../db/Table.h"
+#include "../../db/TableCodec.h"
 #include "../../db/TableLockManager.h"
+#include "../../utils/Tracer.h"
 #include "../../utils/formatter.h"
 #include "../QueryResult.h"
 
+namespace {
+/**
+ * Have the write-ahead log keep the rows a LOAD read instead of its
+ * statement, which replay would run against whatever the file holds by then
+ */
+void logRows(LoadTableQuery &query, const Table &table) {
+  if (query.statementRef().empty()) [[likely]] {
+    return;  // Not logged
+  }
+  std::ostringstream rows(std::ios::out | std::ios::binary);
+  TableCodec::encode(table, rows);
+  query.setStatement(std::move(rows).str());
+}
+}  // namespace
+
 QueryResult::Ptr LoadTableQuery::execute() {
   try {
     // LOAD creates a new table, so we acquire write lock for the new table name
     const auto lock =
         TableLockManager::getInstance().acquireWrite(this->targetTableRef());
-    std::ifstream infile(this->fileName);
+
+    // Register the table read ahead by the prefetcher, if it is usable
+    if (auto staged = LoadPrefetcher::getInstance().take(this->fileName))
+        [[likely]] {
+      logRows(*this, Database::getInstance().registerTable(std::move(staged)));
+      return std::make_unique<SuccessMsgResult>(qname, this->targetTableRef());
+    }
+    const Tracer::Span span("Read file", this->fileName);
+    std::ifstream infile(this->fileName, std::ios::binary);
     if (!infile.is_open()) [[unlikely]] {
       return std::make_unique<ErrorMsgResult>(qname, "Cannot open file '?'"_f %
                                                          this->fileName);
     }
-    Database::loadTableFromStream(infile, this->fileName);
+    const Table &table =
+        TableCodec::isCompressed(infile)
+            ? Database::loadTableFromCompressedStream(infile, this->fileName)
+            : Database::loadTableFromStream(infile, this->fileName);
     infile.close();
+    logRows(*this, table);
     return std::make_unique<SuccessMsgResult>(qname, this->targetTableRef());
   } catch (const std::exception &exc) {
     return std::make_unique<ErrorMsgResult>(qname, exc.what());
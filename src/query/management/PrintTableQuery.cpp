@@ -4,8 +4,8 @@
 
 #include "PrintTableQuery.h"
 
-#include <iostream>
 #include <memory>
+#include <sstream>
 #include <string>
 
 #include "../../db/Database.h"
@@ -19,11 +19,12 @@ QueryResult::Ptr PrintTableQuery::execute() {
     const auto lock =
         TableLockManager::getInstance().acquireRead(this->targetTableRef());
     const auto &table = database[this->targetTableRef()];
-    std::cout << "================\n";
-    std::cout << "TABLE = ";
-    std::cout << table;
-    std::cout << "================\n" << '\n';
-    return std::make_unique<SuccessMsgResult>(qname, this->targetTableRef());
+    std::ostringstream out;
+    out << "================\n";
+    out << "TABLE = ";
+    out << table;
+    out << "================\n" << '\n';
+    return std::make_unique<TextRowsResult>(out.view());
   } catch (const TableNameNotFound &exc) {
     return std::make_unique<ErrorMsgResult>(qname, this->targetTableRef(),
                                             std::string("No such table."));
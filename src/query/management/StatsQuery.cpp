@@ -0,0 +1,84 @@
+#include "StatsQuery.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "../../threading/Reclaimer.h"
+#include "../../utils/QueryStats.h"
+#include "../../utils/ResultBuffer.h"
+#include "../QueryResult.h"
+#include "../ResultCache.h"
+
+namespace {
+constexpr uint64_t kNanosPerMicro = 1000;
+constexpr uint64_t kMicrosPerMilli = 1000;
+constexpr uint64_t kMicrosPerSecond = 1000000;
+// Percentiles, in thousandths
+constexpr uint64_t kMedian = 500;
+constexpr uint64_t kTwoNines = 990;
+constexpr uint64_t kThreeNines = 999;
+
+/** Print the percentiles of a histogram, in microseconds */
+void printPercentiles(ResultBuffer &out, std::string_view name,
+                      const LatencyHistogram &histogram) {
+  out << "    " << name << " = p50 "
+      << histogram.percentile(kMedian) / kNanosPerMicro << " us, p99 "
+      << histogram.percentile(kTwoNines) / kNanosPerMicro << " us, p999 "
+      << histogram.percentile(kThreeNines) / kNanosPerMicro << " us\n";
+}
+
+/** Print the count, throughput and latencies of a group of queries */
+void printGroup(ResultBuffer &out, std::string_view name,
+                const QueryStats::Latencies &latencies, uint64_t micros) {
+  const uint64_t count = latencies.run.count();
+  if (count == 0) {
+    return;
+  }
+  out << "  " << name << " = " << count << " queries, "
+      << count * kMicrosPerSecond / micros << "/s\n";
+  printPercentiles(out, "Wait", latencies.wait);
+  printPercentiles(out, "Run", latencies.run);
+}
+}  // namespace
+
+QueryResult::Ptr StatsQuery::execute() {
+  auto &stats = QueryStats::getInstance();
+  if (resetting) {
+    stats.reset();
+    return std::make_unique<SuccessMsgResult>(qname);
+  }
+
+  const auto elapsed =
+      std::chrono::duration_cast<std::chrono::microseconds>(stats.elapsed());
+  const auto micros =
+      std::max<uint64_t>(1, static_cast<uint64_t>(elapsed.count()));
+  auto out = ResultBuffer::acquire();
+  *out << "STATS FOR " << micros / kMicrosPerMilli << " ms\n";
+  printGroup(*out, "All", stats.all(), micros);
+  stats.forEachKeyword(
+      [&out, micros](std::string_view keyword,
+                     const QueryStats::Latencies &latencies) {
+        printGroup(*out, "Query " + std::string(keyword), latencies, micros);
+      });
+  stats.forEachTable([&out, micros](std::string_view table,
+                                    const QueryStats::Latencies &latencies) {
+    printGroup(*out, "Table " + std::string(table), latencies, micros);
+  });
+
+  const auto &cache = ResultCache::getInstance();
+  *out << "  Result cache = " << cache.hits() << " hits, " << cache.misses()
+       << " misses, " << cache.usedBytes() << " bytes\n";
+  const auto &reclaimer = Reclaimer::getInstance();
+  *out << "  Reclaimer = " << reclaimer.freedBytes() << " bytes freed, "
+       << reclaimer.pendingBytes() << " bytes pending\n";
+  return std::make_unique<TextRowsResult>(std::move(out));
+}
+
+std::string StatsQuery::toString() {
+  return resetting ? "QUERY = STATS RESET" : "QUERY = STATS";
+}
@@ -0,0 +1,33 @@
+#ifndef PROJECT_STATSQUERY_H
+#define PROJECT_STATSQUERY_H
+
+#include <string>
+
+#include "../../db/QueryBase.h"
+#include "../QueryResult.h"
+
+/**
+ * STATS: print the latency percentiles and throughput of the queries run so
+ * far, by statement keyword and by table (see QueryStats), with the counters
+ * the result cache and the reclaimer kept since the process started.
+ * STATS RESET forgets the queries counted so far instead. Both are barriers,
+ * so they cover exactly the queries before them.
+ */
+class StatsQuery : public Query {
+  static constexpr const char *qname = "STATS";
+  bool resetting;
+
+public:
+  /**
+   * @param reset Whether to forget the queries counted instead of printing
+   */
+  explicit StatsQuery(bool reset) : resetting(reset) {}
+
+  QueryResult::Ptr execute() override;
+
+  std::string toString() override;
+
+  [[nodiscard]] bool isBarrier() const override { return true; }
+};
+
+#endif  // PROJECT_STATSQUERY_H
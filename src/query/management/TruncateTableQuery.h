@@ -21,6 +21,8 @@ public:
    * @return String representation of the TRUNCATE query
    */
   std::string toString() override;
+
+  [[nodiscard]] bool isWriter() const override { return true; }
 };
 
 #endif  // PROJECT_TRUNCATETABLEQUERY_H
@@ -0,0 +1,127 @@
+#include "ExplainQuery.h"
+
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <string>
+
+#include "../../db/Table.h"
+#include "../../db/TableLockManager.h"
+#include "../../db/TableStatistics.h"
+#include "../../threading/Threadpool.h"
+#include "../../utils/ResultBuffer.h"
+#include "../../utils/uexception.h"
+#include "../Query.h"
+#include "../QueryResult.h"
+
+namespace {
+/**
+ * Describe how the rows of some chunks are scanned
+ * @param out The buffer to describe in
+ * @param chunks The chunks of rows
+ * @param split Whether there are enough rows to split them over threads
+ */
+void printThreads(ResultBuffer &out, size_t chunks, bool split) {
+  const bool parallel = split && ThreadPool::isInitialized() &&
+                        ThreadPool::getInstance().getThreadCount() > 1;
+  out << "  Threads = " << (parallel ? "multi" : "single") << ", " << chunks
+      << " chunks of " << Table::splitsize() << " rows\n";
+}
+
+/** List the conditions in the order they are tested */
+void printConditions(ResultBuffer &out, const ComplexQuery &query,
+                     const TableStatistics *stats, size_t rows) {
+  out << "  Conditions =";
+  if (query.getCondition().empty()) {
+    out << " none\n";
+    return;
+  }
+  double kept = 1;
+  bool keyed = false;
+  const char *separator = " ";
+  for (const auto &cond : query.getCondition()) {
+    out << separator << "( " << cond.field << ' ' << cond.op << ' '
+        << cond.value << " )";
+    separator = ", ";
+    if (cond.fieldId == static_cast<size_t>(-1)) {
+      // KEY = matches at most one row
+      keyed = true;
+      kept *= rows == 0 ? 0 : 1 / static_cast<double>(rows);
+      out << " ~" << (rows == 0 ? 0 : 1) << " rows";
+    } else if (stats != nullptr) {
+      const double fraction =
+          stats->column(cond.fieldId).selectivity(cond.op, cond.valueParsed);
+      kept *= fraction;
+      out << " ~" << static_cast<size_t>(fraction * static_cast<double>(rows))
+          << " rows";
+    }
+  }
+  out << '\n';
+  if (stats != nullptr || keyed) {
+    out << "  Estimate = ~"
+        << static_cast<size_t>(kept * static_cast<double>(rows)) << " of "
+        << rows << " rows\n";
+  }
+}
+}  // namespace
+
+QueryResult::Ptr ExplainQuery::execute() {
+  try {
+    auto out = ResultBuffer::acquire();
+    *out << "PLAN FOR " << query->toString() << '\n';
+    const auto *scan = dynamic_cast<const ScanQuery *>(query.get());
+    if (scan != nullptr && scan->isCached()) {
+      *out << "  Access = ResultCache\n";
+      return std::make_unique<TextRowsResult>(std::move(out));
+    }
+    if (scan != nullptr && scan->hasView()) {
+      *out << "  Access = View\n";
+      return std::make_unique<TextRowsResult>(std::move(out));
+    }
+
+    TableLockManager::ReadLock lock;
+    const Table &table = query->readTable(lock);
+    const auto keyed = query->initCondition(table);
+    if (!keyed.second) {
+      *out << "  Access = None, the condition is never true\n";
+      return std::make_unique<TextRowsResult>(std::move(out));
+    }
+    const auto stats = table.statistics();
+    switch (query->accessPath()) {
+    case ComplexQuery::AccessPath::Index:
+      *out << "  Access = Index, KEY = " << keyed.first << '\n';
+      *out << "  Threads = single, 1 row\n";
+      break;
+    case ComplexQuery::AccessPath::ZoneMap: {
+      size_t candidates = 0;
+      for (Table::SizeType block = 0; block < table.blockCount(); ++block) {
+        candidates += query->mayMatchBlock(block) ? 1 : 0;
+      }
+      *out << "  Access = ZoneMap, " << candidates << " of "
+           << table.blockCount() << " blocks\n";
+      printThreads(*out, candidates, candidates > 1);
+      break;
+    }
+    case ComplexQuery::AccessPath::FullScan:
+      *out << "  Access = FullScan"
+           << (stats == nullptr ? ", not analyzed" : "") << '\n';
+      printThreads(*out,
+                   (table.size() + Table::splitsize() - 1) /
+                       Table::splitsize(),
+                   table.size() >= Table::splitsize());
+      break;
+    }
+    printConditions(*out, *query, stats.get(), table.size());
+    return std::make_unique<TextRowsResult>(std::move(out));
+  } catch (const TableNameNotFound &) {
+    return std::make_unique<ErrorMsgResult>(qname, this->targetTableRef(),
+                                            "No such table.");
+  } catch (const std::exception &exc) {
+    return std::make_unique<ErrorMsgResult>(qname, this->targetTableRef(),
+                                            exc.what());
+  }
+}
+
+std::string ExplainQuery::toString() {
+  return "QUERY = EXPLAIN, " + query->toString();
+}
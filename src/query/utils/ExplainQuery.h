@@ -0,0 +1,35 @@
+#ifndef PROJECT_EXPLAINQUERY_H
+#define PROJECT_EXPLAINQUERY_H
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "../../db/QueryBase.h"
+#include "../Query.h"
+#include "../QueryResult.h"
+
+/**
+ * EXPLAIN <query>: print the plan a data query would run with on its table,
+ * without running it: the access path, whether the rows are split over the
+ * thread pool and in how many chunks, and the order the conditions are
+ * tested in, with the rows each is estimated to keep once the table was
+ * analyzed (see ComplexQuery::initCondition)
+ */
+class ExplainQuery : public Query {
+  static constexpr const char *qname = "EXPLAIN";
+  std::unique_ptr<ComplexQuery> query;
+
+public:
+  /**
+   * @param query The query to explain
+   */
+  explicit ExplainQuery(std::unique_ptr<ComplexQuery> query)
+      : Query(query->targetTableRef()), query(std::move(query)) {}
+
+  QueryResult::Ptr execute() override;
+
+  std::string toString() override;
+};
+
+#endif  // PROJECT_EXPLAINQUERY_H
@@ -6,11 +6,10 @@
 #include <cstdio>
 #include <deque>
 #include <exception>
-#include <fstream>
 #include <ios>
+#include <istream>
 #include <iostream>
 #include <memory>
-#include <sstream>
 #include <stack>
 #include <stdexcept>
 #include <string>
@@ -18,7 +17,10 @@
 #include <utility>
 
 #include "../../db/Database.h"
+#include "../../threading/ParsePipeline.h"
 #include "../../threading/QueryManager.h"
+#include "../../utils/ReadAhead.h"
+#include "../../utils/StatementReader.h"
 #include "../../utils/formatter.h"
 #include "../QueryParser.h"
 #include "../QueryResult.h"
@@ -26,13 +28,13 @@
 #include "../management/WaitQuery.h"
 
 namespace {
-std::string trimCopy(std::string_view input) {
+std::string_view trimView(std::string_view input) {
   const auto first = input.find_first_not_of(" \t\n\r");
   if (first == std::string_view::npos) {
-    return "";
+    return {};
   }
   const auto last = input.find_last_not_of(" \t\n\r");
-  return std::string(input.substr(first, last - first + 1));
+  return input.substr(first, last - first + 1);
 }
 
 bool startsWithCaseInsensitive(std::string_view value,
@@ -50,58 +52,42 @@ bool startsWithCaseInsensitive(std::string_view value,
   return true;
 }
 
-bool readNextStatement(std::istream &stream, std::string &out_statement) {
-  out_statement.clear();
-  while (true) {
-    const int character = stream.get();
-    if (character == ';') {
-      return true;
-    }
-    if (character == EOF) {
-      if (out_statement.empty()) {
-        return false;
-      }
-      throw std::ios_base::failure("Unexpected end of input before ';'");
-    }
-    out_statement.push_back(static_cast<char>(character));
-  }
-}
-
-std::string extractNewTableName(const std::string &trimmed) {
+std::string extractNewTableName(std::string_view trimmed) {
   constexpr size_t copytable_prefix_len = 9;  // length of "COPYTABLE"
-  std::string new_table_name = trimmed.substr(copytable_prefix_len);
+  std::string_view new_table_name = trimmed.substr(copytable_prefix_len);
 
   size_t position = new_table_name.find_first_not_of(" \t");
-  if (position == std::string::npos) {
+  if (position == std::string_view::npos) {
     return "";
   }
   new_table_name = new_table_name.substr(position);
 
   position = new_table_name.find_first_of(" \t");
-  if (position == std::string::npos) {
+  if (position == std::string_view::npos) {
     return "";
   }
   new_table_name = new_table_name.substr(position);
 
   position = new_table_name.find_first_not_of(" \t;");
-  if (position == std::string::npos) {
+  if (position == std::string_view::npos) {
     return "";
   }
   new_table_name = new_table_name.substr(position);
 
   position = new_table_name.find_first_of(" \t;");
-  if (position != std::string::npos) {
+  if (position != std::string_view::npos) {
     new_table_name = new_table_name.substr(0, position);
   }
 
-  return new_table_name;
+  return std::string(new_table_name);
 }
 
 // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
-void handleCopyTable(QueryManager &query_manager, const std::string &trimmed,
+void handleCopyTable(QueryManager &query_manager, std::string_view trimmed,
                      const std::string &source_table,
                      CopyTableQuery *copy_query) {
-  if (copy_query == nullptr) {
+  // Run in order, the copy is done before the new table is used
+  if (copy_query == nullptr || query_manager.isSingleThreaded()) {
     return;
   }
 
@@ -118,7 +104,7 @@ void handleCopyTable(QueryManager &query_manager, const std::string &trimmed,
 }  // namespace
 
 void ListenQuery::setDependencies(
-    QueryManager *manager, QueryParser *parser, Database *database_ptr,
+    QueryManager *manager, const QueryParser *parser, Database *database_ptr,
     std::atomic<size_t> *counter,
     std::deque<std::unique_ptr<ListenQuery>> *pending_queue) {
   query_manager = manager;
@@ -128,13 +114,17 @@ void ListenQuery::setDependencies(
   pending_listens = pending_queue;
 }
 
-bool ListenQuery::shouldSkipStatement(const std::string &trimmed) {
+bool ListenQuery::shouldSkipStatement(std::string_view trimmed) {
   return trimmed.empty() || trimmed.front() == '#';
 }
 
-bool ListenQuery::processStatement(const std::string &trimmed,
+bool ListenQuery::processStatement(std::string_view trimmed,
                                    std::string *nested_file_out) {
-  Query::Ptr query = query_parser->parseQuery(trimmed);
+  auto parsed = query_parser->parse(trimmed);
+  if (!parsed.ok()) [[unlikely]] {
+    return true;  // Malformed statements are skipped
+  }
+  Query::Ptr query = std::move(parsed.query);
   // std::cerr << "[LISTEN] Parsed query: " << query->toString() << '\n';
 
   if (startsWithCaseInsensitive(trimmed, "QUIT")) {
@@ -155,6 +145,8 @@ bool ListenQuery::processStatement(const std::string &trimmed,
       // Assign ID immediately to preserve order
       const size_t nested_id = query_counter->fetch_add(1) + 1;
       nested_listen->setId(nested_id);
+      // Runs after this file: start reading it now
+      ReadAhead::getInstance().prefetch(nested_listen->getFileName());
       pending_listens->push_back(std::unique_ptr<ListenQuery>(nested_listen));
       // Increment scheduled count because this nested listen is a query
       // scheduled by us
@@ -168,15 +160,21 @@ bool ListenQuery::processStatement(const std::string &trimmed,
     return true;
   }
 
+  scheduleQuery(std::move(query));
+  return true;  // Continue processing
+}
+
+void ListenQuery::scheduleQuery(Query::Ptr &&query) {
   const size_t query_id = query_counter->fetch_add(1) + 1;
   // std::cerr << "[LISTEN] Adding query " << query_id << " to table " <<
   // query->targetTableRef() << '\n';
-  query_manager->addQuery(query_id, query->targetTableRef(), query.release());
+  // Copy the table name first: the order in which the arguments below are
+  // evaluated is unspecified, and release() must not run before it is read.
+  const std::string table_name = query->targetTableRef();
+  query_manager->addQuery(query_id, table_name, query.release());
   scheduled_query_count++;
   // std::cerr << "[LISTEN] Scheduled query count: " << scheduled_query_count <<
   // '\n';
-
-  return true;  // Continue processing
 }
 
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
@@ -188,43 +186,57 @@ QueryResult::Ptr ListenQuery::execute() {
 
   struct FileContext {
     std::string name;
-    std::unique_ptr<std::ifstream> stream;
+    std::unique_ptr<std::istream> stream;
+    std::unique_ptr<StatementReader> reader;
   };
 
   std::stack<FileContext> file_stack;
-  auto initial_stream = std::make_unique<std::ifstream>(fileName);
-  if (!initial_stream->is_open()) {
+  auto initial_stream = ReadAhead::getInstance().open(fileName);
+  if (initial_stream == nullptr) {
     return std::make_unique<ErrorMsgResult>(qname, "Cannot open file '?'"_f %
                                                        fileName);
   }
-  file_stack.push({fileName, std::move(initial_stream)});
+  auto initial_reader = std::make_unique<StatementReader>(*initial_stream);
+  file_stack.push(
+      {fileName, std::move(initial_stream), std::move(initial_reader)});
 
   scheduled_query_count = 0;
   quit_encountered = false;
-  std::string raw_statement;
+  std::string_view raw_statement;
+
+  // Plain statements are parsed on the pool; everything that takes a query
+  // id here (control statements, nested results, errors) drains it first.
+  ParsePipeline pipeline(*query_parser, [this](Query::Ptr &&query) {
+    scheduleQuery(std::move(query));
+  });
 
   while (!file_stack.empty()) {
     auto &current_ctx = file_stack.top();
 
     try {
-      if (!readNextStatement(*current_ctx.stream, raw_statement)) {
+      if (!current_ctx.reader->next(raw_statement)) {
+        pipeline.drain();
         if (file_stack.size() > 1) {
-          std::ostringstream oss;
-          oss << ListenResult(current_ctx.name);
-          query_manager->addImmediateResult(query_counter->fetch_add(1) + 1,
-                                            oss.str());
+          query_manager->addImmediateResult(
+              query_counter->fetch_add(1) + 1,
+              ListenResult(current_ctx.name).takeBuffer());
         }
         file_stack.pop();
         continue;
       }
 
-      const std::string trimmed = trimCopy(raw_statement);
+      const std::string_view trimmed = trimView(raw_statement);
       if (shouldSkipStatement(trimmed)) {
         continue;
       }
 
       std::string nested_file;
       try {
+        if (!ParsePipeline::needsOrdering(trimmed)) [[likely]] {
+          pipeline.submit(trimmed);
+          continue;
+        }
+        pipeline.drain();
         if (!processStatement(trimmed, &nested_file)) {
           break;  // QUIT encountered
         }
@@ -233,30 +245,35 @@ QueryResult::Ptr ListenQuery::execute() {
       }
 
       if (!nested_file.empty()) {
-        auto nested_stream = std::make_unique<std::ifstream>(nested_file);
-        if (!nested_stream->is_open()) {
-          std::ostringstream oss;
-          oss << ErrorMsgResult(qname, "Cannot open file '?'"_f % nested_file);
-          query_manager->addImmediateResult(query_counter->fetch_add(1) + 1,
-                                            oss.str());
+        auto nested_stream = ReadAhead::getInstance().open(nested_file);
+        if (nested_stream == nullptr) {
+          query_manager->addImmediateResult(
+              query_counter->fetch_add(1) + 1,
+              ErrorMsgResult(qname, "Cannot open file '?'"_f % nested_file)
+                  .takeBuffer());
         } else {
-          file_stack.push({nested_file, std::move(nested_stream)});
+          auto nested_reader =
+              std::make_unique<StatementReader>(*nested_stream);
+          file_stack.push({nested_file, std::move(nested_stream),
+                           std::move(nested_reader)});
         }
       }
     } catch (const std::ios_base::failure &) {
+      pipeline.drain();
       if (file_stack.size() == 1) {
         return std::make_unique<ErrorMsgResult>(
             qname, "Unexpected EOF in listen file '?'"_f % current_ctx.name);
       }
-      std::ostringstream oss;
-      oss << ErrorMsgResult(qname, "Unexpected EOF in listen file '?'"_f %
-                                       current_ctx.name);
-      query_manager->addImmediateResult(query_counter->fetch_add(1) + 1,
-                                        oss.str());
+      query_manager->addImmediateResult(
+          query_counter->fetch_add(1) + 1,
+          ErrorMsgResult(qname, "Unexpected EOF in listen file '?'"_f %
+                                    current_ctx.name)
+              .takeBuffer());
       file_stack.pop();
     }
   }
 
+  pipeline.drain();
   if (!quit_encountered) {
     // std::cerr << "[LISTEN] Reached end of file for " << fileName << '\n';
   }
@@ -6,6 +6,7 @@
 #include <deque>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 
 #include "../../db/QueryBase.h"
@@ -20,7 +21,7 @@ class ListenQuery : public Query {
   std::string fileName;
 
   QueryManager *query_manager = nullptr;
-  QueryParser *query_parser = nullptr;
+  const QueryParser *query_parser = nullptr;
   Database *database = nullptr;
   std::atomic<size_t> *query_counter = nullptr;
   std::deque<std::unique_ptr<ListenQuery>> *pending_listens = nullptr;
@@ -29,9 +30,10 @@ class ListenQuery : public Query {
   bool quit_encountered = false;
   size_t id = 0;
 
-  static bool shouldSkipStatement(const std::string &trimmed);
-  bool processStatement(const std::string &trimmed,
+  static bool shouldSkipStatement(std::string_view trimmed);
+  bool processStatement(std::string_view trimmed,
                         std::string *nested_file_out = nullptr);
+  void scheduleQuery(Query::Ptr &&query);
 
 public:
   explicit ListenQuery(std::string filename)
@@ -41,7 +43,7 @@ public:
   [[nodiscard]] size_t getId() const { return id; }
 
   void setDependencies(
-      QueryManager *manager, QueryParser *parser, Database *database_ptr,
+      QueryManager *manager, const QueryParser *parser, Database *database_ptr,
       std::atomic<size_t> *counter,
       std::deque<std::unique_ptr<ListenQuery>> *pending_queue = nullptr);
 
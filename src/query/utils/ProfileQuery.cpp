@@ -0,0 +1,60 @@
+#include "ProfileQuery.h"
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "../../utils/QueryProfile.h"
+#include "../../utils/ResultBuffer.h"
+#include "../QueryResult.h"
+
+namespace {
+/** Print a duration in whole microseconds */
+void printTime(ResultBuffer &out, QueryProfile::Clock::duration time) {
+  out << std::chrono::duration_cast<std::chrono::microseconds>(time).count()
+      << " us\n";
+}
+}  // namespace
+
+QueryResult::Ptr ProfileQuery::execute() {
+  QueryProfile profile;
+  query->attachProfile(&profile);
+  QueryResult::Ptr result;
+  ResultBuffer::Ptr rows;
+  {
+    const QueryProfile::Activation activation(profile);
+    result = query->execute();
+    if (result->success() && result->display()) {
+      const QueryProfile::StageTimer timer(QueryProfile::Stage::Format);
+      rows = result->takeBuffer();
+    }
+  }
+  query->attachProfile(nullptr);
+  if (!result->success()) [[unlikely]] {
+    return result;
+  }
+
+  // The rows may be shared with the result cache, so they are copied
+  auto out = ResultBuffer::acquire();
+  if (rows != nullptr) {
+    *out << rows->view();
+    profile.addBytes(rows->size());
+  }
+  *out << "PROFILE FOR " << query->toString() << "\n  Total = ";
+  printTime(*out, profile.total());
+  for (size_t stage = 0; stage < QueryProfile::kStages; ++stage) {
+    *out << "  " << QueryProfile::kStageNames[stage] << " = ";
+    printTime(*out,
+              profile.timeOf(static_cast<QueryProfile::Stage>(stage)));
+  }
+  *out << "  Rows = " << profile.rowsScanned() << " scanned, "
+       << profile.rowsMatched() << " matched\n";
+  *out << "  Bytes = " << profile.bytes() << '\n';
+  return std::make_unique<TextRowsResult>(std::move(out));
+}
+
+std::string ProfileQuery::toString() {
+  return "QUERY = PROFILE, " + query->toString();
+}
@@ -0,0 +1,51 @@
+#ifndef PROJECT_PROFILEQUERY_H
+#define PROJECT_PROFILEQUERY_H
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "../../db/QueryBase.h"
+#include "../Query.h"
+#include "../QueryResult.h"
+
+class Table;
+
+/**
+ * PROFILE <query>: run a data query as it would run on its own, then print
+ * its output followed by where the time went (see QueryProfile), the rows
+ * tested against its condition and those that met it, and the bytes of
+ * output it produced
+ *
+ * The query is scheduled as the query it wraps would be.
+ */
+class ProfileQuery : public Query {
+  static constexpr const char *qname = "PROFILE";
+  std::unique_ptr<ComplexQuery> query;
+
+public:
+  /**
+   * @param query The query to profile
+   */
+  explicit ProfileQuery(std::unique_ptr<ComplexQuery> query)
+      : Query(query->targetTableRef()), query(std::move(query)) {}
+
+  QueryResult::Ptr execute() override;
+
+  std::string toString() override;
+
+  [[nodiscard]] bool isWriter() const override { return query->isWriter(); }
+  [[nodiscard]] bool isPointWriter() const override {
+    return query->isPointWriter();
+  }
+  [[nodiscard]] bool isInstant() const override { return query->isInstant(); }
+  [[nodiscard]] bool isBarrier() const override { return query->isBarrier(); }
+  [[nodiscard]] bool readsSnapshot() const override {
+    return query->readsSnapshot();
+  }
+  void pinSnapshot(std::shared_ptr<const Table> snapshot) override {
+    query->pinSnapshot(std::move(snapshot));
+  }
+};
+
+#endif  // PROJECT_PROFILEQUERY_H
@@ -0,0 +1,117 @@
+#include "EpochManager.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+EpochManager::Guard::Guard() { EpochManager::getInstance().enter(); }
+
+EpochManager::Guard::~Guard() { EpochManager::getInstance().leave(); }
+
+EpochManager::ThreadState::~ThreadState() {
+  if (slot != nullptr) {
+    slot->epoch.store(kIdle, std::memory_order_release);
+    slot->used.store(false, std::memory_order_release);
+  }
+}
+
+EpochManager::~EpochManager() {
+  // Every other thread is gone, nothing can be read any more
+  for (const auto &item : retired) {
+    item.garbage.destroy(item.garbage.object);
+  }
+  Slot *slot = slots.load();
+  while (slot != nullptr) {
+    Slot *next = slot->next;
+    delete slot;
+    slot = next;
+  }
+}
+
+EpochManager::ThreadState &EpochManager::threadState() {
+  thread_local ThreadState state;
+  return state;
+}
+
+EpochManager::Slot *EpochManager::acquireSlot() {
+  // Reuse the slot of a thread that has exited
+  for (Slot *slot = slots.load(std::memory_order_acquire); slot != nullptr;
+       slot = slot->next) {
+    bool expected = false;
+    if (!slot->used.load(std::memory_order_relaxed) &&
+        slot->used.compare_exchange_strong(expected, true)) {
+      return slot;
+    }
+  }
+  auto *slot = new Slot;
+  slot->next = slots.load(std::memory_order_relaxed);
+  while (!slots.compare_exchange_weak(slot->next, slot)) {
+  }
+  return slot;
+}
+
+void EpochManager::enter() {
+  auto &state = threadState();
+  if (state.depth++ != 0) [[unlikely]] {
+    return;
+  }
+  if (state.slot == nullptr) [[unlikely]] {
+    state.slot = acquireSlot();
+  }
+  // Sequentially consistent, so a collect() that misses this announcement
+  // has unlinked its objects before the reads this guard protects
+  state.slot->epoch.store(globalEpoch.load());
+}
+
+void EpochManager::leave() {
+  auto &state = threadState();
+  if (--state.depth != 0) [[unlikely]] {
+    return;
+  }
+  state.slot->epoch.store(kIdle, std::memory_order_release);
+  if (pendingCount.load(std::memory_order_relaxed) != 0) [[unlikely]] {
+    collect();
+  }
+}
+
+void EpochManager::retire(const Reclaimer::Garbage &garbage) {
+  {
+    const std::scoped_lock lock(retiredMutex);
+    // Threads entering from now on announce a later epoch
+    retired.push_back({garbage, globalEpoch.fetch_add(1)});
+    pendingCount.fetch_add(1, std::memory_order_relaxed);
+  }
+  collect();
+}
+
+void EpochManager::collect() {
+  std::vector<Reclaimer::Garbage> reclaimable;
+  {
+    std::unique_lock lock(retiredMutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+      return;  // Another thread is collecting
+    }
+    // Scanned after the objects below were retired: a thread missed here
+    // entered later and cannot reach them
+    uint64_t oldest = kIdle;
+    for (Slot *slot = slots.load(std::memory_order_acquire); slot != nullptr;
+         slot = slot->next) {
+      oldest = std::min(oldest, slot->epoch.load());
+    }
+    auto keep = retired.begin();
+    for (auto &item : retired) {
+      if (item.epoch < oldest) {
+        reclaimable.push_back(item.garbage);
+      } else {
+        *keep++ = item;
+      }
+    }
+    retired.erase(keep, retired.end());
+    pendingCount.fetch_sub(reclaimable.size(), std::memory_order_relaxed);
+  }
+
+  Reclaimer::getInstance().dispose(std::move(reclaimable));
+}
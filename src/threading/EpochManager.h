@@ -0,0 +1,129 @@
+#ifndef PROJECT_EPOCH_MANAGER_H
+#define PROJECT_EPOCH_MANAGER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "Reclaimer.h"
+
+/**
+ * Epoch-based reclamation of objects other threads may still be reading.
+ *
+ * A thread reads shared objects inside a Guard, which announces the global
+ * epoch the thread entered in. An object unlinked from every shared structure
+ * is retired with the epoch it was retired in, and the global epoch advances.
+ * Threads that enter later cannot find the object any more, so it is
+ * destroyed once every thread that entered at or before its epoch has left.
+ *
+ * Entering and leaving a guard are a few atomic operations on the thread's
+ * own slot and never wait, so readers need no lock. Guards nest; only the
+ * outermost one announces an epoch. collect(), which retire() and the
+ * outermost guard exit call while objects are pending, hands the objects no
+ * thread can reach to the Reclaimer to be destroyed in the background.
+ *
+ * Usage:
+ *  - Look shared objects up inside `const EpochManager::Guard guard;`.
+ *  - After unlinking an object, hand it to `retire(std::move(owner))`.
+ */
+class EpochManager {
+public:
+  /** Announces the calling thread's epoch while alive */
+  class Guard {
+  public:
+    Guard();
+    ~Guard();
+
+    Guard(const Guard &) = delete;
+    Guard &operator=(const Guard &) = delete;
+    Guard(Guard &&) = delete;
+    Guard &operator=(Guard &&) = delete;
+  };
+
+  [[nodiscard]] static EpochManager &getInstance() {
+    static EpochManager instance;
+    return instance;
+  }
+
+  EpochManager(const EpochManager &) = delete;
+  EpochManager &operator=(const EpochManager &) = delete;
+  EpochManager(EpochManager &&) = delete;
+  EpochManager &operator=(EpochManager &&) = delete;
+  ~EpochManager();
+
+  /**
+   * Destroy an object once no thread can still be reading it
+   * @param object The object, already unlinked from every shared structure
+   * @param bytes Estimated size of the object and what it owns
+   */
+  template <class Type>
+  void retire(std::unique_ptr<Type> object, size_t bytes = 0) {
+    if (object == nullptr) [[unlikely]] {
+      return;
+    }
+    retire(Reclaimer::wrap(std::move(object), bytes));
+  }
+
+  /**
+   * Hand the retired objects no thread can still be reading to the Reclaimer
+   */
+  void collect();
+
+  /**
+   * Get the number of retired objects not destroyed yet
+   */
+  [[nodiscard]] size_t pending() const {
+    return pendingCount.load(std::memory_order_relaxed);
+  }
+
+private:
+  static constexpr uint64_t kIdle = std::numeric_limits<uint64_t>::max();
+  static constexpr size_t kCacheLine = 64;
+
+  /** A thread's announced epoch; reused after its thread exits */
+  struct alignas(kCacheLine) Slot {
+    std::atomic<uint64_t> epoch{kIdle};
+    std::atomic<bool> used{true};
+    Slot *next = nullptr;
+  };
+
+  struct Retired {
+    Reclaimer::Garbage garbage;
+    uint64_t epoch;
+  };
+
+  /** Per-thread guard nesting and slot */
+  struct ThreadState {
+    Slot *slot = nullptr;
+    size_t depth = 0;
+    ThreadState() = default;
+    ThreadState(const ThreadState &) = delete;
+    ThreadState &operator=(const ThreadState &) = delete;
+    ThreadState(ThreadState &&) = delete;
+    ThreadState &operator=(ThreadState &&) = delete;
+    ~ThreadState();
+  };
+
+  EpochManager() = default;
+
+  std::atomic<uint64_t> globalEpoch{0};
+  std::atomic<Slot *> slots{nullptr};
+  std::atomic<size_t> pendingCount{0};
+
+  /** Protects retired */
+  std::mutex retiredMutex;
+  std::vector<Retired> retired;
+
+  static ThreadState &threadState();
+  Slot *acquireSlot();
+  void enter();
+  void leave();
+  void retire(const Reclaimer::Garbage &garbage);
+};
+
+#endif  // PROJECT_EPOCH_MANAGER_H
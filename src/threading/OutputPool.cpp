@@ -2,20 +2,21 @@
 
 #include <atomic>
 #include <cstddef>
-#include <iostream>
 #include <mutex>
-#include <string>
 #include <utility>
 #include <vector>
 
-void OutputPool::addResult(size_t query_id, const std::string &result) {
+#include "../utils/OutputSink.h"
+#include "../utils/ResultBuffer.h"
+
+void OutputPool::addResult(size_t query_id, ResultBuffer::Ptr result) {
   // std::cerr << "Adding result for query_id " << query_id << "\n";
   const std::scoped_lock lock(results_mutex);
-  results[query_id] = result;
+  results[query_id] = std::move(result);
 }
 
 size_t OutputPool::flushContinuousResults() {
-  std::vector<std::pair<size_t, std::string>> ready_results;
+  std::vector<std::pair<size_t, ResultBuffer::Ptr>> ready_results;
   {
     const std::scoped_lock lock(results_mutex);
     while (true) {
@@ -24,7 +25,7 @@ size_t OutputPool::flushContinuousResults() {
         break;
       }
 
-      ready_results.emplace_back(iter->first, iter->second);
+      ready_results.emplace_back(iter->first, std::move(iter->second));
       results.erase(iter);
       ++next_output_id;
     }
@@ -32,21 +33,13 @@ size_t OutputPool::flushContinuousResults() {
 
   const size_t flushed_count = ready_results.size();
 
-  // cppcheck-suppress unassignedVariable
-  for (const auto &[query_id, result_string] : ready_results) {
-    const bool is_quit = result_string.find("QUIT") != std::string::npos;
-
-    if (!is_quit) [[unlikely]] {
-      std::cout << query_id << "\n";
-    }
-
-    if (!result_string.empty()) {
-      std::cout << result_string;
+  {
+    const std::scoped_lock lock(sink_mutex);
+    // cppcheck-suppress unassignedVariable
+    for (auto &[query_id, result] : ready_results) {
+      sink.write(query_id, std::move(result));
     }
-  }
-
-  if (flushed_count > 0) {
-    std::cout.flush();
+    sink.flushIfDue();
   }
 
   total_output_count.fetch_add(flushed_count, std::memory_order_relaxed);
@@ -56,6 +49,8 @@ size_t OutputPool::flushContinuousResults() {
 void OutputPool::outputAllResults() {
   while (flushContinuousResults() > 0) {
   }
+  const std::scoped_lock lock(sink_mutex);
+  sink.flush();
 }
 
 size_t OutputPool::getResultCount() const {
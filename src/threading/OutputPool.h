@@ -5,26 +5,38 @@
 #include <cstddef>
 #include <map>
 #include <mutex>
-#include <string>
+
+#include "../utils/OutputSink.h"
+#include "../utils/ResultBuffer.h"
 
 /**
  * OutputPool: Thread-safe result buffering and ordering
  *
  * - Each thread adds results as they complete: addResult(query_id,
- * result_string)
+ * result_buffer)
  * - Results are stored in an ordered map (by query_id)
  * - At the end, call outputAllResults() to print everything in order
+ *
+ * Result buffers are moved in and out of the pool, never copied, and
+ * printed through an OutputSink.
  */
 class OutputPool {
 private:
-  // Ordered map: query_id -> result_string
-  std::map<size_t, std::string> results;
+  // Ordered map: query_id -> result buffer (nullptr if nothing to print)
+  std::map<size_t, ResultBuffer::Ptr> results;
   size_t next_output_id = 1;
   mutable std::mutex results_mutex;
   std::atomic<size_t> total_output_count{0};
+  OutputSink &sink;
+  // Serializes writers to the sink
+  std::mutex sink_mutex;
 
 public:
-  OutputPool() = default;
+  /**
+   * Construct an OutputPool printing to a sink
+   * @param sink The sink results are written to (must outlive the pool)
+   */
+  explicit OutputPool(OutputSink &sink) : sink(sink) {}
 
   // Default copy/move operations allowed
   OutputPool(const OutputPool &) = delete;
@@ -38,9 +50,9 @@ public:
    * Add a result to the output pool
    * Thread-safe - can be called from multiple threads simultaneously
    * @param query_id The unique identifier for the query result
-   * @param result The result string to add to the pool
+   * @param result The printed result, or nullptr if it prints nothing
    */
-  void addResult(size_t query_id, const std::string &result);
+  void addResult(size_t query_id, ResultBuffer::Ptr result);
 
   /**
    * Flush ready results in order (streaming)
@@ -50,7 +62,7 @@ public:
   size_t flushContinuousResults();
 
   /**
-   * Output all currently buffered results in order.
+   * Output all currently buffered results in order and flush the sink.
    * Provided for compatibility with call sites expecting a bulk flush.
    */
   void outputAllResults();
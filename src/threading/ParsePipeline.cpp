@@ -0,0 +1,110 @@
+#include "ParsePipeline.h"
+
+#include <array>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "../db/QueryBase.h"
+#include "../query/QueryParser.h"
+#include "Threadpool.h"
+
+namespace {
+constexpr size_t kBatchesPerThread = 2;
+
+constexpr std::array<std::string_view, 6> kOrderedKeywords = {
+    "LISTEN", "QUIT", "COPYTABLE", "LOAD", "DUMP", "CHECKPOINT"};
+}  // namespace
+
+ParsePipeline::ParsePipeline(const QueryParser &parser, Router router)
+    : parser(parser), router(std::move(router)),
+      parallel(ThreadPool::isInitialized() &&
+               ThreadPool::getInstance().getThreadCount() > 1) {
+  if (parallel) {
+    maxInFlight =
+        ThreadPool::getInstance().getThreadCount() * kBatchesPerThread;
+  }
+}
+
+bool ParsePipeline::needsOrdering(std::string_view statement) {
+  const auto keyword = statement.substr(0, statement.find_first_of(" \t\n\r"));
+  for (const auto ordered : kOrderedKeywords) {
+    if (keyword == ordered) [[unlikely]] {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ParsePipeline::submit(std::string_view statement) {
+  if (!parallel) [[unlikely]] {
+    auto parsed = parser.parse(statement);
+    if (parsed.ok()) [[likely]] {
+      router(std::move(parsed.query));
+    }
+    return;
+  }
+
+  if (current == nullptr) {
+    current = std::make_unique<Batch>();
+    current->spans.reserve(kStatementsPerBatch);
+  }
+  current->spans.emplace_back(current->text.size(), statement.size());
+  current->text.append(statement);
+  if (current->spans.size() >= kStatementsPerBatch) {
+    submitCurrent();
+  }
+}
+
+void ParsePipeline::drain() {
+  if (current != nullptr) {
+    submitCurrent();
+  }
+  while (!inFlight.empty()) {
+    routeFront();
+  }
+}
+
+void ParsePipeline::submitCurrent() {
+  while (inFlight.size() >= maxInFlight) {
+    routeFront();
+  }
+  std::shared_ptr<const Batch> batch = std::move(current);
+  const ThreadPool &pool = ThreadPool::getInstance();
+  inFlight.push_back(pool.submit([&parser = this->parser, batch]() {
+    return parseBatch(parser, *batch);
+  }));
+}
+
+void ParsePipeline::routeFront() {
+  // Pop the batch before waiting, so a failed batch is not waited on again
+  auto batch = std::move(inFlight.front());
+  inFlight.pop_front();
+  auto queries = batch.get();
+  for (auto &query : queries) {
+    if (query == nullptr) [[unlikely]] {
+      continue;
+    }
+    // A query the router fails on is dropped alone, as when parsed inline
+    try {
+      router(std::move(query));
+    } catch (const std::exception & /*ignored*/) {
+      continue;
+    }
+  }
+}
+
+std::vector<Query::Ptr> ParsePipeline::parseBatch(const QueryParser &parser,
+                                                  const Batch &batch) {
+  const std::string_view text = batch.text;
+  std::vector<Query::Ptr> queries;
+  queries.reserve(batch.spans.size());
+  for (const auto &[offset, length] : batch.spans) {
+    queries.push_back(parser.parse(text.substr(offset, length)).query);
+  }
+  return queries;
+}
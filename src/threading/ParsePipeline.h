@@ -0,0 +1,97 @@
+#ifndef PROJECT_PARSE_PIPELINE_H
+#define PROJECT_PARSE_PIPELINE_H
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "../db/QueryBase.h"
+
+class QueryParser;
+
+/**
+ * ParsePipeline: moves statement parsing off the input thread
+ *
+ * The input thread frames statements and hands them to submit(). Statements
+ * are grouped into batches that are parsed on ThreadPool workers with the
+ * shared (stateless) QueryParser. Finished batches are routed strictly in
+ * submission order through the router callback, which assigns query ids and
+ * enqueues the queries, so per-table order and id numbering are exactly those
+ * of a sequential parse. Statements that fail to parse are dropped, as
+ * before, and consume no query id.
+ *
+ * Statements whose parsing or handling depends on everything before them
+ * (see needsOrdering) must not be submitted: the caller drains the pipeline
+ * and handles them inline.
+ *
+ * Without a multi-threaded pool, submit() parses and routes immediately on
+ * the calling thread.
+ */
+class ParsePipeline {
+public:
+  using Router = std::function<void(Query::Ptr &&)>;
+
+  /** Number of statements parsed by one worker task */
+  static constexpr size_t kStatementsPerBatch = 64;
+
+  /**
+   * Construct a pipeline
+   * @param parser Parser shared by the workers (must outlive the pipeline)
+   * @param router Called in submission order for every parsed query; a
+   * query it throws on is dropped, and the rest of its batch still routed
+   */
+  ParsePipeline(const QueryParser &parser, Router router);
+
+  ParsePipeline(const ParsePipeline &) = delete;
+  ParsePipeline &operator=(const ParsePipeline &) = delete;
+  ParsePipeline(ParsePipeline &&) = delete;
+  ParsePipeline &operator=(ParsePipeline &&) = delete;
+  ~ParsePipeline() = default;
+
+  /**
+   * Check whether a statement must be handled in order on the input thread:
+   * LISTEN, QUIT and COPYTABLE are control statements, while LOAD and DUMP
+   * read or update the file -> table mapping while being parsed.
+   * @param statement The statement with leading whitespace removed
+   */
+  [[nodiscard]] static bool needsOrdering(std::string_view statement);
+
+  /**
+   * Queue a statement for parsing
+   * @param statement The statement text (copied)
+   */
+  void submit(std::string_view statement);
+
+  /**
+   * Wait for every queued statement and route the results
+   * @throws What parsing a batch threw; that batch is dropped, the batches
+   * after it stay queued
+   */
+  void drain();
+
+private:
+  struct Batch {
+    std::string text;
+    std::vector<std::pair<size_t, size_t>> spans;
+  };
+
+  const QueryParser &parser;
+  Router router;
+  bool parallel;
+  size_t maxInFlight = 0;
+  std::unique_ptr<Batch> current;
+  std::deque<std::future<std::vector<Query::Ptr>>> inFlight;
+
+  void submitCurrent();
+  void routeFront();
+  static std::vector<Query::Ptr> parseBatch(const QueryParser &parser,
+                                            const Batch &batch);
+};
+
+#endif  // PROJECT_PARSE_PIPELINE_H
@@ -1,5 +1,6 @@
 #include "QueryManager.h"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <cstddef>
@@ -9,12 +10,24 @@
 #include <mutex>
 #include <optional>
 #include <semaphore>
-#include <sstream>
+#include <span>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <utility>
+#include <vector>
 
+#include "../db/Database.h"
 #include "../db/QueryBase.h"
+#include "../db/Table.h"
+#include "../db/TableLockManager.h"
+#include "../db/WriteAheadLog.h"
 #include "../query/QueryResult.h"
+#include "../utils/QueryStats.h"
+#include "../utils/ResultBuffer.h"
+#include "../utils/Tracer.h"
+#include "../utils/uexception.h"
+#include "EpochManager.h"
 #include "OutputPool.h"
 
 namespace {
@@ -23,19 +36,22 @@ bool isWaitQueryException(const std::exception &exc) {
          std::string::npos;
 }
 
-std::string formatQueryResult(const QueryResult::Ptr &result) {
+ResultBuffer::Ptr formatQueryResult(const QueryResult::Ptr &result) {
   if (result && result->display()) {
-    std::ostringstream oss;
-    oss << *result;
-    return oss.str();
+    return result->takeBuffer();
   }
-  return "";
+  return nullptr;
 }
 
-std::string formatErrorMessage(const std::exception &exc) {
-  std::ostringstream oss;
-  oss << "Error: " << exc.what() << "\n";
-  return oss.str();
+ResultBuffer::Ptr formatErrorMessage(const std::exception &exc) {
+  auto buffer = ResultBuffer::acquire();
+  *buffer << "Error: " << exc.what() << '\n';
+  return buffer;
+}
+
+/** Name a query on the trace timeline by the keyword of its statement */
+std::string_view spanName(const Query &query) {
+  return query.keyword().empty() ? "Query" : query.keyword();
 }
 }  // namespace
 
@@ -46,14 +62,25 @@ void QueryManager::addQuery(size_t query_id, const std::string &table_name,
   if (nullptr == query_ptr) {
     return;
   }
+  const Tracer::Span span("Enqueue", table_name);
   // std::cerr << "Adding query for number " << query_counter << "\n";
   // Update query counter
   query_counter.fetch_add(1);
+  const auto submitted = std::chrono::steady_clock::now();
 
   if (single_threaded_mode) {
-    executeAndStoreResult({query_id, query_ptr});
+    executeAndStoreResult({query_id, query_ptr, submitted});
+    return;
+  }
+
+  // A barrier runs here once everything submitted before it has finished;
+  // nothing after it is submitted meanwhile
+  if (query_ptr->isBarrier()) [[unlikely]] {
+    waitForIdle();
+    executeAndStoreResult({query_id, query_ptr, submitted});
     return;
   }
+  in_flight_count.fetch_add(1);
 
   {
     const std::scoped_lock lock(table_map_mutex);
@@ -64,7 +91,7 @@ void QueryManager::addQuery(size_t query_id, const std::string &table_name,
     }
 
     // Enqueue query with its ID
-    table_query_map[table_name].push_back({query_id, query_ptr});
+    table_query_map[table_name].push_back({query_id, query_ptr, submitted});
   }
 
   // Signal the semaphore to wake up the table's execution thread
@@ -73,8 +100,8 @@ void QueryManager::addQuery(size_t query_id, const std::string &table_name,
 }
 
 void QueryManager::addImmediateResult(size_t query_id,
-                                      const std::string &result) {
-  output_pool.addResult(query_id, result);
+                                      ResultBuffer::Ptr result) {
+  output_pool.addResult(query_id, std::move(result));
   completed_query_count.fetch_add(1);
 }
 
@@ -118,6 +145,23 @@ void QueryManager::releaseSemaphores() {
   for (auto &sem_pair : table_query_sem) {
     sem_pair.second->release();
   }
+  for (auto &sem_pair : table_read_sem) {
+    sem_pair.second->release();
+  }
+}
+
+void QueryManager::waitForIdle() {
+  size_t in_flight = in_flight_count.load();
+  while (in_flight != 0) {
+    in_flight_count.wait(in_flight);
+    in_flight = in_flight_count.load();
+  }
+}
+
+void QueryManager::leaveFlight() {
+  if (in_flight_count.fetch_sub(1) == 1) {
+    in_flight_count.notify_all();
+  }
 }
 
 void QueryManager::joinThreads() {
@@ -130,6 +174,7 @@ void QueryManager::joinThreads() {
 
 void QueryManager::executeQueryForTable(QueryManager *manager,
                                         const std::string &table_name) {
+  Tracer::nameThread("table " + table_name);
 
   while (!manager->is_end.load()) {
     std::counting_semaphore<> *sem_ptr =
@@ -151,7 +196,108 @@ void QueryManager::executeQueryForTable(QueryManager *manager,
       continue;  // Spurious wakeup or shutdown
     }
 
+    if (manager->handOffRead(table_name, query_entry.value())) [[unlikely]] {
+      continue;  // Leaves the flight on the read thread
+    }
+    if (query_entry->query_ptr->isBatchable()) [[unlikely]] {
+      std::vector<QueryEntry> batch{query_entry.value()};
+      manager->dequeueBatch(table_name, batch);
+      manager->executeBatchAndStoreResults(batch);
+      for (size_t i = 0; i < batch.size(); ++i) {
+        manager->leaveFlight();
+      }
+      continue;
+    }
+    manager->executeAndStoreResult(query_entry.value());
+    manager->leaveFlight();
+  }
+}
+
+bool QueryManager::handOffRead(const std::string &table_name,
+                               const QueryEntry &query_entry) {
+  if (!query_entry.query_ptr->readsSnapshot()) [[likely]] {
+    return false;
+  }
+  {
+    // While a snapshot is read, writers copy every block they change. Copying
+    // a block costs far more than scanning it, so hand off only when point
+    // writers wait close behind the read, none that changes rows in bulk, and
+    // no earlier snapshot of the table is still being read
+    const std::scoped_lock lock(table_map_mutex);
+    if (table_read_pending[table_name] != 0) {
+      return false;
+    }
+    const auto &queue = table_query_map[table_name];
+    const auto lookahead =
+        queue.begin() + static_cast<std::ptrdiff_t>(
+                            std::min(queue.size(), kHandOffLookahead));
+    bool writerWaits = false;
+    for (auto it = queue.begin(); it != lookahead; ++it) {
+      if (!it->query_ptr->isWriter()) [[likely]] {
+        continue;
+      }
+      if (!it->query_ptr->isPointWriter()) {
+        return false;
+      }
+      writerWaits = true;
+    }
+    if (!writerWaits) [[likely]] {
+      return false;
+    }
+  }
+  try {
+    const auto table_lock =
+        TableLockManager::getInstance().acquireRead(table_name);
+    query_entry.query_ptr->pinSnapshot(
+        Database::getInstance()[table_name].snapshot());
+  } catch (const TableNameNotFound &) {
+    return false;  // The query reports the error itself
+  }
+
+  const std::scoped_lock lock(table_map_mutex);
+  if (!table_read_map.contains(table_name)) [[unlikely]] {
+    table_read_map[table_name] = std::deque<QueryEntry>();
+    table_read_sem[table_name] = std::make_unique<std::counting_semaphore<>>(0);
+    table_threads.emplace_back(executeReadsForTable, this, table_name);
+  }
+  table_read_map[table_name].push_back(query_entry);
+  ++table_read_pending[table_name];
+  table_read_sem[table_name]->release();
+  return true;
+}
+
+void QueryManager::executeReadsForTable(QueryManager *manager,
+                                        const std::string &table_name) {
+  std::counting_semaphore<> *sem_ptr = nullptr;
+  {
+    const std::scoped_lock lock(manager->table_map_mutex);
+    sem_ptr = manager->table_read_sem[table_name].get();
+  }
+  Tracer::nameThread("reads " + table_name);
+
+  while (!manager->is_end.load()) {
+    sem_ptr->acquire();
+    if (manager->is_end.load()) {
+      break;
+    }
+
+    std::optional<QueryEntry> query_entry;
+    {
+      const std::scoped_lock lock(manager->table_map_mutex);
+      auto &queue = manager->table_read_map[table_name];
+      if (queue.empty()) {
+        continue;
+      }
+      query_entry = queue.front();
+      queue.pop_front();
+    }
+
     manager->executeAndStoreResult(query_entry.value());
+    {
+      const std::scoped_lock lock(manager->table_map_mutex);
+      --manager->table_read_pending[table_name];
+    }
+    manager->leaveFlight();
   }
 }
 
@@ -179,29 +325,103 @@ QueryManager::dequeueQuery(const std::string &table_name) {
   return entry;
 }
 
+void QueryManager::dequeueBatch(const std::string &table_name,
+                                std::vector<QueryEntry> &batch) {
+  const Query &first = *batch.front().query_ptr;
+  const std::scoped_lock lock(table_map_mutex);
+  auto &queue = table_query_map[table_name];
+  auto *sem_ptr = table_query_sem[table_name].get();
+  while (!queue.empty() && batch.size() < kMaxBatch) {
+    const Query &next = *queue.front().query_ptr;
+    if (!first.batchesWith(next)) {
+      break;
+    }
+    batch.push_back(queue.front());
+    queue.pop_front();
+    // Not released yet if its submitter is still in addQuery; the permit then
+    // wakes this thread once more to an empty queue
+    (void)sem_ptr->try_acquire();
+  }
+}
+
 void QueryManager::executeAndStoreResult(const QueryEntry &query_entry) {
   const size_t query_id = query_entry.query_id;
   std::unique_ptr<Query> query_ptr(query_entry.query_ptr);
+  const Tracer::Span span(spanName(*query_ptr), query_ptr->targetTableRef());
+
+  // Tables the query looks up stay alive until it is done (see
+  // Database::operator[])
+  const EpochManager::Guard guard;
+  try {
+    const auto started = std::chrono::steady_clock::now();
+    auto result = query_ptr->execute();
+    QueryStats::getInstance().record(
+        query_ptr->keyword(), query_ptr->targetTableRef(),
+        query_entry.submitted, started, std::chrono::steady_clock::now());
+    storeResult(query_id, *query_ptr, result);
+  } catch (const std::exception &exc) {
+    // A WaitQuery stores no result
+    if (!isWaitQueryException(exc)) {
+      addImmediateResult(query_id, formatErrorMessage(exc));
+    }
+  }
+}
 
-  std::string result_str;
-  bool is_wait_query = false;
+void QueryManager::executeBatchAndStoreResults(
+    std::span<const QueryEntry> batch) {
+  std::vector<std::unique_ptr<Query>> owners;
+  std::vector<Query *> queries;
+  owners.reserve(batch.size());
+  queries.reserve(batch.size());
+  for (const auto &entry : batch) {
+    owners.emplace_back(entry.query_ptr);
+    queries.push_back(entry.query_ptr);
+  }
 
+  const EpochManager::Guard guard;
+  const Tracer::Span span(spanName(*queries.front()),
+                          queries.front()->targetTableRef());
+  std::vector<QueryResult::Ptr> results;
+  const auto started = std::chrono::steady_clock::now();
   try {
-    const QueryResult::Ptr result = query_ptr->execute();
-    result_str = formatQueryResult(result);
+    results = queries.front()->executeBatch(queries);
   } catch (const std::exception &exc) {
-    if (isWaitQueryException(exc)) {
-      is_wait_query = true;
-    } else {
-      result_str = formatErrorMessage(exc);
+    for (const auto &entry : batch) {
+      addImmediateResult(entry.query_id, formatErrorMessage(exc));
+    }
+    return;
+  }
+  const auto finished = std::chrono::steady_clock::now();
+  auto &stats = QueryStats::getInstance();
+  for (size_t i = 0; i < batch.size(); ++i) {
+    stats.record(queries[i]->keyword(), queries[i]->targetTableRef(),
+                 batch[i].submitted, started, finished);
+  }
+  for (size_t i = 0; i < batch.size(); ++i) {
+    try {
+      storeResult(batch[i].query_id, *queries[i], results[i]);
+    } catch (const std::exception &exc) {
+      addImmediateResult(batch[i].query_id, formatErrorMessage(exc));
     }
   }
+}
 
-  // Only store result and increment count if it's not a WaitQuery
-  if (!is_wait_query) {
-    output_pool.addResult(query_id, result_str);
-    completed_query_count.fetch_add(1);
+void QueryManager::storeResult(size_t query_id, const Query &query,
+                               const QueryResult::Ptr &result) {
+  const bool is_logged =
+      !query.statementRef().empty() && result != nullptr && result->success();
+  ResultBuffer::Ptr result_buffer = formatQueryResult(result);
+
+  if (is_logged) [[unlikely]] {
+    // The result is released once the query is durable
+    WriteAheadLog::getInstance().append(
+        query.statementRef(),
+        [this, query_id, buffer = std::move(result_buffer)]() mutable {
+          addImmediateResult(query_id, std::move(buffer));
+        });
+    return;
   }
+  addImmediateResult(query_id, std::move(result_buffer));
 }
 
 bool QueryManager::isComplete() const {
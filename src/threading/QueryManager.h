@@ -2,16 +2,20 @@
 #define PROJECT_QUERY_MANAGER_H
 
 #include <atomic>
+#include <chrono>
 #include <deque>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <semaphore>
+#include <span>
 #include <string>
 #include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "../utils/ResultBuffer.h"
+
 class Query;
 class QueryResult;
 class OutputPool;
@@ -32,6 +36,12 @@ class OutputPool;
  * Result ordering: OutputPool maintains ordered map by query_id
  * Async submission: Main thread doesn't block on query execution
  * No print thread: OutputPool outputs all results at the end
+ * Snapshot reads: a read with a writer queued behind it is handed to the
+ * table's read thread with a snapshot of the table (see Query::readsSnapshot),
+ * so the writers after it do not wait for it
+ * Batches: a run of queued queries that batch together (INSERTs, or reads
+ * sharing one scan) is taken off the table's queue at once and run by
+ * Query::executeBatch
  */
 class QueryManager {
 private:
@@ -39,6 +49,8 @@ private:
   struct QueryEntry {
     size_t query_id;   // NOLINT
     Query *query_ptr;  // NOLINT
+    // When the query was submitted (see QueryStats)
+    std::chrono::steady_clock::time_point submitted;  // NOLINT
   };
 
   // Map: table_name -> queue of (query_id, query_ptr)
@@ -48,7 +60,20 @@ private:
   std::unordered_map<std::string, std::unique_ptr<std::counting_semaphore<>>>
       table_query_sem;
 
-  // Protects table_query_map and table_query_sem
+  // Map: table_name -> reads handed off by the table's thread, run in order
+  // on the table's read thread
+  std::unordered_map<std::string, std::deque<QueryEntry>> table_read_map;
+  std::unordered_map<std::string, std::unique_ptr<std::counting_semaphore<>>>
+      table_read_sem;
+  // Map: table_name -> reads handed off and not yet finished
+  std::unordered_map<std::string, size_t> table_read_pending;
+
+  // How many queued queries handOffRead looks through for a writer
+  static constexpr size_t kHandOffLookahead = 8;
+  // Most queries run as one batch (see Query::isBatchable)
+  static constexpr size_t kMaxBatch = 4096;
+
+  // Protects table_query_map, table_query_sem and the table_read_* maps
   mutable std::mutex table_map_mutex;
 
   std::vector<std::thread> table_threads;
@@ -58,6 +83,8 @@ private:
   std::atomic<size_t> query_counter{0};
   std::atomic<size_t> expected_query_count{0};
   std::atomic<size_t> completed_query_count{0};
+  // Queries queued or running on the table threads (see Query::isBarrier)
+  std::atomic<size_t> in_flight_count{0};
 
   // Reference to OutputPool (passed in constructor, not owned)
   OutputPool &output_pool;
@@ -66,11 +93,37 @@ private:
 
   void createTableStructures(const std::string &table_name);
   void releaseSemaphores();
+  void waitForIdle();
+  void leaveFlight();
   void joinThreads();
   std::counting_semaphore<> *
   getSemaphoreForTable(const std::string &table_name);
   std::optional<QueryEntry> dequeueQuery(const std::string &table_name);
+
+  /**
+   * Take the queries queued right behind a batchable one that can run in a
+   * batch with it off the table's queue
+   * @param batch The run, holding the dequeued query; the queries are added
+   */
+  void dequeueBatch(const std::string &table_name,
+                    std::vector<QueryEntry> &batch);
+
   void executeAndStoreResult(const QueryEntry &query_entry);
+  void executeBatchAndStoreResults(std::span<const QueryEntry> batch);
+
+  /**
+   * Publish a query's result, once it is durable if the query is logged
+   */
+  void storeResult(size_t query_id, const Query &query,
+                   const std::unique_ptr<QueryResult> &result);
+
+  /**
+   * Hand a read off to the table's read thread, pinned to a snapshot of the
+   * table, if a writer waits behind it
+   * @return true if the read was handed off
+   */
+  bool handOffRead(const std::string &table_name,
+                   const QueryEntry &query_entry);
 
   /**
    * Execute queries for a specific table
@@ -79,6 +132,13 @@ private:
   static void executeQueryForTable(QueryManager *manager,
                                    const std::string &table_name);
 
+  /**
+   * Execute the reads handed off by a table's thread
+   * Runs in a per-table read thread, created on the first hand-off
+   */
+  static void executeReadsForTable(QueryManager *manager,
+                                   const std::string &table_name);
+
   /**
    * Print results in order
    * Runs in a dedicated print thread
@@ -109,6 +169,11 @@ public:
    */
   void setSingleThreaded(bool enable) { single_threaded_mode = enable; }
 
+  /**
+   * Check whether queries run on the submitting thread, in submission order
+   */
+  [[nodiscard]] bool isSingleThreaded() const { return single_threaded_mode; }
+
   /**
    * Submit a query to the appropriate table queue
    * Creates table'st execution thread if needed
@@ -123,8 +188,10 @@ public:
   /**
    * Immediately publish a query result without scheduling execution.
    * Used for instant queries executed on the caller thread (e.g., LISTEN).
+   * @param query_id Unique identifier for the query
+   * @param result The printed result, or nullptr if it prints nothing
    */
-  void addImmediateResult(size_t query_id, const std::string &result);
+  void addImmediateResult(size_t query_id, ResultBuffer::Ptr result);
 
   /**
    * Set the expected number of queries (to know when all are done)
@@ -0,0 +1,77 @@
+#include "Reclaimer.h"
+
+#include <sys/resource.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+Reclaimer::~Reclaimer() {
+  {
+    const std::scoped_lock lock(queueMutex);
+    stopping = true;
+  }
+  queueReady.notify_one();
+  if (worker.joinable()) {
+    worker.join();
+  }
+}
+
+void Reclaimer::dispose(std::vector<Garbage> garbage) {
+  if (garbage.empty()) [[unlikely]] {
+    return;
+  }
+  uint64_t bytes = 0;
+  for (const auto &item : garbage) {
+    bytes += item.bytes;
+  }
+  if (pending.load(std::memory_order_relaxed) + bytes > kMaxPendingBytes)
+      [[unlikely]] {
+    inlineCount.fetch_add(1, std::memory_order_relaxed);
+    for (const auto &item : garbage) {
+      destroy(item);
+    }
+    return;
+  }
+
+  {
+    const std::scoped_lock lock(queueMutex);
+    if (!worker.joinable()) [[unlikely]] {
+      worker = std::thread(&Reclaimer::run, this);
+    }
+    pending.fetch_add(bytes, std::memory_order_relaxed);
+    queue.insert(queue.end(), garbage.begin(), garbage.end());
+  }
+  queueReady.notify_one();
+}
+
+void Reclaimer::destroy(const Garbage &item) {
+  item.destroy(item.object);
+  freed.fetch_add(item.bytes, std::memory_order_relaxed);
+  freedCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Reclaimer::run() {
+  // On Linux the niceness belongs to the calling thread only
+  (void)setpriority(PRIO_PROCESS, 0, kNiceness);
+  std::unique_lock lock(queueMutex);
+  while (true) {
+    queueReady.wait(lock, [this] { return stopping || !queue.empty(); });
+    // Free what is left even when stopping
+    while (!queue.empty()) {
+      const Garbage item = queue.front();
+      queue.pop_front();
+      lock.unlock();
+      destroy(item);
+      pending.fetch_sub(item.bytes, std::memory_order_relaxed);
+      lock.lock();
+    }
+    if (stopping) {
+      return;
+    }
+  }
+}
@@ -0,0 +1,123 @@
+#ifndef PROJECT_RECLAIMER_H
+#define PROJECT_RECLAIMER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * Reclaimer: frees large storage on a background, low-priority thread
+ *
+ * Destroying a dropped or truncated table runs one destructor and free per
+ * row, per field vector, per key and per key index node, which takes seconds
+ * for tens of millions of rows. Callers detach the storage in O(1) and hand it
+ * over here (EpochManager does once no thread can read it any more), so the
+ * query that let it go, and its table queue, do not wait for it.
+ *
+ * Memory-pressure back-off: once more than kMaxPendingBytes wait to be freed,
+ * the background thread is not keeping up, so the caller frees what it hands
+ * over itself instead of queueing it.
+ */
+class Reclaimer {
+public:
+  /** Storage to free: the object, its deleter and its estimated size */
+  struct Garbage {
+    const void *object;
+    void (*destroy)(const void *);
+    size_t bytes;
+  };
+
+  static constexpr uint64_t kMaxPendingBytes = uint64_t{1} << 30U;
+  /** Niceness of the background thread */
+  static constexpr int kNiceness = 19;
+
+  [[nodiscard]] static Reclaimer &getInstance() {
+    static Reclaimer instance;
+    return instance;
+  }
+
+  Reclaimer(const Reclaimer &) = delete;
+  Reclaimer &operator=(const Reclaimer &) = delete;
+  Reclaimer(Reclaimer &&) = delete;
+  Reclaimer &operator=(Reclaimer &&) = delete;
+  ~Reclaimer();
+
+  /**
+   * Wrap an object to be freed
+   * @param object The object
+   * @param bytes Estimated size of the object and what it owns
+   */
+  template <class Type>
+  [[nodiscard]] static Garbage wrap(std::unique_ptr<Type> object,
+                                    size_t bytes) {
+    return {object.release(),
+            [](const void *pointer) {
+              delete static_cast<const Type *>(pointer);
+            },
+            bytes};
+  }
+
+  /**
+   * Free storage in the background, or right away under memory pressure
+   * @param garbage The storage, no longer reachable by any thread
+   */
+  void dispose(std::vector<Garbage> garbage);
+
+  /**
+   * Free an object in the background, or right away under memory pressure
+   * @param object The object, no longer reachable by any thread
+   * @param bytes Estimated size of the object and what it owns
+   */
+  template <class Type>
+  void dispose(std::unique_ptr<Type> object, size_t bytes) {
+    std::vector<Garbage> garbage;
+    garbage.push_back(wrap(std::move(object), bytes));
+    dispose(std::move(garbage));
+  }
+
+  /** Get the estimated number of bytes freed so far */
+  [[nodiscard]] uint64_t freedBytes() const {
+    return freed.load(std::memory_order_relaxed);
+  }
+
+  /** Get the number of objects freed so far */
+  [[nodiscard]] uint64_t freedObjects() const {
+    return freedCount.load(std::memory_order_relaxed);
+  }
+
+  /** Get the estimated number of bytes waiting to be freed */
+  [[nodiscard]] uint64_t pendingBytes() const {
+    return pending.load(std::memory_order_relaxed);
+  }
+
+  /** Get the number of hand-overs freed by the caller under pressure */
+  [[nodiscard]] uint64_t inlineFrees() const {
+    return inlineCount.load(std::memory_order_relaxed);
+  }
+
+private:
+  Reclaimer() = default;
+
+  std::mutex queueMutex;
+  std::condition_variable queueReady;
+  std::deque<Garbage> queue;
+  bool stopping = false;
+  std::thread worker;
+
+  std::atomic<uint64_t> pending{0};
+  std::atomic<uint64_t> freed{0};
+  std::atomic<uint64_t> freedCount{0};
+  std::atomic<uint64_t> inlineCount{0};
+
+  void destroy(const Garbage &item);
+  void run();
+};
+
+#endif  // PROJECT_RECLAIMER_H
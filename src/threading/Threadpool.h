@@ -14,6 +14,8 @@
 #include <utility>
 #include <vector>
 
+#include "../utils/Tracer.h"
+
 /**
  * A simple fixed-size thread pool singleton for executing submitted tasks.
  *
@@ -73,6 +75,7 @@ private:
    * queue is empty.
    */
   void thread_manager() {
+    Tracer::nameThread("pool");
     while (!done.load()) [[likely]] {
       std::function<void()> task;
       {
@@ -89,7 +92,10 @@ private:
       }
 
       idleThreadNum--;
-      task();
+      {
+        const Tracer::Span span("Task");
+        task();
+      }
       idleThreadNum++;
     }
   }
@@ -1,21 +1,27 @@
 #include "FileStackManager.h"
 
 #include <cstddef>
-#include <fstream>
+#include <istream>
 #include <memory>
 #include <stdexcept>
 #include <string>
 #include <utility>
 
+#include "ReadAhead.h"
+
 void FileStackManager::pushFile(const std::string &filename) {
-  auto file = std::make_unique<std::ifstream>(filename);
-  if (!file->is_open()) {
+  auto file = ReadAhead::getInstance().open(filename);
+  if (file == nullptr) {
     throw std::runtime_error("Cannot open file: " + filename);
   }
   file_stack.push(std::move(file));
   file_path_stack.push(filename);
 }
 
+void FileStackManager::prefetchFile(const std::string &filename) const {
+  ReadAhead::getInstance().prefetch(filename);
+}
+
 void FileStackManager::popFile() {
   if (!file_stack.empty()) {
     file_stack.pop();
@@ -23,7 +29,7 @@ void FileStackManager::popFile() {
   }
 }
 
-std::ifstream *FileStackManager::getCurrentStream() {
+std::istream *FileStackManager::getCurrentStream() {
   if (file_stack.empty()) {
     return nullptr;
   }
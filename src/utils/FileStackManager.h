@@ -1,7 +1,7 @@
 #ifndef LEMONDB_FILESTACKMANAGER_H
 #define LEMONDB_FILESTACKMANAGER_H
 
-#include <fstream>
+#include <istream>
 #include <memory>
 #include <stack>
 #include <string>
@@ -12,14 +12,16 @@
  * Supports nested includes or LISTEN-like functionality where one file
  * can push another file to be processed, then resume the previous one
  * after completion. Paths are stored alongside streams to allow relative
- * path resolution for subsequently pushed files.
+ * path resolution for subsequently pushed files. Files are opened through
+ * ReadAhead, so they are read in the background and can be prefetched as
+ * soon as they are known to be needed.
  */
 class FileStackManager {
 private:
   /**
    * Stack of owning pointers to open input file streams (top is current).
    */
-  std::stack<std::unique_ptr<std::ifstream>> file_stack;
+  std::stack<std::unique_ptr<std::istream>> file_stack;
   /**
    * Stack of file paths corresponding to each stream (kept in sync with
    * file_stack).
@@ -41,6 +43,12 @@ public:
    */
   void pushFile(const std::string &filename);
 
+  /**
+   * Start reading a file that will be pushed later.
+   * @param filename File name exactly as it will be passed to pushFile.
+   */
+  void prefetchFile(const std::string &filename) const;
+
   /**
    * Pop (close) the current file stream and restore the previous one.
    * Safe to call when stack has exactly one element (result becomes empty).
@@ -50,9 +58,9 @@ public:
 
   /**
    * Get pointer to the current (top) input stream.
-   * @return Pointer to std::ifstream or nullptr if empty.
+   * @return Pointer to the stream or nullptr if empty.
    */
-  std::ifstream *getCurrentStream();
+  std::istream *getCurrentStream();
 
   /**
    * Get the path of the current (top) file.
@@ -71,7 +79,7 @@ public:
    * If there is a current file and filename is relative, it is joined
    * with the current file's directory. Otherwise returns filename unchanged.
    * @param filename Raw file name provided by caller (relative or absolute).
-   * @return Resolved path string suitable for std::ifstream opening.
+   * @return Resolved path string suitable for opening.
    */
   [[nodiscard]] std::string resolvePath(const std::string &filename) const;
 };
@@ -4,12 +4,15 @@
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <thread>
 
 #include "../threading/OutputPool.h"
 #include "../threading/QueryManager.h"
 #include "MainUtils.h"
 #include "OutputConfig.h"
+#include "OutputSink.h"
+#include "Tracer.h"
 
 namespace MainIOHelpers {
 std::istream *initializeInputStream(const Args &parsedArgs,
@@ -26,6 +29,25 @@ std::istream *initializeInputStream(const Args &parsedArgs,
   return &std::cin;
 }
 
+std::unique_ptr<OutputSink> initializeOutputSink(const Args &parsedArgs) {
+  std::unique_ptr<OutputSink> sink;
+  if (!parsedArgs.output.empty()) [[unlikely]] {
+    sink = OutputSink::openFile(parsedArgs.output);
+    if (sink == nullptr) [[unlikely]] {
+      std::cerr << "lemondb: error: " << parsedArgs.output
+                << ": cannot open for writing" << '\n';
+      std::exit(-1);
+    }
+  } else {
+    sink = std::make_unique<OutputSink>();
+  }
+  if (parsedArgs.outputBuffer >= 0) [[unlikely]] {
+    sink->setFlushPolicy(static_cast<size_t>(parsedArgs.outputBuffer),
+                         OutputSink::kDefaultFlushLatency);
+  }
+  return sink;
+}
+
 void validateProductionMode(const Args &parsedArgs) {
 #ifdef NDEBUG
   // In production mode, listen argument must be defined
@@ -44,6 +66,25 @@ void validateProductionMode(const Args &parsedArgs) {
 #endif
 }
 
+void initializeTrace(const Args &parsedArgs) {
+  if (parsedArgs.trace.empty()) [[likely]] {
+    return;
+  }
+  if (!Tracer::getInstance().enable(parsedArgs.trace)) [[unlikely]] {
+    std::cerr << "lemondb: error: " << parsedArgs.trace
+              << ": cannot open for writing" << '\n';
+    std::exit(-1);
+  }
+  Tracer::nameThread("main");
+}
+
+void writeTrace(const Args &parsedArgs) {
+  if (!Tracer::getInstance().write()) [[unlikely]] {
+    std::cerr << "lemondb: warning: " << parsedArgs.trace
+              << ": trace not fully written" << '\n';
+  }
+}
+
 void flushOutputLoop(OutputPool &output_pool, const QueryManager &query_manager,
                      const OutputConfig &output_config) {
   while (true) {
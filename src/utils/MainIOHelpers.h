@@ -3,15 +3,20 @@
 
 #include <fstream>
 #include <istream>
+#include <memory>
 
 #include "../threading/OutputPool.h"
 #include "../threading/QueryManager.h"
 #include "../utils/MainUtils.h"
 #include "../utils/OutputConfig.h"
+#include "../utils/OutputSink.h"
 
 namespace MainIOHelpers {
 std::istream *initializeInputStream(const Args &parsedArgs, std::ifstream &fin);
+std::unique_ptr<OutputSink> initializeOutputSink(const Args &parsedArgs);
 void validateProductionMode(const Args &parsedArgs);
+void initializeTrace(const Args &parsedArgs);
+void writeTrace(const Args &parsedArgs);
 void flushOutputLoop(OutputPool &output_pool, const QueryManager &query_manager,
                      const OutputConfig &output_config);
 }  // namespace MainIOHelpers
@@ -1,7 +1,10 @@
 #include "MainQueryHelpers.h"
 
 #include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <cstdlib>
+#include <cstdint>
 #include <cstdio>
 #include <deque>
 #include <exception>
@@ -10,35 +13,27 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <utility>
 
+#include "../db/Checkpointer.h"
 #include "../db/Database.h"
 #include "../db/QueryBase.h"
+#include "../db/TableCodec.h"
+#include "../db/WriteAheadLog.h"
 #include "../query/QueryParser.h"
 #include "../query/management/CopyTableQuery.h"
 #include "../query/management/WaitQuery.h"
 #include "../query/utils/ListenQuery.h"
+#include "../threading/ParsePipeline.h"
 #include "../threading/QueryManager.h"
 #include "MainUtils.h"
+#include "StatementReader.h"
 
 namespace MainQueryHelpers {
-std::string extractQueryString(std::istream &input_stream) {
-  std::string buf;
-  while (true) {
-    const int character = input_stream.get();
-    if (character == ';') [[likely]] {
-      return buf;
-    }
-    if (character == EOF) [[unlikely]] {
-      throw std::ios_base::failure("End of input");
-    }
-    buf.push_back(static_cast<char>(character));
-  }
-}
-
-std::string trimLeadingWhitespace(const std::string &str) {
+std::string_view trimLeadingWhitespace(std::string_view str) {
   const size_t start = str.find_first_not_of(" \t\n\r");
-  if (start == std::string::npos) {
+  if (start == std::string_view::npos) {
     return str;
   }
   return str.substr(start);
@@ -46,7 +41,7 @@ std::string trimLeadingWhitespace(const std::string &str) {
 
 void handleListenQuery(ListenQuery *listen_query, QueryManager &query_manager,
                        std::atomic<size_t> &g_query_counter,
-                       QueryParser &parser, Database &database,
+                       const QueryParser &parser, Database &database,
                        bool &should_break) {
   std::deque<std::unique_ptr<ListenQuery>> pending_listens;
 
@@ -64,9 +59,7 @@ void handleListenQuery(ListenQuery *listen_query, QueryManager &query_manager,
   if (result != nullptr) {
     const bool should_display = result->display();
     if (should_display) {
-      std::ostringstream result_stream;
-      result_stream << *result;
-      query_manager.addImmediateResult(listen_query_id, result_stream.str());
+      query_manager.addImmediateResult(listen_query_id, result->takeBuffer());
     }
   }
   // std::cerr << "[CONTROL] Returned from LISTEN file " <<
@@ -91,9 +84,7 @@ void handleListenQuery(ListenQuery *listen_query, QueryManager &query_manager,
     }
     auto next_result = next_listen->execute();
     if (next_result && next_result->display()) {
-      std::ostringstream oss;
-      oss << *next_result;
-      query_manager.addImmediateResult(next_id, oss.str());
+      query_manager.addImmediateResult(next_id, next_result->takeBuffer());
     }
 
     if (next_listen->hasEncounteredQuit()) {
@@ -104,27 +95,29 @@ void handleListenQuery(ListenQuery *listen_query, QueryManager &query_manager,
 }
 
 // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
-void handleCopyTable(QueryManager &query_manager, const std::string &trimmed,
+void handleCopyTable(QueryManager &query_manager, std::string_view trimmed,
                      const std::string &table_name,
                      CopyTableQuery *copy_query) {
-  if (copy_query != nullptr) {
+  // Run in order, the copy is done before the new table is used; a WaitQuery
+  // would block before it even started
+  if (copy_query != nullptr && !query_manager.isSingleThreaded()) {
     auto wait_sem = copy_query->getWaitSemaphore();
     constexpr size_t copytable_prefix_len = 9;
-    auto new_table_name =
+    std::string_view new_table_name =
         trimmed.substr(copytable_prefix_len);  // Skip "COPYTABLE"
     // Extract new table name - it's after first whitespace(s) and the source
     // table
     size_t space_pos = new_table_name.find_first_not_of(" \t");
-    if (space_pos != std::string::npos) {
+    if (space_pos != std::string_view::npos) {
       new_table_name = new_table_name.substr(space_pos);
       space_pos = new_table_name.find_first_of(" \t");
-      if (space_pos != std::string::npos) {
+      if (space_pos != std::string_view::npos) {
         new_table_name = new_table_name.substr(space_pos);
         space_pos = new_table_name.find_first_not_of(" \t;");
-        if (space_pos != std::string::npos) {
+        if (space_pos != std::string_view::npos) {
           new_table_name = new_table_name.substr(space_pos);
           space_pos = new_table_name.find_first_of(" \t;");
-          if (space_pos != std::string::npos) {
+          if (space_pos != std::string_view::npos) {
             new_table_name = new_table_name.substr(0, space_pos);
           }
         }
@@ -136,23 +129,46 @@ void handleCopyTable(QueryManager &query_manager, const std::string &trimmed,
     const size_t wait_query_id =
         0;  // Special ID for WaitQuery - not counted as user query
     auto wait_query = std::make_unique<WaitQuery>(table_name, wait_sem);
-    query_manager.addQuery(wait_query_id, new_table_name, wait_query.release());
+    query_manager.addQuery(wait_query_id, std::string(new_table_name),
+                           wait_query.release());
   }
 }
 
 void processQueries(std::istream &input_stream, Database &database,
-                    QueryParser &parser, QueryManager &query_manager,
+                    const QueryParser &parser, QueryManager &query_manager,
                     std::atomic<size_t> &g_query_counter) {
-  while (input_stream && !database.isEnd()) [[likely]] {
+  StatementReader reader(input_stream);
+  ParsePipeline pipeline(parser, [&query_manager,
+                                   &g_query_counter](Query::Ptr &&query) {
+    const std::string table_name = query->targetTableRef();
+    const size_t query_id = g_query_counter.fetch_add(1) + 1;
+    query_manager.addQuery(query_id, table_name, query.release());
+  });
+  std::string_view queryStr;
+  while (!database.isEnd()) [[likely]] {
     try {
-      const std::string queryStr = extractQueryString(input_stream);
+      // Do not leave parsed queries waiting while blocked on input
+      if (!reader.canReadWithoutWaiting()) {
+        pipeline.drain();
+      }
+      if (!reader.next(queryStr)) [[unlikely]] {
+        break;
+      }
 
       // std::cerr << "[CONTROL] Read query: " << queryStr << '\n';
 
-      Query::Ptr query = parser.parseQuery(queryStr);
+      const std::string_view trimmed = trimLeadingWhitespace(queryStr);
+      if (!ParsePipeline::needsOrdering(trimmed)) [[likely]] {
+        pipeline.submit(queryStr);
+        continue;
+      }
+      pipeline.drain();
 
-      // Use a case-insensitive check for "QUIT"
-      const std::string trimmed = trimLeadingWhitespace(queryStr);
+      auto parsed = parser.parse(queryStr);
+      if (!parsed.ok()) [[unlikely]] {
+        continue;
+      }
+      Query::Ptr query = std::move(parsed.query);
 
       if (query->isInstant() && trimmed.starts_with("QUIT")) {
         // Don't submit QUIT query - just break the loop
@@ -197,12 +213,19 @@ void processQueries(std::istream &input_stream, Database &database,
       (void)exc;
     }
   }
+  try {
+    pipeline.drain();
+  } catch (const std::exception &exc) {
+    // std::cerr << "[CONTROL] Query processing error: " << exc.what() <<
+    // '\n';
+    (void)exc;
+  }
 }
 
-std::optional<size_t> setupListenMode(const Args &args, QueryParser &parser,
-                                      Database &database,
-                                      QueryManager &query_manager,
-                                      std::atomic<size_t> &g_query_counter) {
+std::optional<size_t>
+setupListenMode(const Args &args, const QueryParser &parser,
+                Database &database, QueryManager &query_manager,
+                std::atomic<size_t> &g_query_counter) {
   if (args.listen.empty()) {
     return std::nullopt;
   }
@@ -234,10 +257,8 @@ std::optional<size_t> setupListenMode(const Args &args, QueryParser &parser,
       if (listen_result != nullptr) {
         const bool should_display = listen_result->display();
         if (should_display) {
-          std::ostringstream result_stream;
-          result_stream << *listen_result;
           query_manager.addImmediateResult(listen_query_id,
-                                           result_stream.str());
+                                           listen_result->takeBuffer());
         }
       }
 
@@ -254,6 +275,74 @@ std::optional<size_t> setupListenMode(const Args &args, QueryParser &parser,
   return total_scheduled;
 }
 
+uint64_t initializeCheckpoint(const Args &args) {
+  if (args.checkpoint.empty()) [[likely]] {
+    return 0;
+  }
+  // Checkpointed tables come first; the log then replays what followed
+  const auto sequence = Checkpointer::getInstance().open(args.checkpoint);
+  if (!sequence.has_value()) [[unlikely]] {
+    std::cerr << "lemondb: error: " << args.checkpoint
+              << ": cannot open checkpoint file" << '\n';
+    std::exit(-1);
+  }
+  return *sequence;
+}
+
+void initializeWriteAheadLog(const Args &args, const QueryParser &parser,
+                             uint64_t firstSequence) {
+  if (args.wal.empty()) [[likely]] {
+    return;
+  }
+  auto &wal = WriteAheadLog::getInstance();
+  auto policy = WriteAheadLog::SyncPolicy::Commit;
+  if (!args.walSync.empty()) {
+    const auto parsed = WriteAheadLog::parsePolicy(args.walSync);
+    if (!parsed.has_value()) [[unlikely]] {
+      std::cerr << "lemondb: error: unknown --wal-sync policy '"
+                << args.walSync << "'\n";
+      std::exit(-1);
+    }
+    policy = *parsed;
+  }
+  wal.setSyncPolicy(policy,
+                    args.walInterval >= 0
+                        ? std::chrono::milliseconds(args.walInterval)
+                        : WriteAheadLog::kDefaultSyncInterval);
+
+  // Replayed queries rebuild the tables silently, before any input is read
+  const auto replayed = wal.open(
+      args.wal,
+      [&parser, &args](std::string_view text) {
+        if (TableCodec::isCompressed(text)) [[unlikely]] {
+          // The rows of a LOAD
+          std::istringstream rows(std::string(text), std::ios::binary);
+          try {
+            Database::getInstance().registerTable(
+                TableCodec::decode(rows, args.wal));
+          } catch (const std::exception & /*ignored*/) {
+            // Skipped like a statement that fails
+          }
+          return;
+        }
+        auto parsed = parser.parse(text);
+        if (!parsed.ok()) [[unlikely]] {
+          return;
+        }
+        try {
+          (void)parsed.query->execute();
+        } catch (const std::exception & /*ignored*/) {
+          // Failed the same way when it was logged
+        }
+      },
+      firstSequence);
+  if (!replayed.has_value()) [[unlikely]] {
+    std::cerr << "lemondb: error: " << args.wal
+              << ": cannot open write-ahead log" << '\n';
+    std::exit(-1);
+  }
+}
+
 size_t
 determineExpectedQueryCount(const std::optional<size_t> &listen_scheduled,
                             const std::atomic<size_t> &g_query_counter) {
@@ -3,9 +3,11 @@
 
 #include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <istream>
 #include <optional>
 #include <string>
+#include <string_view>
 
 #include "../db/Database.h"
 #include "../query/QueryParser.h"
@@ -15,21 +17,23 @@
 #include "../utils/MainUtils.h"
 
 namespace MainQueryHelpers {
-std::string extractQueryString(std::istream &input_stream);
-std::string trimLeadingWhitespace(const std::string &str);
+std::string_view trimLeadingWhitespace(std::string_view str);
 void handleListenQuery(ListenQuery *listen_query, QueryManager &query_manager,
                        std::atomic<size_t> &g_query_counter,
-                       QueryParser &parser, Database &database,
+                       const QueryParser &parser, Database &database,
                        bool &should_break);
-void handleCopyTable(QueryManager &query_manager, const std::string &trimmed,
+void handleCopyTable(QueryManager &query_manager, std::string_view trimmed,
                      const std::string &table_name, CopyTableQuery *copy_query);
 void processQueries(std::istream &input_stream, Database &database,
-                    QueryParser &parser, QueryManager &query_manager,
+                    const QueryParser &parser, QueryManager &query_manager,
                     std::atomic<size_t> &g_query_counter);
-std::optional<size_t> setupListenMode(const Args &args, QueryParser &parser,
-                                      Database &database,
-                                      QueryManager &query_manager,
-                                      std::atomic<size_t> &g_query_counter);
+std::optional<size_t>
+setupListenMode(const Args &args, const QueryParser &parser,
+                Database &database, QueryManager &query_manager,
+                std::atomic<size_t> &g_query_counter);
+std::uint64_t initializeCheckpoint(const Args &args);
+void initializeWriteAheadLog(const Args &args, const QueryParser &parser,
+                             std::uint64_t firstSequence);
 size_t
 determineExpectedQueryCount(const std::optional<size_t> &listen_scheduled,
                             const std::atomic<size_t> &g_query_counter);
@@ -10,17 +10,31 @@
 #include <string>
 #include <string_view>
 
-#include "../query/QueryBuilders.h"
-#include "../query/QueryParser.h"
-
 namespace MainUtils {
 void parseArgs(int argc, char **argv, Args &args) {
   // Manual argument parser supporting both long and short forms
   // --listen=<file> or --listen <file> or -l <file>
   // --threads=<num> or --threads <num> or -t <num>
+  // --output=<file> or --output <file> or -o <file>
+  // --output-buffer=<bytes> or --output-buffer <bytes>
+  // --listen-mmap
+  // --wal=<file> or --wal <file>
+  // --wal-sync=<commit|interval|off> or --wal-sync <policy>
+  // --wal-interval=<ms> or --wal-interval <ms>
+  // --checkpoint=<file> or --checkpoint <file>
+  // --result-cache=<bytes> or --result-cache <bytes>
+  // --trace=<file> or --trace <file>
 
-  constexpr size_t listen_prefix_len = 9;    // Length of "--listen="
-  constexpr size_t threads_prefix_len = 10;  // Length of "--threads="
+  constexpr size_t listen_prefix_len = 9;          // Length of "--listen="
+  constexpr size_t threads_prefix_len = 10;        // Length of "--threads="
+  constexpr size_t output_prefix_len = 9;          // Length of "--output="
+  constexpr size_t output_buffer_prefix_len = 16;  // "--output-buffer="
+  constexpr size_t wal_prefix_len = 6;             // Length of "--wal="
+  constexpr size_t wal_sync_prefix_len = 11;       // "--wal-sync="
+  constexpr size_t wal_interval_prefix_len = 15;   // "--wal-interval="
+  constexpr size_t checkpoint_prefix_len = 13;     // "--checkpoint="
+  constexpr size_t result_cache_prefix_len = 15;   // "--result-cache="
+  constexpr size_t trace_prefix_len = 8;           // Length of "--trace="
   constexpr int decimal_base = 10;
 
   for (int i = 1; i < argc; ++i) {
@@ -38,6 +52,11 @@ void parseArgs(int argc, char **argv, Args &args) {
       std::exit(-1);
     };
 
+    if (arg == "--listen-mmap") {
+      args.listenMmap = true;
+      continue;
+    }
+
     // Handle --listen=<value> or --listen <value>
     if (arg.starts_with("--listen=") || arg == "--listen" || arg == "-l") {
       if (arg.starts_with("--listen=")) {
@@ -60,16 +79,96 @@ void parseArgs(int argc, char **argv, Args &args) {
       continue;
     }
 
+    // Handle --output-buffer=<value> or --output-buffer <value>
+    if (arg.starts_with("--output-buffer=") || arg == "--output-buffer") {
+      std::string value;
+      if (arg.starts_with("--output-buffer=")) {
+        value = arg.substr(output_buffer_prefix_len);
+      } else {
+        value = getNextArg();
+      }
+      args.outputBuffer = std::strtol(value.c_str(), nullptr, decimal_base);
+      continue;
+    }
+
+    // Handle --output=<value> or --output <value>
+    if (arg.starts_with("--output=") || arg == "--output" || arg == "-o") {
+      if (arg.starts_with("--output=")) {
+        args.output = arg.substr(output_prefix_len);
+      } else {
+        args.output = getNextArg();
+      }
+      continue;
+    }
+
+    // Handle --wal-sync=<value> or --wal-sync <value>
+    if (arg.starts_with("--wal-sync=") || arg == "--wal-sync") {
+      if (arg.starts_with("--wal-sync=")) {
+        args.walSync = arg.substr(wal_sync_prefix_len);
+      } else {
+        args.walSync = getNextArg();
+      }
+      continue;
+    }
+
+    // Handle --wal-interval=<value> or --wal-interval <value>
+    if (arg.starts_with("--wal-interval=") || arg == "--wal-interval") {
+      std::string value;
+      if (arg.starts_with("--wal-interval=")) {
+        value = arg.substr(wal_interval_prefix_len);
+      } else {
+        value = getNextArg();
+      }
+      args.walInterval = std::strtol(value.c_str(), nullptr, decimal_base);
+      continue;
+    }
+
+    // Handle --wal=<value> or --wal <value>
+    if (arg.starts_with("--wal=") || arg == "--wal") {
+      if (arg.starts_with("--wal=")) {
+        args.wal = arg.substr(wal_prefix_len);
+      } else {
+        args.wal = getNextArg();
+      }
+      continue;
+    }
+
+    // Handle --checkpoint=<value> or --checkpoint <value>
+    if (arg.starts_with("--checkpoint=") || arg == "--checkpoint") {
+      if (arg.starts_with("--checkpoint=")) {
+        args.checkpoint = arg.substr(checkpoint_prefix_len);
+      } else {
+        args.checkpoint = getNextArg();
+      }
+      continue;
+    }
+
+    // Handle --result-cache=<value> or --result-cache <value>
+    if (arg.starts_with("--result-cache=") || arg == "--result-cache") {
+      std::string value;
+      if (arg.starts_with("--result-cache=")) {
+        value = arg.substr(result_cache_prefix_len);
+      } else {
+        value = getNextArg();
+      }
+      args.resultCache = std::strtol(value.c_str(), nullptr, decimal_base);
+      continue;
+    }
+
+    // Handle --trace=<value> or --trace <value>
+    if (arg.starts_with("--trace=") || arg == "--trace") {
+      if (arg.starts_with("--trace=")) {
+        args.trace = arg.substr(trace_prefix_len);
+      } else {
+        args.trace = getNextArg();
+      }
+      continue;
+    }
+
     (void)arg;
   }
 }
 
-void setupParser(QueryParser &parser) {
-  parser.registerQueryBuilder(std::make_unique<DebugQueryBuilder>());
-  parser.registerQueryBuilder(std::make_unique<ManageTableQueryBuilder>());
-  parser.registerQueryBuilder(std::make_unique<ComplexQueryBuilder>());
-}
-
 bool checkSmallWorkload(const std::string &filepath) {
   constexpr size_t SMALL_WORKLOAD_THRESHOLD = 100;
 
@@ -4,14 +4,25 @@
 #include <cstdint>
 #include <string>
 
-#include "../query/QueryParser.h"
-
 /**
  * Command line argument bundle for main program.
  *
  * Fields:
  *  - listen: Path or identifier for a LISTEN source (empty if not specified).
  *  - threads: Requested thread count override (0 means use default / auto).
+ *  - output: File results are written to (empty for stdout).
+ *  - outputBuffer: Bytes of output gathered before a write (negative means
+ *    use the default).
+ *  - listenMmap: Map LISTEN files instead of reading them.
+ *  - wal: Write-ahead log file (empty disables logging).
+ *  - walSync: Sync policy of the write-ahead log (empty for the default).
+ *  - walInterval: Milliseconds between syncs with the "interval" policy
+ *    (negative means use the default).
+ *  - checkpoint: Checkpoint file (empty disables CHECKPOINT).
+ *  - resultCache: Memory cap of the read result cache in bytes (0 disables
+ *    it, negative means use the default).
+ *  - trace: File a trace-event timeline is written to at exit (empty
+ *    disables tracing).
  */
 struct Args {
   /** Path or identifier provided to LISTEN related option (may be empty). */
@@ -19,6 +30,24 @@ struct Args {
   /** Explicit thread count requested by user; 0 selects automatic hardware
    * concurrency. */
   std::int64_t threads = 0;
+  /** Result output file; empty writes to stdout. */
+  std::string output;
+  /** Output bytes gathered before a write; negative selects the default. */
+  std::int64_t outputBuffer = -1;
+  /** Map LISTEN files into memory instead of reading them ahead. */
+  bool listenMmap = false;
+  /** Write-ahead log file; empty disables logging. */
+  std::string wal;
+  /** Write-ahead log sync policy name; empty selects the default. */
+  std::string walSync;
+  /** Milliseconds between log syncs; negative selects the default. */
+  std::int64_t walInterval = -1;
+  /** Checkpoint file; empty disables checkpoints. */
+  std::string checkpoint;
+  /** Result cache bytes; 0 disables it, negative selects the default. */
+  std::int64_t resultCache = -1;
+  /** Trace-event timeline file; empty disables tracing. */
+  std::string trace;
 };
 
 namespace MainUtils {
@@ -32,13 +61,6 @@ namespace MainUtils {
  */
 void parseArgs(int argc, char **argv, Args &args);
 
-/**
- * Configure a QueryParser instance with standard builders / handlers
- * required for processing user queries.
- * @param parser QueryParser instance to initialize.
- */
-void setupParser(QueryParser &parser);
-
 /**
  * Check if the workload is small enough to run in single-threaded mode.
  * @param filepath Path to the listen file.
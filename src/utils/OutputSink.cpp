@@ -0,0 +1,119 @@
+#include "OutputSink.h"
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "ResultBuffer.h"
+#include "Tracer.h"
+
+OutputSink::OutputSink(int fd, bool ownsFd)
+    : fd(fd), ownsFd(ownsFd),
+      idLines(std::make_unique<std::array<std::array<char, kIdLineCapacity>,
+                                          kMaxBatch>>()) {
+  iovecs.reserve(kMaxIovecs);
+  held.reserve(kMaxBatch);
+}
+
+std::unique_ptr<OutputSink> OutputSink::openFile(const std::string &path) {
+  constexpr mode_t fileMode = 0644;
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+  const int file =
+      ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, fileMode);
+  if (file < 0) [[unlikely]] {
+    return nullptr;
+  }
+  return std::make_unique<OutputSink>(file, true);
+}
+
+OutputSink::~OutputSink() {
+  flush();
+  if (ownsFd) {
+    ::close(fd);
+  }
+}
+
+void OutputSink::setFlushPolicy(size_t bytes,
+                                std::chrono::milliseconds latency) {
+  flushBytes = bytes;
+  flushLatency = latency;
+}
+
+void OutputSink::write(size_t queryId, ResultBuffer::Ptr result) {
+  if (batched == 0) {
+    oldestPending = std::chrono::steady_clock::now();
+  }
+
+  auto &line = (*idLines)[batched++];
+  auto *const end =
+      std::to_chars(line.data(), line.data() + line.size() - 1, queryId).ptr;
+  *end = '\n';
+  const auto lineLength = static_cast<size_t>(end + 1 - line.data());
+  iovecs.push_back({line.data(), lineLength});
+  pendingBytes += lineLength;
+
+  if (result != nullptr && !result->empty()) {
+    const auto text = result->view();
+    // writev never writes through iov_base
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+    iovecs.push_back({const_cast<char *>(text.data()), text.size()});
+    pendingBytes += text.size();
+    held.push_back(std::move(result));
+  }
+
+  if (batched == kMaxBatch || pendingBytes >= flushBytes) {
+    writeBatch();
+  }
+}
+
+void OutputSink::flushIfDue() {
+  if (batched > 0 &&
+      std::chrono::steady_clock::now() - oldestPending >= flushLatency) {
+    writeBatch();
+  }
+}
+
+void OutputSink::flush() {
+  if (batched > 0) {
+    writeBatch();
+  }
+}
+
+void OutputSink::writeBatch() {
+  const Tracer::Span span("Output flush");
+  size_t index = 0;
+  while (!failed && index < iovecs.size()) {
+    const auto count = std::min(iovecs.size() - index, kMaxIovecs);
+    const ssize_t written =
+        ::writev(fd, &iovecs[index], static_cast<int>(count));
+    if (written < 0) [[unlikely]] {
+      // Like a failed std::cout, a broken sink drops further output
+      failed = errno != EINTR;
+      continue;
+    }
+    auto remaining = static_cast<size_t>(written);
+    while (index < iovecs.size() && remaining >= iovecs[index].iov_len) {
+      remaining -= iovecs[index].iov_len;
+      ++index;
+    }
+    if (remaining > 0) {
+      auto &partial = iovecs[index];
+      partial.iov_base = static_cast<char *>(partial.iov_base) + remaining;
+      partial.iov_len -= remaining;
+    }
+  }
+
+  iovecs.clear();
+  held.clear();
+  batched = 0;
+  pendingBytes = 0;
+}
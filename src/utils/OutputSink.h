@@ -0,0 +1,102 @@
+#ifndef PROJECT_OUTPUT_SINK_H
+#define PROJECT_OUTPUT_SINK_H
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ResultBuffer.h"
+
+/**
+ * OutputSink: batched writer for printed results
+ *
+ * Every result is written as its id line followed by its text. The sink
+ * keeps the result buffers alive and gathers them into an iovec batch, which
+ * is written with a single writev(2) once it holds flushBytes bytes, once its
+ * oldest entry is flushLatency old (checked by flushIfDue), or once the batch
+ * is full. No data is copied and iostreams are not involved.
+ *
+ * Not thread-safe: the owner serializes calls.
+ */
+class OutputSink {
+public:
+  static constexpr size_t kDefaultFlushBytes = size_t{256} << 10U;
+  static constexpr std::chrono::milliseconds kDefaultFlushLatency{50};
+
+  /**
+   * Construct a sink writing to an open file descriptor
+   * @param fd The descriptor, stdout by default
+   * @param ownsFd Whether the sink closes the descriptor
+   */
+  explicit OutputSink(int fd = STDOUT_FILENO, bool ownsFd = false);
+
+  /**
+   * Open (create or truncate) a file and construct a sink writing to it
+   * @param path The output file
+   * @return the sink, or nullptr if the file cannot be opened
+   */
+  [[nodiscard]] static std::unique_ptr<OutputSink>
+  openFile(const std::string &path);
+
+  OutputSink(const OutputSink &) = delete;
+  OutputSink &operator=(const OutputSink &) = delete;
+  OutputSink(OutputSink &&) = delete;
+  OutputSink &operator=(OutputSink &&) = delete;
+
+  /** Flushes what is pending and closes an owned descriptor */
+  ~OutputSink();
+
+  /**
+   * Set when pending output is written
+   * @param bytes Write once this many bytes are pending (0: every batch)
+   * @param latency Longest time output may stay pending
+   */
+  void setFlushPolicy(size_t bytes, std::chrono::milliseconds latency);
+
+  /**
+   * Queue a result for output
+   * @param queryId The id printed before the result
+   * @param result The printed result, or nullptr for just the id
+   */
+  void write(size_t queryId, ResultBuffer::Ptr result);
+
+  /**
+   * Write the pending output if the latency bound has been reached
+   */
+  void flushIfDue();
+
+  /**
+   * Write all pending output
+   */
+  void flush();
+
+private:
+  /** Linux IOV_MAX */
+  static constexpr size_t kMaxIovecs = 1024;
+  static constexpr size_t kMaxBatch = kMaxIovecs / 2;
+  static constexpr size_t kIdLineCapacity = 24;
+
+  int fd;
+  bool ownsFd;
+  bool failed = false;
+  size_t flushBytes = kDefaultFlushBytes;
+  std::chrono::milliseconds flushLatency = kDefaultFlushLatency;
+
+  std::vector<iovec> iovecs;
+  std::vector<ResultBuffer::Ptr> held;
+  std::unique_ptr<std::array<std::array<char, kIdLineCapacity>, kMaxBatch>>
+      idLines;
+  size_t batched = 0;
+  size_t pendingBytes = 0;
+  std::chrono::steady_clock::time_point oldestPending;
+
+  void writeBatch();
+};
+
+#endif  // PROJECT_OUTPUT_SINK_H
@@ -0,0 +1,59 @@
+#include "QueryProfile.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+thread_local QueryProfile *QueryProfile::active = nullptr;
+
+QueryProfile::Activation::Activation(QueryProfile &profile)
+    : previous(active) {
+  profile.stage = Stage::Scan;
+  profile.since = Clock::now();
+  active = &profile;
+}
+
+QueryProfile::Activation::~Activation() {
+  active->switchTo(Stage::Scan);
+  active = previous;
+}
+
+QueryProfile::Clock::duration QueryProfile::total() const {
+  Clock::duration sum{};
+  for (const auto time : stageTimes) {
+    sum += time;
+  }
+  return sum;
+}
+
+uint64_t QueryProfile::rowsScanned() const {
+  uint64_t rows = 0;
+  for (const auto &counters : shards) {
+    rows += counters.scanned.load(std::memory_order_relaxed);
+  }
+  return rows;
+}
+
+uint64_t QueryProfile::rowsMatched() const {
+  uint64_t rows = 0;
+  for (const auto &counters : shards) {
+    rows += counters.matched.load(std::memory_order_relaxed);
+  }
+  return rows;
+}
+
+QueryProfile::Stage QueryProfile::switchTo(Stage next) {
+  const auto now = Clock::now();
+  stageTimes[static_cast<size_t>(stage)] += now - since;
+  since = now;
+  const Stage running = stage;
+  stage = next;
+  return running;
+}
+
+size_t QueryProfile::shardIndex() {
+  static std::atomic<size_t> nextShard{0};
+  thread_local const size_t shard =
+      nextShard.fetch_add(1, std::memory_order_relaxed) % kShards;
+  return shard;
+}
@@ -0,0 +1,148 @@
+#ifndef PROJECT_QUERY_PROFILE_H
+#define PROJECT_QUERY_PROFILE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * QueryProfile: where the time of one query went, gathered while PROFILE
+ * runs it
+ *
+ * The profile is made current on the thread that executes the query (see
+ * Activation). Its time is split into stages: code that does a known kind of
+ * work switches the current profile to that stage for as long as it runs
+ * (see StageTimer), and all other time counts as scanning, so the stages add
+ * up to the total. Threads the scan is spread over have no current profile;
+ * the executing thread waits for them inside the scan stage.
+ *
+ * Rows tested against the query's condition are counted from every thread,
+ * each on counters of its own.
+ */
+class QueryProfile {
+public:
+  enum class Stage : uint8_t {
+    LockWait,
+    TableLookup,
+    ConditionInit,
+    Scan,
+    Merge,
+    Format,
+    Output,
+  };
+  static constexpr size_t kStages = 7;
+  static constexpr std::array<std::string_view, kStages> kStageNames = {
+      "Lock wait", "Table lookup", "Condition init", "Scan",
+      "Merge",     "Formatting",   "Output queueing"};
+
+  using Clock = std::chrono::steady_clock;
+
+  QueryProfile() = default;
+  QueryProfile(const QueryProfile &) = delete;
+  QueryProfile &operator=(const QueryProfile &) = delete;
+  QueryProfile(QueryProfile &&) = delete;
+  QueryProfile &operator=(QueryProfile &&) = delete;
+  ~QueryProfile() = default;
+
+  /** Get the profile current on this thread, or nullptr */
+  [[nodiscard]] static QueryProfile *current() { return active; }
+
+  /** Makes a profile current on this thread for its lifetime */
+  class Activation {
+    QueryProfile *previous;
+
+  public:
+    explicit Activation(QueryProfile &profile);
+    Activation(const Activation &) = delete;
+    Activation &operator=(const Activation &) = delete;
+    Activation(Activation &&) = delete;
+    Activation &operator=(Activation &&) = delete;
+    ~Activation();
+  };
+
+  /**
+   * Counts its lifetime to a stage of the current profile, if there is one;
+   * the stage it interrupts goes on once it ends
+   */
+  class StageTimer {
+    QueryProfile *profile;
+    Stage previous = Stage::Scan;
+
+  public:
+    explicit StageTimer(Stage stage) : profile(current()) {
+      if (profile != nullptr) [[unlikely]] {
+        previous = profile->switchTo(stage);
+      }
+    }
+    StageTimer(const StageTimer &) = delete;
+    StageTimer &operator=(const StageTimer &) = delete;
+    StageTimer(StageTimer &&) = delete;
+    StageTimer &operator=(StageTimer &&) = delete;
+    ~StageTimer() {
+      if (profile != nullptr) [[unlikely]] {
+        profile->switchTo(previous);
+      }
+    }
+  };
+
+  /**
+   * Count a row tested against the query's condition; called from any thread
+   * @param matched Whether the row met the condition
+   */
+  void countRow(bool matched) {
+    auto &counters = shards[shardIndex()];
+    counters.scanned.fetch_add(1, std::memory_order_relaxed);
+    if (matched) {
+      counters.matched.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * Count bytes of output the query produced
+   * @param bytes The bytes
+   */
+  void addBytes(size_t bytes) { producedBytes += bytes; }
+
+  /** Get the time spent in a stage, once the profile is no longer current */
+  [[nodiscard]] Clock::duration timeOf(Stage stage) const {
+    return stageTimes[static_cast<size_t>(stage)];
+  }
+
+  /** Get the time of every stage together */
+  [[nodiscard]] Clock::duration total() const;
+
+  [[nodiscard]] uint64_t rowsScanned() const;
+  [[nodiscard]] uint64_t rowsMatched() const;
+  [[nodiscard]] size_t bytes() const { return producedBytes; }
+
+private:
+  static constexpr size_t kShards = 16;
+  /** Per-thread counters, each on a cache line of its own */
+  struct alignas(64) Counters {
+    std::atomic<uint64_t> scanned{0};
+    std::atomic<uint64_t> matched{0};
+  };
+
+  static thread_local QueryProfile *active;
+
+  std::array<Clock::duration, kStages> stageTimes{};
+  Stage stage = Stage::Scan;
+  Clock::time_point since;
+  std::array<Counters, kShards> shards{};
+  size_t producedBytes = 0;
+
+  /**
+   * Charge the time since the last switch to the running stage, and run
+   * another
+   * @return the stage that was running
+   */
+  Stage switchTo(Stage next);
+
+  /** Get the counters of this thread */
+  static size_t shardIndex();
+};
+
+#endif  // PROJECT_QUERY_PROFILE_H
@@ -0,0 +1,150 @@
+#include "QueryStats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+
+size_t LatencyHistogram::bucketOf(uint64_t nanos) {
+  if (nanos < kSubBuckets) {
+    return static_cast<size_t>(nanos);
+  }
+  // The bits below the leading one and the kSubBucketBits after it are
+  // dropped; every bucket of the power of two is as wide
+  const auto shift =
+      static_cast<unsigned>(std::bit_width(nanos)) - 1 - kSubBucketBits;
+  const auto sub = static_cast<size_t>(nanos >> shift) & (kSubBuckets - 1);
+  return (shift + 1) * kSubBuckets + sub;
+}
+
+uint64_t LatencyHistogram::highestOf(size_t bucket) {
+  if (bucket < kSubBuckets) {
+    return bucket;
+  }
+  const size_t shift = bucket / kSubBuckets - 1;
+  const uint64_t lowest = (kSubBuckets + bucket % kSubBuckets) << shift;
+  return lowest + ((uint64_t{1} << shift) - 1);
+}
+
+uint64_t LatencyHistogram::percentile(uint64_t permille) const {
+  constexpr uint64_t kPermille = 1000;
+  const uint64_t counted = count();
+  if (counted == 0) [[unlikely]] {
+    return 0;
+  }
+  // The rank of the duration, counted from 1, rounded up
+  const uint64_t rank =
+      std::max<uint64_t>(1, (counted * permille + kPermille - 1) / kPermille);
+  uint64_t seen = 0;
+  for (size_t bucket = 0; bucket < kBuckets; ++bucket) {
+    seen += counts[bucket].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      return highestOf(bucket);
+    }
+  }
+  return highestOf(kBuckets - 1);
+}
+
+void LatencyHistogram::reset() {
+  for (auto &bucket : counts) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  total.store(0, std::memory_order_relaxed);
+}
+
+void QueryStats::record(std::string_view keyword, std::string_view table,
+                        Clock::time_point submitted, Clock::time_point started,
+                        Clock::time_point finished) {
+  if (keyword.empty()) [[unlikely]] {
+    return;
+  }
+  const auto nanos = [](Clock::duration time) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+  };
+  const uint64_t wait = nanos(started - submitted);
+  const uint64_t run = nanos(finished - started);
+  const auto count = [wait, run](Latencies &latencies) {
+    latencies.wait.record(wait);
+    latencies.run.record(run);
+  };
+  count(everything);
+  count(groupOf(byKeyword, keyword));
+  if (!table.empty()) [[likely]] {
+    count(groupOf(byTable, table));
+  }
+
+  const Clock::rep ticks = submitted.time_since_epoch().count();
+  Clock::rep earliest = since.load(std::memory_order_relaxed);
+  while (ticks < earliest && !since.compare_exchange_weak(
+                                 earliest, ticks, std::memory_order_relaxed)) {
+  }
+}
+
+void QueryStats::reset() {
+  const std::unique_lock lock(mutex);
+  const auto clear = [](Latencies &latencies) {
+    latencies.wait.reset();
+    latencies.run.reset();
+  };
+  clear(everything);
+  for (auto &[name, latencies] : byKeyword) {
+    clear(*latencies);
+  }
+  for (auto &[name, latencies] : byTable) {
+    clear(*latencies);
+  }
+  since.store(kNever, std::memory_order_relaxed);
+}
+
+void QueryStats::forEachKeyword(
+    const std::function<void(std::string_view, const Latencies &)> &visit)
+    const {
+  const std::shared_lock lock(mutex);
+  for (const auto &[name, latencies] : byKeyword) {
+    visit(name, *latencies);
+  }
+}
+
+void QueryStats::forEachTable(
+    const std::function<void(std::string_view, const Latencies &)> &visit)
+    const {
+  const std::shared_lock lock(mutex);
+  for (const auto &[name, latencies] : byTable) {
+    visit(name, *latencies);
+  }
+}
+
+QueryStats::Clock::duration QueryStats::elapsed() const {
+  const Clock::rep earliest = since.load(std::memory_order_relaxed);
+  if (earliest == kNever) {
+    return Clock::duration::zero();
+  }
+  return Clock::now() - Clock::time_point(Clock::duration(earliest));
+}
+
+QueryStats::Latencies &QueryStats::groupOf(Groups &groups,
+                                           std::string_view name) {
+  {
+    const std::shared_lock lock(mutex);
+    const auto found = groups.find(name);
+    if (found != groups.end()) [[likely]] {
+      return *found->second;
+    }
+  }
+  const std::unique_lock lock(mutex);
+  auto &latencies = groups[std::string(name)];
+  if (latencies == nullptr) {
+    latencies = std::make_unique<Latencies>();
+  }
+  return *latencies;
+}
@@ -0,0 +1,157 @@
+#ifndef PROJECT_QUERY_STATS_H
+#define PROJECT_QUERY_STATS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+
+/**
+ * LatencyHistogram: counts of durations in log-linear buckets, HDR style
+ *
+ * Each power of two is split into kSubBuckets buckets, so a percentile is
+ * within 1/kSubBuckets of the true duration however large it is, in a fixed
+ * array of counters. Recording takes one relaxed atomic increment, so any
+ * number of threads record at once.
+ */
+class LatencyHistogram {
+public:
+  static constexpr unsigned kSubBucketBits = 4;
+  static constexpr size_t kSubBuckets = size_t{1} << kSubBucketBits;
+  static constexpr size_t kBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+  LatencyHistogram() = default;
+  LatencyHistogram(const LatencyHistogram &) = delete;
+  LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+  LatencyHistogram(LatencyHistogram &&) = delete;
+  LatencyHistogram &operator=(LatencyHistogram &&) = delete;
+  ~LatencyHistogram() = default;
+
+  /**
+   * Count a duration
+   * @param nanos The duration in nanoseconds
+   */
+  void record(uint64_t nanos) {
+    counts[bucketOf(nanos)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /** Get the number of durations counted */
+  [[nodiscard]] uint64_t count() const {
+    return total.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Get a percentile of the durations counted
+   * @param permille The percentile, in thousandths (500 for the median)
+   * @return the largest duration of the bucket it falls in, in nanoseconds;
+   * 0 if nothing was counted
+   */
+  [[nodiscard]] uint64_t percentile(uint64_t permille) const;
+
+  /** Forget every duration; no thread may record meanwhile */
+  void reset();
+
+private:
+  std::array<std::atomic<uint64_t>, kBuckets> counts{};
+  std::atomic<uint64_t> total{0};
+
+  [[nodiscard]] static size_t bucketOf(uint64_t nanos);
+  [[nodiscard]] static uint64_t highestOf(size_t bucket);
+};
+
+/**
+ * QueryStats: latencies of every query the query manager ran, by statement
+ * keyword and by table
+ *
+ * Each query counts the time it waited between its submission and the start
+ * of its execution apart from the time it ran. A query run in a batch (see
+ * Query::executeBatch) ran as long as its whole batch. Groups are created
+ * the first time a keyword or table is seen and live as long as the process,
+ * so a reset only clears their counts.
+ */
+class QueryStats {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /** The latencies of a group of queries */
+  struct Latencies {
+    LatencyHistogram wait;
+    LatencyHistogram run;
+  };
+
+  [[nodiscard]] static QueryStats &getInstance() {
+    static QueryStats instance;
+    return instance;
+  }
+
+  QueryStats(const QueryStats &) = delete;
+  QueryStats &operator=(const QueryStats &) = delete;
+  QueryStats(QueryStats &&) = delete;
+  QueryStats &operator=(QueryStats &&) = delete;
+  ~QueryStats() = default;
+
+  /**
+   * Count a query
+   * @param keyword The keyword of its statement; nothing is counted if empty
+   * @param table Its target table, or empty if it has none
+   * @param submitted When it was submitted
+   * @param started When its execution started
+   * @param finished When its execution finished
+   */
+  void record(std::string_view keyword, std::string_view table,
+              Clock::time_point submitted, Clock::time_point started,
+              Clock::time_point finished);
+
+  /**
+   * Forget every query counted so far; no query may run meanwhile
+   */
+  void reset();
+
+  /** Get the latencies of every query */
+  [[nodiscard]] const Latencies &all() const { return everything; }
+
+  /** Visit the latencies of each keyword seen, in keyword order */
+  void forEachKeyword(
+      const std::function<void(std::string_view, const Latencies &)> &visit)
+      const;
+
+  /** Visit the latencies of each table seen, in name order */
+  void forEachTable(
+      const std::function<void(std::string_view, const Latencies &)> &visit)
+      const;
+
+  /**
+   * Get the time since the first query counted was submitted, or zero if
+   * none was
+   */
+  [[nodiscard]] Clock::duration elapsed() const;
+
+private:
+  static constexpr Clock::rep kNever = std::numeric_limits<Clock::rep>::max();
+
+  QueryStats() = default;
+
+  using Groups = std::map<std::string, std::unique_ptr<Latencies>, std::less<>>;
+
+  /** Protects byKeyword and byTable */
+  mutable std::shared_mutex mutex;
+  Groups byKeyword;
+  Groups byTable;
+  Latencies everything;
+  /** Ticks of the earliest submission counted, or kNever */
+  std::atomic<Clock::rep> since{kNever};
+
+  /** Get the latencies of a group, creating it the first time */
+  Latencies &groupOf(Groups &groups, std::string_view name);
+};
+
+#endif  // PROJECT_QUERY_STATS_H
@@ -0,0 +1,306 @@
+#include "ReadAhead.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <deque>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../threading/Threadpool.h"
+
+namespace {
+/** Unclaimed prefetches kept at once (each buffers up to kMaxBufferedBytes) */
+constexpr size_t kMaxPrefetched = 16;
+
+/** An istream owning its stream buffer */
+class OwningStream final : public std::istream {
+public:
+  explicit OwningStream(std::unique_ptr<std::streambuf> buffer)
+      : std::istream(buffer.get()), owned(std::move(buffer)) {}
+
+private:
+  std::unique_ptr<std::streambuf> owned;
+};
+}  // namespace
+
+struct ReadAhead::Source {
+  int fd = -1;
+  std::deque<std::vector<char>> chunks;
+  size_t bufferedBytes = 0;
+  /** No more chunks will be added */
+  bool done = false;
+  void *mapped = nullptr;
+  size_t mappedBytes = 0;
+
+  Source() = default;
+  Source(const Source &) = delete;
+  Source &operator=(const Source &) = delete;
+  Source(Source &&) = delete;
+  Source &operator=(Source &&) = delete;
+
+  ~Source() {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+    if (mapped != nullptr) {
+      ::munmap(mapped, mappedBytes);
+    }
+  }
+};
+
+/** Get area over the chunks of a source, or over its mapping */
+class ReadAhead::Buffer final : public std::streambuf {
+public:
+  Buffer(ReadAhead &owner, std::shared_ptr<Source> source)
+      : owner(owner), source(std::move(source)) {
+    if (this->source->mapped != nullptr) {
+      auto *const begin = static_cast<char *>(this->source->mapped);
+      setg(begin, begin, begin + this->source->mappedBytes);
+    }
+  }
+
+  Buffer(const Buffer &) = delete;
+  Buffer &operator=(const Buffer &) = delete;
+  Buffer(Buffer &&) = delete;
+  Buffer &operator=(Buffer &&) = delete;
+
+  ~Buffer() override { owner.release(*source); }
+
+protected:
+  int_type underflow() override {
+    if (gptr() == egptr()) {
+      if (source->mapped != nullptr || !owner.nextChunk(*source, chunk)) {
+        return traits_type::eof();
+      }
+      setg(chunk.data(), chunk.data(), chunk.data() + chunk.size());
+    }
+    return traits_type::to_int_type(*gptr());
+  }
+
+private:
+  ReadAhead &owner;
+  std::shared_ptr<Source> source;
+  std::vector<char> chunk;
+};
+
+ReadAhead::~ReadAhead() { shutdown(); }
+
+void ReadAhead::setUseMmap(bool enabled) {
+  const std::scoped_lock lock(mutex);
+  useMmap = enabled;
+}
+
+void ReadAhead::prefetch(const std::string &path) {
+  if (!ThreadPool::isInitialized()) [[unlikely]] {
+    return;
+  }
+  bool mmap = false;
+  {
+    const std::scoped_lock lock(mutex);
+    if (stopping || prefetched.contains(path) ||
+        prefetched.size() >= kMaxPrefetched) {
+      return;
+    }
+    mmap = useMmap;
+  }
+
+  auto source = openSource(path, mmap);
+  if (source == nullptr) [[unlikely]] {
+    return;  // open() reports the error when the file is needed
+  }
+  const std::scoped_lock lock(mutex);
+  if (!stopping && prefetched.emplace(path, source).second) {
+    track(std::move(source));
+  }
+}
+
+std::unique_ptr<std::istream> ReadAhead::open(const std::string &path) {
+  std::shared_ptr<Source> source;
+  bool mmap = false;
+  bool enabled = ThreadPool::isInitialized();
+  if (enabled) [[likely]] {
+    const std::scoped_lock lock(mutex);
+    enabled = !stopping;
+    if (const auto iter = prefetched.find(path); iter != prefetched.end()) {
+      source = std::move(iter->second);
+      prefetched.erase(iter);
+    }
+    mmap = useMmap;
+  }
+
+  if (!enabled) [[unlikely]] {
+    auto file = std::make_unique<std::ifstream>(path);
+    if (!file->is_open()) {
+      return nullptr;
+    }
+    return file;
+  }
+
+  if (source == nullptr) {
+    source = openSource(path, mmap);
+    if (source == nullptr) [[unlikely]] {
+      return nullptr;
+    }
+    const std::scoped_lock lock(mutex);
+    track(source);
+  }
+  return std::make_unique<OwningStream>(
+      std::make_unique<Buffer>(*this, std::move(source)));
+}
+
+void ReadAhead::shutdown() {
+  {
+    const std::scoped_lock lock(mutex);
+    stopping = true;
+  }
+  changed.notify_all();
+  if (ioThread.joinable()) {
+    ioThread.join();
+  }
+
+  const std::scoped_lock lock(mutex);
+  reading.clear();
+  prefetched.clear();
+}
+
+bool ReadAhead::isReadAheadStream(const std::istream &input) {
+  return dynamic_cast<const Buffer *>(input.rdbuf()) != nullptr;
+}
+
+std::shared_ptr<ReadAhead::Source>
+ReadAhead::openSource(const std::string &path, bool mmap) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+  const int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (file < 0) [[unlikely]] {
+    return nullptr;
+  }
+  auto source = std::make_shared<Source>();
+  source->fd = file;
+
+  struct stat status {};
+  if (mmap && ::fstat(file, &status) == 0 && S_ISREG(status.st_mode) &&
+      status.st_size > 0) {
+    const auto bytes = static_cast<size_t>(status.st_size);
+    void *const mapped =
+        ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, file, 0);
+    if (mapped != MAP_FAILED) [[likely]] {
+      ::madvise(mapped, bytes, MADV_SEQUENTIAL);
+      ::madvise(mapped, bytes, MADV_WILLNEED);
+      source->mapped = mapped;
+      source->mappedBytes = bytes;
+      source->done = true;
+      ::close(file);
+      source->fd = -1;
+      return source;
+    }
+  }
+  ::posix_fadvise(file, 0, 0, POSIX_FADV_SEQUENTIAL);
+  return source;
+}
+
+void ReadAhead::track(std::shared_ptr<Source> source) {
+  if (source->done) {
+    return;
+  }
+  reading.push_back(std::move(source));
+  if (!ioThread.joinable()) {
+    ioThread = std::thread(&ReadAhead::ioLoop, this);
+  }
+  changed.notify_all();
+}
+
+void ReadAhead::release(Source &source) {
+  const std::scoped_lock lock(mutex);
+  source.done = true;
+  source.chunks.clear();
+  source.bufferedBytes = 0;
+  reading.remove_if([&source](const auto &entry) {
+    return entry.get() == &source;
+  });
+}
+
+bool ReadAhead::nextChunk(Source &source, std::vector<char> &chunk) {
+  std::unique_lock lock(mutex);
+  changed.wait(lock, [this, &source] {
+    return stopping || source.done || !source.chunks.empty();
+  });
+  if (source.chunks.empty()) [[unlikely]] {
+    return false;
+  }
+  chunk = std::move(source.chunks.front());
+  source.chunks.pop_front();
+  source.bufferedBytes -= chunk.size();
+  changed.notify_all();
+  return true;
+}
+
+void ReadAhead::ioLoop() {
+  std::unique_lock lock(mutex);
+  while (true) {
+    // The oldest file with room left: readers wait on at most one file, and
+    // its buffer is then empty, so it is always eligible.
+    std::shared_ptr<Source> source;
+    changed.wait(lock, [this, &source] {
+      if (stopping) {
+        return true;
+      }
+      for (const auto &entry : reading) {
+        if (entry->bufferedBytes < kMaxBufferedBytes) {
+          source = entry;
+          return true;
+        }
+      }
+      return false;
+    });
+    if (stopping) {
+      return;
+    }
+    const int file = source->fd;
+    lock.unlock();
+
+    std::vector<char> chunk(kChunkBytes);
+    size_t filled = 0;
+    bool ended = false;
+    while (filled < chunk.size()) {
+      const ssize_t got =
+          ::read(file, chunk.data() + filled, chunk.size() - filled);
+      if (got < 0 && errno == EINTR) [[unlikely]] {
+        continue;
+      }
+      if (got <= 0) {
+        // A read error ends the file like EOF, as with std::ifstream
+        ended = true;
+        break;
+      }
+      filled += static_cast<size_t>(got);
+    }
+    chunk.resize(filled);
+
+    lock.lock();
+    if (source->done) [[unlikely]] {
+      continue;  // Released while reading
+    }
+    if (!chunk.empty()) {
+      source->bufferedBytes += chunk.size();
+      source->chunks.push_back(std::move(chunk));
+    }
+    if (ended) {
+      source->done = true;
+      ::close(source->fd);
+      source->fd = -1;
+      reading.remove(source);
+    }
+    changed.notify_all();
+  }
+}
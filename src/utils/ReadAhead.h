@@ -0,0 +1,109 @@
+#ifndef PROJECT_READ_AHEAD_H
+#define PROJECT_READ_AHEAD_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <istream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * ReadAhead: background reading of LISTEN files
+ *
+ * Files opened here are read by a single I/O thread into large chunks ahead
+ * of the statement reader, so parsing and scheduling never wait on a read(2)
+ * that could have been issued earlier. Files can be prefetched as soon as
+ * they are named (e.g. a nested LISTEN) and are then already open and
+ * partially read when their turn comes.
+ *
+ * Each file buffers at most kMaxBufferedBytes ahead of its reader. The I/O
+ * thread serves files in the order they were opened but skips files whose
+ * buffer is full, so a reader waiting on one file is never blocked behind
+ * another.
+ *
+ * With mmap enabled, regular files are mapped instead and the kernel is told
+ * to read them ahead (MADV_WILLNEED); the I/O thread is not involved.
+ *
+ * Without a running ThreadPool (small workloads) files are opened as plain
+ * std::ifstreams.
+ */
+class ReadAhead {
+public:
+  static constexpr size_t kChunkBytes = size_t{1} << 20U;
+  static constexpr size_t kMaxBufferedBytes = size_t{4} << 20U;
+
+  [[nodiscard]] static ReadAhead &getInstance() {
+    static ReadAhead instance;
+    return instance;
+  }
+
+  ReadAhead(const ReadAhead &) = delete;
+  ReadAhead &operator=(const ReadAhead &) = delete;
+  ReadAhead(ReadAhead &&) = delete;
+  ReadAhead &operator=(ReadAhead &&) = delete;
+  ~ReadAhead();
+
+  /**
+   * Map regular files instead of reading them on the I/O thread
+   * @param enabled Whether open() and prefetch() use mmap
+   */
+  void setUseMmap(bool enabled);
+
+  /**
+   * Open a file and start reading it in the background, to be claimed by a
+   * later open() of the same path. Files that cannot be opened are ignored.
+   * @param path The file to read
+   */
+  void prefetch(const std::string &path);
+
+  /**
+   * Open a file for reading, claiming its prefetch if there is one
+   * @param path The file to read
+   * @return a stream over the file, or nullptr if it cannot be opened
+   */
+  [[nodiscard]] std::unique_ptr<std::istream> open(const std::string &path);
+
+  /**
+   * Stop the I/O thread and drop unclaimed prefetches. Streams still open
+   * end early.
+   */
+  void shutdown();
+
+  /**
+   * Check whether a stream was opened by open() and reads ahead, i.e. it can
+   * be consumed in large blocks like a file stream
+   * @param input The stream to check
+   */
+  [[nodiscard]] static bool isReadAheadStream(const std::istream &input);
+
+private:
+  struct Source;
+  class Buffer;
+
+  ReadAhead() = default;
+
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::list<std::shared_ptr<Source>> reading;
+  std::unordered_map<std::string, std::shared_ptr<Source>> prefetched;
+  std::thread ioThread;
+  bool useMmap = false;
+  bool stopping = false;
+
+  static std::shared_ptr<Source> openSource(const std::string &path,
+                                            bool mmap);
+  /** Hand a source to the I/O thread (mutex held) */
+  void track(std::shared_ptr<Source> source);
+  /** Stop reading a source whose stream was closed */
+  void release(Source &source);
+  /** Wait for the next chunk of a source; false at its end */
+  bool nextChunk(Source &source, std::vector<char> &chunk);
+  void ioLoop();
+};
+
+#endif  // PROJECT_READ_AHEAD_H
@@ -0,0 +1,54 @@
+#include "ResultBuffer.h"
+
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+struct BufferPool {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<ResultBuffer>> free;
+};
+
+BufferPool &pool() {
+  static BufferPool instance;
+  return instance;
+}
+}  // namespace
+
+ResultBuffer::Ptr ResultBuffer::acquire() {
+  std::unique_ptr<ResultBuffer> buffer;
+  {
+    auto &buffers = pool();
+    const std::scoped_lock lock(buffers.mutex);
+    if (!buffers.free.empty()) [[likely]] {
+      buffer = std::move(buffers.free.back());
+      buffers.free.pop_back();
+    }
+  }
+  if (buffer == nullptr) [[unlikely]] {
+    buffer = std::make_unique<ResultBuffer>();
+  }
+  return {buffer.release(), &ResultBuffer::recycle};
+}
+
+ResultBuffer::Ptr ResultBuffer::acquire(std::string_view text) {
+  auto buffer = acquire();
+  *buffer << text;
+  return buffer;
+}
+
+void ResultBuffer::recycle(ResultBuffer *buffer) {
+  std::unique_ptr<ResultBuffer> owned(buffer);
+  if (owned->bytes.capacity() > kMaxPooledCapacity) [[unlikely]] {
+    return;
+  }
+  owned->bytes.clear();
+  auto &buffers = pool();
+  const std::scoped_lock lock(buffers.mutex);
+  if (buffers.free.size() < kMaxPooled) [[likely]] {
+    buffers.free.push_back(std::move(owned));
+  }
+}
@@ -0,0 +1,88 @@
+#ifndef PROJECT_RESULT_BUFFER_H
+#define PROJECT_RESULT_BUFFER_H
+
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/**
+ * ResultBuffer: the bytes a query prints
+ *
+ * A result is formatted once, straight into a buffer taken from a process-wide
+ * pool, and the buffer is then handed by ownership from the query through
+ * QueryManager and OutputPool to the writer; nothing copies the text on the
+ * way. Buffers are reference counted so that other holders (e.g. a result
+ * cache) may share the bytes; when the last reference goes away the storage
+ * returns to the pool with its capacity.
+ *
+ * Numbers are formatted with std::to_chars.
+ */
+class ResultBuffer {
+public:
+  using Ptr = std::shared_ptr<ResultBuffer>;
+
+  /** Buffers retained by the pool */
+  static constexpr size_t kMaxPooled = 64;
+  /** Buffers that grew beyond this are freed instead of pooled */
+  static constexpr size_t kMaxPooledCapacity = size_t{1} << 20U;
+
+  ResultBuffer() = default;
+  ResultBuffer(const ResultBuffer &) = delete;
+  ResultBuffer &operator=(const ResultBuffer &) = delete;
+  ResultBuffer(ResultBuffer &&) = delete;
+  ResultBuffer &operator=(ResultBuffer &&) = delete;
+  ~ResultBuffer() = default;
+
+  /**
+   * Take an empty buffer from the pool
+   * @return the buffer, returned to the pool when released
+   */
+  [[nodiscard]] static Ptr acquire();
+
+  /**
+   * Take a buffer from the pool holding a copy of text
+   * @param text The initial content
+   */
+  [[nodiscard]] static Ptr acquire(std::string_view text);
+
+  ResultBuffer &operator<<(std::string_view text) {
+    bytes.append(text);
+    return *this;
+  }
+
+  ResultBuffer &operator<<(char character) {
+    bytes.push_back(character);
+    return *this;
+  }
+
+  template <std::integral T>
+    requires(!std::same_as<T, char> && !std::same_as<T, bool>)
+  ResultBuffer &operator<<(T value) {
+    // Enough for the decimal digits and sign of any 64-bit integer
+    constexpr size_t maxDigits = 24;
+    std::array<char, maxDigits> digits{};
+    const auto result =
+        std::to_chars(digits.data(), digits.data() + digits.size(), value);
+    bytes.append(digits.data(), result.ptr);
+    return *this;
+  }
+
+  void reserve(size_t capacity) { bytes.reserve(capacity); }
+
+  [[nodiscard]] std::string_view view() const { return bytes; }
+
+  [[nodiscard]] size_t size() const { return bytes.size(); }
+
+  [[nodiscard]] bool empty() const { return bytes.empty(); }
+
+private:
+  std::string bytes;
+
+  static void recycle(ResultBuffer *buffer);
+};
+
+#endif  // PROJECT_RESULT_BUFFER_H
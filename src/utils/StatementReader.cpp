@@ -0,0 +1,93 @@
+#include "StatementReader.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <ios>
+#include <istream>
+#include <string>
+#include <string_view>
+
+#include "ReadAhead.h"
+
+StatementReader::StatementReader(std::istream &input, size_t blockSize)
+    : input(input), blockSize(std::max<size_t>(blockSize, 1)),
+      bulkReads(dynamic_cast<std::filebuf *>(input.rdbuf()) != nullptr ||
+                ReadAhead::isReadAheadStream(input)) {
+  buffer.resize(this->blockSize);
+}
+
+bool StatementReader::next(std::string_view &statement) {
+  while (true) {
+    const auto *data = buffer.data();
+    const auto *found = static_cast<const char *>(
+        std::memchr(data + scan, ';', end - scan));
+    if (found != nullptr) [[likely]] {
+      const auto pos = static_cast<size_t>(found - data);
+      statement = std::string_view(data + begin, pos - begin);
+      begin = pos + 1;
+      scan = begin;
+      return true;
+    }
+    scan = end;
+    if (!fill()) [[unlikely]] {
+      if (begin == end) {
+        return false;
+      }
+      begin = end;
+      scan = end;
+      throw std::ios_base::failure("Unexpected end of input before ';'");
+    }
+  }
+}
+
+bool StatementReader::canReadWithoutWaiting() const {
+  return bulkReads || exhausted ||
+         std::memchr(buffer.data() + scan, ';', end - scan) != nullptr;
+}
+
+bool StatementReader::fill() {
+  if (exhausted) [[unlikely]] {
+    return false;
+  }
+
+  // Drop consumed statements so the buffer only grows for huge statements
+  if (begin > 0) {
+    std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+    end -= begin;
+    scan -= begin;
+    begin = 0;
+  }
+  if (buffer.size() - end < blockSize) {
+    buffer.resize(end + blockSize);
+  }
+
+  auto *streamBuffer = input.rdbuf();
+  std::streamsize got = 0;
+  if (bulkReads) [[likely]] {
+    got = streamBuffer->sgetn(buffer.data() + end,
+                              static_cast<std::streamsize>(blockSize));
+  } else {
+    const auto available = streamBuffer->in_avail();
+    if (available > 0) {
+      got = streamBuffer->sgetn(
+          buffer.data() + end,
+          std::min(available, static_cast<std::streamsize>(blockSize)));
+    } else if (available == 0) {
+      const auto character = streamBuffer->sbumpc();
+      if (character != std::char_traits<char>::eof()) {
+        buffer[end] = std::char_traits<char>::to_char_type(character);
+        got = 1;
+      }
+    }
+  }
+
+  if (got <= 0) {
+    exhausted = true;
+    input.setstate(std::ios_base::eofbit);
+    return false;
+  }
+  end += static_cast<size_t>(got);
+  return true;
+}
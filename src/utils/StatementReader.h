@@ -0,0 +1,69 @@
+#ifndef LEMONDB_STATEMENTREADER_H
+#define LEMONDB_STATEMENTREADER_H
+
+#include <cstddef>
+#include <istream>
+#include <string_view>
+#include <vector>
+
+/**
+ * Buffered reader splitting an input stream into ';' terminated statements.
+ *
+ * The stream is consumed in large blocks and statement boundaries are found
+ * with memchr, so the hot loop never goes through istream::get(). Statements
+ * are handed out as views into the internal buffer; a view stays valid until
+ * the next call to next().
+ *
+ * File streams (including ReadAhead streams) are read a full block at a
+ * time. Other streams (stdin synced with stdio, string streams) only take
+ * what is already buffered, falling back to a single character, so
+ * interactive input is never held back.
+ */
+class StatementReader {
+public:
+  /** Default size of one read from the underlying stream. */
+  static constexpr size_t kDefaultBlockSize = 1024UL * 64;
+
+  /**
+   * Construct a reader over a stream.
+   * @param input The stream to read statements from (must outlive reader)
+   * @param blockSize Number of bytes requested per read
+   */
+  explicit StatementReader(std::istream &input,
+                           size_t blockSize = kDefaultBlockSize);
+
+  /**
+   * Read the next statement, without its terminating ';'.
+   * @param statement Set to a view of the statement text
+   * @return false once the stream is exhausted with no pending input
+   * @throws std::ios_base::failure if the stream ends inside a statement
+   */
+  bool next(std::string_view &statement);
+
+  /**
+   * Check whether next() can return without waiting for more input, i.e.
+   * the stream is a file or a complete statement is already buffered.
+   */
+  [[nodiscard]] bool canReadWithoutWaiting() const;
+
+private:
+  std::istream &input;
+  std::vector<char> buffer;
+  size_t blockSize;
+  /** Start of the unread data in buffer */
+  size_t begin = 0;
+  /** End of the valid data in buffer */
+  size_t end = 0;
+  /** Position from which the next ';' search starts */
+  size_t scan = 0;
+  bool bulkReads;
+  bool exhausted = false;
+
+  /**
+   * Append more data from the stream to the buffer.
+   * @return false if the stream has no more data
+   */
+  bool fill();
+};
+
+#endif  // LEMONDB_STATEMENTREADER_H
@@ -0,0 +1,142 @@
+#include "Tracer.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+std::atomic<bool> Tracer::enabled{false};
+thread_local Tracer::ThreadBuffer *Tracer::local = nullptr;
+
+namespace {
+/** Write a string as the contents of a JSON string */
+void writeEscaped(std::ostream &out, std::string_view text) {
+  constexpr unsigned char kFirstPrintable = 0x20;
+  constexpr std::string_view kHexDigits = "0123456789abcdef";
+  constexpr unsigned kNibbleBits = 4;
+  constexpr unsigned kNibbleMask = 0xF;
+  for (const char character : text) {
+    const auto code = static_cast<unsigned char>(character);
+    if (character == '"' || character == '\\') {
+      out << '\\' << character;
+    } else if (code < kFirstPrintable) {
+      out << "\\u00" << kHexDigits[code >> kNibbleBits]
+          << kHexDigits[code & kNibbleMask];
+    } else {
+      out << character;
+    }
+  }
+}
+
+/** Write nanoseconds as microseconds, the unit of trace events */
+void writeMicros(std::ostream &out, int64_t nanos) {
+  constexpr int64_t kNanosPerMicro = 1000;
+  constexpr int64_t kHundreds = 100;
+  constexpr int64_t kTens = 10;
+  const int64_t fraction = nanos % kNanosPerMicro;
+  out << nanos / kNanosPerMicro << '.' << fraction / kHundreds
+      << fraction / kTens % kTens << fraction % kTens;
+}
+}  // namespace
+
+bool Tracer::enable(const std::string &path) {
+  const std::scoped_lock lock(mutex);
+  file.open(path, std::ios::out | std::ios::trunc);
+  if (!file.is_open()) [[unlikely]] {
+    return false;
+  }
+  origin = Clock::now();
+  enabled.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+void Tracer::record(std::string_view name, std::string_view detail,
+                    Clock::time_point begin, Clock::time_point end) {
+  append({name, std::string(detail),
+          std::chrono::duration_cast<std::chrono::nanoseconds>(begin - origin)
+              .count(),
+          std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin)
+              .count()});
+}
+
+void Tracer::nameThread(std::string_view name) {
+  if (isEnabled()) [[unlikely]] {
+    getInstance().append({"thread_name", std::string(name), 0, kThreadName});
+  }
+}
+
+Tracer::ThreadBuffer &Tracer::localBuffer() {
+  if (local == nullptr) [[unlikely]] {
+    auto buffer = std::make_unique<ThreadBuffer>();
+    const std::scoped_lock lock(mutex);
+    buffer->tid = buffers.size() + 1;
+    local = buffer.get();
+    buffers.push_back(std::move(buffer));
+  }
+  return *local;
+}
+
+void Tracer::append(Event event) {
+  ThreadBuffer &buffer = localBuffer();
+  Chunk *chunk = buffer.tail;
+  size_t used = chunk->used.load(std::memory_order_relaxed);
+  if (used == Chunk::kEvents) [[unlikely]] {
+    chunk->nextOwner = std::make_unique<Chunk>();
+    chunk->next.store(chunk->nextOwner.get(), std::memory_order_release);
+    chunk = chunk->nextOwner.get();
+    buffer.tail = chunk;
+    used = 0;
+  }
+  chunk->events[used] = std::move(event);
+  chunk->used.store(used + 1, std::memory_order_release);
+}
+
+bool Tracer::write() {
+  if (!isEnabled()) [[likely]] {
+    return true;
+  }
+  enabled.store(false, std::memory_order_relaxed);
+  const std::scoped_lock lock(mutex);
+  file << R"({"displayTimeUnit":"ns","traceEvents":[)";
+  const char *separator = "\n";
+  for (const auto &buffer : buffers) {
+    for (const Chunk *chunk = &buffer->head; chunk != nullptr;
+         chunk = chunk->next.load(std::memory_order_acquire)) {
+      const size_t used = chunk->used.load(std::memory_order_acquire);
+      for (size_t index = 0; index < used; ++index) {
+        const Event &event = chunk->events[index];
+        file << separator << R"({"pid":1,"tid":)" << buffer->tid;
+        separator = ",\n";
+        if (event.duration == kThreadName) {
+          file << R"(,"ph":"M","name":"thread_name","args":{"name":")";
+          writeEscaped(file, event.detail);
+          file << "\"}}";
+          continue;
+        }
+        file << R"(,"ph":"X","cat":"lemondb","name":")";
+        writeEscaped(file, event.name);
+        file << R"(","ts":)";
+        writeMicros(file, event.begin);
+        file << R"(,"dur":)";
+        writeMicros(file, event.duration);
+        if (!event.detail.empty()) {
+          file << R"(,"args":{"detail":")";
+          writeEscaped(file, event.detail);
+          file << "\"}";
+        }
+        file << '}';
+      }
+    }
+  }
+  file << "\n]}\n";
+  file.close();
+  return !file.fail();
+}
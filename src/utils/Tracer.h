@@ -0,0 +1,149 @@
+#ifndef PROJECT_TRACER_H
+#define PROJECT_TRACER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Tracer: timeline of what each thread did, written as Chrome trace-event
+ * JSON (chrome://tracing, Perfetto) once the run is over (see --trace)
+ *
+ * Code that does a kind of work worth seeing on the timeline holds a Span
+ * while it runs. Every thread records its spans into a buffer of its own,
+ * without locks: the thread appends to fixed-size chunks and publishes each
+ * event with one release store, so write() can read what every thread
+ * published so far. While tracing is disabled, a Span costs one relaxed load.
+ */
+class Tracer {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  [[nodiscard]] static Tracer &getInstance() {
+    static Tracer instance;
+    return instance;
+  }
+
+  Tracer(const Tracer &) = delete;
+  Tracer &operator=(const Tracer &) = delete;
+  Tracer(Tracer &&) = delete;
+  Tracer &operator=(Tracer &&) = delete;
+  ~Tracer() = default;
+
+  /**
+   * Start recording spans, to be written to a file; called once, before the
+   * threads to trace start
+   * @param path The file
+   * @return false if the file cannot be created
+   */
+  bool enable(const std::string &path);
+
+  [[nodiscard]] static bool isEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Record a span that ran on this thread
+   * @param name What ran; must live as long as the process (a literal)
+   * @param detail What it ran on, e.g. a table name; copied
+   * @param begin When it started
+   * @param end When it ended
+   */
+  void record(std::string_view name, std::string_view detail,
+              Clock::time_point begin, Clock::time_point end);
+
+  /**
+   * Name this thread on the timeline, if tracing is enabled
+   * @param name The name; copied
+   */
+  static void nameThread(std::string_view name);
+
+  /**
+   * Write the spans every thread recorded so far to the file and stop
+   * recording
+   * @return false if the file could not be written
+   */
+  bool write();
+
+  /** Records its lifetime as a span of the current thread */
+  class Span {
+    std::string_view name;
+    std::string_view detail;
+    Clock::time_point begin;
+    bool active;
+
+  public:
+    /**
+     * @param name What runs; must live as long as the process (a literal)
+     * @param detail What it runs on; must outlive the span
+     */
+    explicit Span(std::string_view name, std::string_view detail = {})
+        : name(name), detail(detail), active(isEnabled()) {
+      if (active) [[unlikely]] {
+        begin = Clock::now();
+      }
+    }
+    Span(const Span &) = delete;
+    Span &operator=(const Span &) = delete;
+    Span(Span &&) = delete;
+    Span &operator=(Span &&) = delete;
+    ~Span() {
+      if (active) [[unlikely]] {
+        getInstance().record(name, detail, begin, Clock::now());
+      }
+    }
+  };
+
+private:
+  Tracer() = default;
+
+  struct Event {
+    std::string_view name;
+    std::string detail;
+    /** Nanoseconds since tracing started */
+    int64_t begin = 0;
+    /** Nanoseconds, or kThreadName for the name of the thread */
+    int64_t duration = 0;
+  };
+  static constexpr int64_t kThreadName = -1;
+
+  /** Events of one thread, appended by it alone */
+  struct Chunk {
+    static constexpr size_t kEvents = 1024;
+    std::array<Event, kEvents> events;
+    /** Events published to readers */
+    std::atomic<size_t> used{0};
+    std::atomic<Chunk *> next{nullptr};
+    std::unique_ptr<Chunk> nextOwner;
+  };
+  struct ThreadBuffer {
+    size_t tid = 0;
+    Chunk head;
+    /** The chunk being appended to; touched by the owner only */
+    Chunk *tail = &head;
+  };
+
+  static std::atomic<bool> enabled;
+  static thread_local ThreadBuffer *local;
+
+  Clock::time_point origin;
+  std::ofstream file;
+  /** Protects buffers and file */
+  std::mutex mutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+  /** Get the buffer of this thread, registering it the first time */
+  ThreadBuffer &localBuffer();
+
+  void append(Event event);
+};
+
+#endif  // PROJECT_TRACER_H
@@ -43,6 +43,27 @@ static inline std::string to_string(const std::vector<T> &vec) {
                          });
 }
 
+/**
+ * Replace the first unescaped '?' in a format string
+ * @param format The format string containing '?' placeholders
+ * @param value The text to substitute for the first '?'
+ * @return Formatted string, or the format itself if nothing is replaced
+ */
+inline std::string replacePlaceholder(std::string format,
+                                      std::string_view value) {
+  const auto ind = format.find('?');
+  if (ind == std::string::npos || (ind != 0 && format[ind - 1] == '\\'))
+      [[unlikely]] {
+    return format;
+  }
+  // Build a new string instead of replace() in place; GCC 12 reports a
+  // false -Wrestrict overlap for the in-place version.
+  std::string result;
+  result.reserve(format.size() - 1 + value.size());
+  result.append(format, 0, ind).append(value).append(format, ind + 1);
+  return result;
+}
+
 /**
  * Format string by replacing first '?' with value
  * @param format The format string containing '?' placeholders
@@ -51,11 +72,7 @@ static inline std::string to_string(const std::vector<T> &vec) {
  */
 template <typename T>
 inline std::string operator%(std::string format, const T &value) {
-  auto ind = format.find('?');
-  if (ind == 0 || format[ind - 1] != '\\') {
-    format.replace(ind, 1U, to_string(value));
-  }
-  return format;
+  return replacePlaceholder(std::move(format), to_string(value));
 }
 
 /**
@@ -65,11 +82,7 @@ inline std::string operator%(std::string format, const T &value) {
  * @return Formatted string with substitution applied
  */
 inline std::string operator%(std::string format, const std::string &value) {
-  auto ind = format.find('?');
-  if (ind == 0 || format[ind - 1] != '\\') {
-    format.replace(ind, 1U, value);
-  }
-  return format;
+  return replacePlaceholder(std::move(format), value);
 }
 
 /**
@@ -79,11 +92,7 @@ inline std::string operator%(std::string format, const std::string &value) {
  * @return Formatted string with substitution applied
  */
 inline std::string operator%(std::string format, const char *value) {
-  auto ind = format.find('?');
-  if (ind == 0 || format[ind - 1] != '\\') {
-    format.replace(ind, 1U, value);
-  }
-  return format;
+  return replacePlaceholder(std::move(format), value);
 }
 
 /**
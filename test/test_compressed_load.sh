@@ -0,0 +1,113 @@
+#!/bin/bash
+
+# Compressed (LTC) table dump / load tests
+
+BUILD_DIR="./build/bin"
+LEMONDB="${LEMONDB:-$BUILD_DIR/lemondb}"
+WORK_DIR="/tmp/lemondb_ltc_test"
+# 49 blocks of 4096 rows, so LOAD decodes the blocks on the thread pool
+ROWS=$((49 * 4096 - 100))
+
+# Color output
+GREEN='\033[0;32m'
+RED='\033[0;31m'
+YELLOW='\033[1;33m'
+NC='\033[0m' # No Color
+
+FAILED=0
+
+echo "=========================================="
+echo "  LemonDB Compressed Table Tests"
+echo "=========================================="
+echo ""
+
+rm -rf "$WORK_DIR"
+mkdir -p "$WORK_DIR"
+python3 - "$WORK_DIR/big.tbl" "$ROWS" <<'EOF'
+import sys
+with open(sys.argv[1], "w") as out:
+    out.write("big 3\nKEY a b\n")
+    for i in range(int(sys.argv[2])):
+        out.write("k%06d %d %d\n" % (i, i, i * 7 % 1000))
+EOF
+
+# Test 1: A compressed dump loads back to the same table
+echo -e "${YELLOW}[Test 1]${NC} DUMP COMPRESSED / LOAD round trip"
+printf 'LOAD %s/big.tbl;\nDUMP big %s/big.ltc COMPRESSED;\nQUIT;\n' \
+    "$WORK_DIR" "$WORK_DIR" > "$WORK_DIR/dump.query"
+printf 'LOAD %s/big.ltc;\nCOUNT ( ) FROM big WHERE ( b >= 0 );\nMAX ( a ) FROM big WHERE ( b >= 0 );\nQUIT;\n' \
+    "$WORK_DIR" > "$WORK_DIR/load.query"
+$LEMONDB --threads 8 < "$WORK_DIR/dump.query" > /dev/null 2>&1
+output=$($LEMONDB --threads 8 < "$WORK_DIR/load.query" 2>/dev/null)
+expected=$(printf '1\n2\nANSWER = %d\n3\nANSWER = ( %d )' \
+    "$ROWS" "$((ROWS - 1))")
+if [ "$output" = "$expected" ]; then
+    echo -e "${GREEN}PASS${NC}"
+else
+    echo -e "${RED}FAIL${NC} - Unexpected output:"
+    echo "$output" | head -5
+    ((FAILED++))
+fi
+echo ""
+
+# Test 2: A corrupt block fails the LOAD while the other blocks still decode
+echo -e "${YELLOW}[Test 2]${NC} LOAD of a corrupt multi-block file on the thread pool"
+python3 - "$WORK_DIR/big.ltc" "$WORK_DIR/corrupt.ltc" <<'EOF'
+import sys
+
+data = bytearray(open(sys.argv[1], "rb").read())
+pos = 4
+
+def varint():
+    global pos
+    value = shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value
+
+def skip():
+    global pos
+    length = varint()
+    pos += length
+
+skip()  # table name
+for _ in range(varint()):  # field names
+    skip()
+varint()  # total rows
+blocks = varint()
+assert blocks > 2, blocks
+for block in range(blocks):
+    size = varint()
+    varint()  # rows
+    if block == 1:
+        # The first key of a block shares no prefix with a previous key
+        data[pos] = 0x05
+    pos += size
+open(sys.argv[2], "wb").write(data)
+EOF
+# The corrupt LOAD fails alone: no table is created, and the good file still
+# loads afterwards
+printf 'LOAD %s/corrupt.ltc;\nCOUNT ( ) FROM big;\nLOAD %s/big.ltc;\nCOUNT ( ) FROM big;\nQUIT;\n' \
+    "$WORK_DIR" "$WORK_DIR" > "$WORK_DIR/corrupt.query"
+output=$($LEMONDB --threads 8 < "$WORK_DIR/corrupt.query" 2>/dev/null)
+exit_code=$?
+expected=$(printf '1\n2\n3\n4\nANSWER = %d' "$ROWS")
+if [ $exit_code -eq 0 ] && [ "$output" = "$expected" ]; then
+    echo -e "${GREEN}PASS${NC}"
+else
+    echo -e "${RED}FAIL${NC} - Exit code $exit_code, output:"
+    echo "$output" | head -5
+    ((FAILED++))
+fi
+echo ""
+
+rm -rf "$WORK_DIR"
+
+echo "=========================================="
+echo "  All Tests Completed"
+echo "=========================================="
+exit $FAILED
@@ -0,0 +1,50 @@
+#!/bin/bash
+
+# EXPLAIN / PROFILE parsing tests
+
+BUILD_DIR="./build/bin"
+LEMONDB="${LEMONDB:-$BUILD_DIR/lemondb}"
+WORK_DIR="/tmp/lemondb_explain_test"
+
+# Color output
+GREEN='\033[0;32m'
+RED='\033[0;31m'
+YELLOW='\033[1;33m'
+NC='\033[0m' # No Color
+
+FAILED=0
+
+echo "=========================================="
+echo "  LemonDB EXPLAIN / PROFILE Tests"
+echo "=========================================="
+echo ""
+
+rm -rf "$WORK_DIR"
+mkdir -p "$WORK_DIR"
+printf 'foo 2\nKEY a\nk1 1\nk2 2\n' > "$WORK_DIR/x.tbl"
+printf 'bar 2\nKEY a\nz 1\n' > "$WORK_DIR/y.tbl"
+
+# Test 1: A rejected EXPLAIN DUMP / PROFILE LOAD leaves the file -> table
+# mapping alone, so the LOAD after it stays ordered with the queries on foo
+echo -e "${YELLOW}[Test 1]${NC} Rejected EXPLAIN DUMP / PROFILE LOAD"
+printf 'LOAD %s/y.tbl;\nEXPLAIN DUMP bar %s/x.tbl;\nPROFILE LOAD %s/x.tbl;\nLOAD %s/x.tbl;\nCOUNT ( ) FROM foo;\nQUIT;\n' \
+    "$WORK_DIR" "$WORK_DIR" "$WORK_DIR" "$WORK_DIR" > "$WORK_DIR/rejected.query"
+expected=$(printf '1\n2\n3\nANSWER = 2')
+for threads in 1 8; do
+    output=$($LEMONDB --threads $threads < "$WORK_DIR/rejected.query" 2>/dev/null)
+    if [ "$output" = "$expected" ]; then
+        echo -e "  -t $threads: ${GREEN}PASS${NC}"
+    else
+        echo -e "  -t $threads: ${RED}FAIL${NC} - Unexpected output:"
+        echo "$output" | head -5
+        ((FAILED++))
+    fi
+done
+echo ""
+
+rm -rf "$WORK_DIR"
+
+echo "=========================================="
+echo "  All Tests Completed"
+echo "=========================================="
+exit $FAILED